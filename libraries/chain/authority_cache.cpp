@@ -0,0 +1,64 @@
+#include <golos/chain/authority_cache.hpp>
+
+namespace golos { namespace chain {
+
+    const authority &authority_cache::get(const account_authority_object &auth, level_type level) {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        auto itr = _entries.find(key_type(auth.account, level));
+        if (itr != _entries.end() && itr->second.revision == auth.revision) {
+            ++_hits;
+            return itr->second.value;
+        }
+        ++_misses;
+
+        const shared_authority *value = nullptr;
+        switch (level) {
+            case authority::owner:
+                value = &auth.owner;
+                break;
+            case authority::active:
+                value = &auth.active;
+                break;
+            case authority::posting:
+                value = &auth.posting;
+                break;
+            default:
+                FC_ASSERT(false, "Unknown authority level ${l}", ("l", level));
+        }
+
+        auto &e = itr != _entries.end() ? itr->second : _entries[key_type(auth.account, level)];
+        e.value = *value;
+        e.revision = auth.revision;
+        return e.value;
+    }
+
+    void authority_cache::on_change(const account_authority_object &auth) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries.erase(
+            _entries.lower_bound(key_type(auth.account, authority::owner)),
+            _entries.upper_bound(key_type(auth.account, authority::posting)));
+    }
+
+    void authority_cache::trim() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_entries.size() > max_size) {
+            _entries.clear();
+        }
+    }
+
+    void authority_cache::clear() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _entries.clear();
+    }
+
+    authority_cache_statistics authority_cache::get_statistics() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        authority_cache_statistics result;
+        result.size = _entries.size();
+        result.hits = _hits;
+        result.misses = _misses;
+        return result;
+    }
+
+} } // golos::chain
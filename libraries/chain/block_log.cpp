@@ -17,6 +17,8 @@ namespace golos { namespace chain {
         public:
             optional<signed_block> head;
             block_id_type head_id;
+            /// the head was appended in the packed form and isn't read yet
+            bool head_is_stale = false;
 
             std::string block_path;
             std::string index_path;
@@ -69,7 +71,7 @@ namespace golos { namespace chain {
             }
 
             uint64_t get_block_pos(uint32_t block_num) const {
-                if (head.valid() &&
+                if (head_id != block_id_type() &&
                     block_num <= protocol::block_header::num_from_id(head_id) &&
                     block_num > 0
                 ) {
@@ -207,14 +209,21 @@ namespace golos { namespace chain {
                 }
             } FC_LOG_AND_RETHROW() }
 
-            uint64_t append(const signed_block& b, const std::vector<char>& data) { try {
+            uint64_t append(const signed_block& b, const std::vector<char>& data) {
+                auto block_pos = append(b.id(), b.block_num(), data);
+                head = b;
+                head_is_stale = false;
+                return block_pos;
+            }
+
+            uint64_t append(const block_id_type& id, uint32_t block_num, const std::vector<char>& data) { try {
                 const auto index_pos = get_mapped_size(index_mapped_file);
 
-                GOLOS_CHECK_DATABASE(index_pos == sizeof(uint64_t) * (b.block_num() - 1),
+                GOLOS_CHECK_DATABASE(index_pos == sizeof(uint64_t) * (block_num - 1),
                     database_corrupted::append_index_file_at_wrong_position,
                     "Append to index file occuring at wrong position.",
                     ("position", index_pos)
-                    ("expected", (b.block_num() - 1) * sizeof(uint64_t)));
+                    ("expected", (block_num - 1) * sizeof(uint64_t)));
 
                 uint64_t block_pos = get_mapped_size(block_mapped_file);
 
@@ -228,16 +237,25 @@ namespace golos { namespace chain {
                 ptr = index_mapped_file.data() + index_pos;
                 *reinterpret_cast<uint64_t*>(ptr) = block_pos;
 
-                head = b;
-                head_id = b.id();
+                head.reset();
+                head_id = id;
+                head_is_stale = true;
                 return block_pos;
             } FC_LOG_AND_RETHROW() }
 
+            void read_stale_head() {
+                if (head_is_stale) {
+                    head = read_head();
+                    head_is_stale = false;
+                }
+            }
+
             void close() {
                 block_mapped_file.close();
                 index_mapped_file.close();
                 head.reset();
                 head_id = block_id_type();
+                head_is_stale = false;
             }
         };
     }
@@ -271,6 +289,16 @@ namespace golos { namespace chain {
         return my->append(block, data);
     } FC_LOG_AND_RETHROW() }
 
+    uint64_t block_log::append(const signed_block& block, const std::vector<char>& packed) { try {
+        detail::write_lock lock(my->mutex);
+        return my->append(block, packed);
+    } FC_LOG_AND_RETHROW() }
+
+    uint64_t block_log::append(const block_id_type& id, uint32_t block_num, const std::vector<char>& packed) { try {
+        detail::write_lock lock(my->mutex);
+        return my->append(id, block_num, packed);
+    } FC_LOG_AND_RETHROW() }
+
     void block_log::flush() {
         // it isn't needed, because all data is already in page cache
     }
@@ -309,7 +337,19 @@ namespace golos { namespace chain {
     }
 
     const optional<signed_block>& block_log::head() const {
-        detail::read_lock lock(my->mutex);
+        {
+            detail::read_lock lock(my->mutex);
+            if (!my->head_is_stale) {
+                return my->head;
+            }
+        }
+        detail::write_lock lock(my->mutex);
+        my->read_stale_head();
         return my->head;
     }
+
+    block_id_type block_log::head_id() const {
+        detail::read_lock lock(my->mutex);
+        return my->head_id;
+    }
 } } // golos::chain
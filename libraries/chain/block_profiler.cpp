@@ -0,0 +1,199 @@
+#include <golos/chain/block_profiler.hpp>
+
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace golos { namespace chain {
+
+    block_profiler::scope::scope(block_profiler *profiler, stage *s)
+            : _profiler(profiler), _stage(s) {
+        if (_stage) {
+            _start = fc::time_point::now();
+        }
+    }
+
+    block_profiler::scope::scope(scope &&other)
+            : _profiler(other._profiler), _stage(other._stage), _start(other._start) {
+        other._stage = nullptr;
+    }
+
+    block_profiler::scope::~scope() {
+        if (_stage) {
+            _profiler->add(*_stage, (fc::time_point::now() - _start).count());
+        }
+    }
+
+    void block_profiler::enable(uint32_t window, fc::microseconds slow_block_time) {
+        _enabled = true;
+        _window = std::max(window, 1u);
+        _slow_block_time = slow_block_time;
+    }
+
+    void block_profiler::disable() {
+        _enabled = false;
+        _current_stage = nullptr;
+        _block_start = fc::time_point();
+    }
+
+    block_profiler::stage &block_profiler::get_stage(const std::string &name) {
+        auto itr = _stages.find(name);
+        if (itr == _stages.end()) {
+            itr = _stages.emplace(name, stage()).first;
+            itr->second.name = name;
+        }
+        return itr->second;
+    }
+
+    void block_profiler::add(stage &s, int64_t usec) {
+        // bucket N keeps times in [2^(N-1), 2^N) microseconds
+        size_t bucket = 0;
+        for (auto v = usec; v > 0 && bucket + 1 < bucket_count; v >>= 1) {
+            ++bucket;
+        }
+
+        auto &g = s.generations[_generation];
+        ++g.buckets[bucket];
+        ++g.count;
+        g.total += usec;
+        g.max = std::max(g.max, usec);
+
+        if (_block_start != fc::time_point()) {
+            if (!s.block_count) {
+                _block_stages.push_back(&s);
+            }
+            ++s.block_count;
+            s.block_time += usec;
+        }
+    }
+
+    void block_profiler::switch_stage(const char *name) {
+        auto now = fc::time_point::now();
+        if (_current_stage) {
+            add(*_current_stage, (now - _stage_start).count());
+        }
+        _current_stage = name ? &get_stage(std::string("stage:") + name) : nullptr;
+        _stage_start = now;
+    }
+
+    void block_profiler::start_block(uint32_t block_num) {
+        if (!_enabled) {
+            return;
+        }
+
+        for (auto *s: _block_stages) {
+            s->block_time = 0;
+            s->block_count = 0;
+        }
+        _block_stages.clear();
+        _current_stage = nullptr;
+
+        if (++_blocks_in_generation > _window) {
+            _generation = (_generation + 1) % 2;
+            _blocks_in_generation = 1;
+            for (auto &s: _stages) {
+                s.second.generations[_generation] = generation();
+            }
+        }
+
+        _block_num = block_num;
+        _block_start = fc::time_point::now();
+    }
+
+    void block_profiler::end_block() {
+        if (!_enabled || _block_start == fc::time_point()) {
+            return;
+        }
+
+        switch_stage(nullptr);
+        auto time = fc::time_point::now() - _block_start;
+        _block_start = fc::time_point();
+
+        if (time < _slow_block_time) {
+            return;
+        }
+
+        slow_block_report report;
+        report.block_num = _block_num;
+        report.time = time;
+        for (const auto *s: _block_stages) {
+            report.stages.push_back({s->name, s->block_count, fc::microseconds(s->block_time)});
+        }
+        std::sort(report.stages.begin(), report.stages.end(), [](const auto &a, const auto &b) {
+            return a.time > b.time;
+        });
+
+        std::stringstream top;
+        for (size_t i = 0; i < report.stages.size() && i < 5; ++i) {
+            top << (i ? ", " : "") << report.stages[i].name << " " << report.stages[i].time.count() / 1000 << "ms";
+        }
+        wlog("Block ${n} was applied in ${t}ms: ${top}",
+            ("n", report.block_num)("t", time.count() / 1000)("top", top.str()));
+
+        _slow_blocks.push_back(std::move(report));
+        if (_slow_blocks.size() > max_slow_blocks) {
+            _slow_blocks.pop_front();
+        }
+    }
+
+    std::vector<profiler_stage_statistics> block_profiler::get_statistics() const {
+        std::vector<profiler_stage_statistics> result;
+        result.reserve(_stages.size());
+
+        for (const auto &itr: _stages) {
+            const auto &s = itr.second;
+            generation g;
+            for (const auto &sg: s.generations) {
+                for (size_t i = 0; i < bucket_count; ++i) {
+                    g.buckets[i] += sg.buckets[i];
+                }
+                g.count += sg.count;
+                g.total += sg.total;
+                g.max = std::max(g.max, sg.max);
+            }
+            if (!g.count) {
+                continue;
+            }
+
+            profiler_stage_statistics stat;
+            stat.name = s.name;
+            stat.count = g.count;
+            stat.total = fc::microseconds(g.total);
+            stat.max = fc::microseconds(g.max);
+
+            auto percentile = [&](uint64_t p) {
+                uint64_t rank = (g.count * p + 99) / 100;
+                uint64_t seen = 0;
+                for (size_t i = 0; i < bucket_count; ++i) {
+                    seen += g.buckets[i];
+                    if (seen >= rank) {
+                        return fc::microseconds(std::min<int64_t>(i ? int64_t(1) << i : 0, g.max));
+                    }
+                }
+                return stat.max;
+            };
+            stat.p50 = percentile(50);
+            stat.p90 = percentile(90);
+            stat.p99 = percentile(99);
+
+            result.push_back(std::move(stat));
+        }
+        return result;
+    }
+
+    std::vector<slow_block_report> block_profiler::get_slow_blocks() const {
+        return std::vector<slow_block_report>(_slow_blocks.begin(), _slow_blocks.end());
+    }
+
+    void block_profiler::reset() {
+        _stages.clear();
+        _block_stages.clear();
+        _current_stage = nullptr;
+        _block_start = fc::time_point();
+        _generation = 0;
+        _blocks_in_generation = 0;
+        _slow_blocks.clear();
+    }
+
+} } // golos::chain
@@ -32,6 +32,13 @@
 #include <csignal>
 #include <cerrno>
 #include <cstring>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <unistd.h>
+#ifdef __linux__
+#include <fcntl.h>
+#endif
 
 #define VIRTUAL_SCHEDULE_LAP_LENGTH  ( fc::uint128_t(uint64_t(-1)) )
 #define VIRTUAL_SCHEDULE_LAP_LENGTH2 ( fc::uint128_t::max_value() )
@@ -67,6 +74,17 @@ namespace golos { namespace chain {
         using std::sig_atomic_t;
         using boost::container::flat_set;
 
+        struct operation_name_visitor {
+            typedef std::string result_type;
+
+            template<typename T>
+            std::string operator()(const T &) const {
+                std::string name = fc::get_typename<T>::name();
+                auto pos = name.rfind(':');
+                return pos == std::string::npos ? name : name.substr(pos + 1);
+            }
+        };
+
         inline u256 to256(const fc::uint128_t &t) {
             u256 v(t.hi);
             v <<= 64;
@@ -192,10 +210,12 @@ namespace golos { namespace chain {
                 wlog("Start opening database. Please wait, don't break application...");
 
                 init_schema();
-                chainbase::database::open(shared_mem_dir, chainbase_flags, shared_file_size);
+                open_shared_memory(shared_mem_dir, chainbase_flags, shared_file_size);
 
                 initialize_indexes();
                 initialize_evaluators();
+                initialize_maintenance_tasks();
+                _authority_cache.clear();
 
                 auto end = fc::time_point::now();
                 wlog("Done opening database, elapsed time ${t} sec", ("t", double((end - start).count()) / 1000000.0));
@@ -240,6 +260,10 @@ namespace golos { namespace chain {
                     }
                     end = fc::time_point::now();
                     wlog("Done opening block log, elapsed time ${t} sec", ("t", double((end - start).count()) / 1000000.0));
+
+                    with_strong_write_lock([&]() {
+                        initialize_state_digest();
+                    });
                 }
 
                 with_strong_read_lock([&]() {
@@ -333,6 +357,94 @@ namespace golos { namespace chain {
 
         }
 
+        void database::set_operation_source(operation_source source) {
+            _operation_source = std::move(source);
+        }
+
+        void database::add_operation_consumer(
+            const std::string &plugin, std::function<void()> clear, operation_handler apply
+        ) {
+            _operation_consumers[plugin] = operation_consumer{std::move(clear), std::move(apply)};
+        }
+
+        void database::reindex_plugins(const std::vector<std::string> &plugins) {
+            try {
+                FC_ASSERT(_operation_source,
+                    "Reindex of plugins requires all operations stored by operation_history plugin, enable it "
+                    "without history-whitelist-ops, history-blacklist-ops, history-start-block and history-blocks");
+
+                std::vector<const operation_consumer *> consumers;
+                for (const auto &plugin: plugins) {
+                    auto itr = _operation_consumers.find(plugin);
+                    FC_ASSERT(itr != _operation_consumers.end(),
+                        "Plugin ${p} isn't enabled or can't be reindexed from operations, replay the blockchain",
+                        ("p", plugin));
+                    consumers.push_back(&itr->second);
+                }
+
+                ilog("Reindexing plugins ${p} from stored operations...", ("p", plugins));
+                auto start = fc::time_point::now();
+
+                with_strong_write_lock([&]() {
+                    // the state digest is shared by all indexes, so it's computed again after the plugins
+                    auto state_digest = _state_digest;
+                    _state_digest = false;
+
+                    // objects aren't copied to undo sessions here, so they shouldn't be counted
+                    auto undo_profiling = _undo_profiling;
+                    _undo_profiling = false;
+
+                    std::exception_ptr error;
+                    try {
+                        for (const auto *consumer: consumers) {
+                            consumer->clear();
+
+                            // the resize remaps the shared memory, so the source is stopped before it and resumed
+                            uint32_t from_block = 0;
+                            bool low_memory = false;
+                            do {
+                                low_memory = false;
+                                uint32_t block_num = from_block;
+                                _operation_source(from_block, [&](const operation_notification &note) {
+                                    if (note.block != block_num) {
+                                        if (_inc_shared_memory_size != 0 && _min_free_shared_memory_size != 0 &&
+                                            free_memory() < _min_free_shared_memory_size
+                                        ) {
+                                            from_block = note.block;
+                                            low_memory = true;
+                                            return false;
+                                        }
+                                        block_num = note.block;
+                                    }
+                                    consumer->apply(note);
+                                    return true;
+                                });
+
+                                if (low_memory) {
+                                    _resize(from_block, _inc_shared_memory_size);
+                                }
+                            } while (low_memory);
+                        }
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+
+                    _undo_profiling = undo_profiling;
+                    _state_digest = state_digest;
+                    if (_state_digest) {
+                        rebuild_state_digest();
+                    }
+
+                    if (error) {
+                        std::rethrow_exception(error);
+                    }
+                });
+
+                ilog("Done reindexing plugins, elapsed time: ${t} sec",
+                    ("t", double((fc::time_point::now() - start).count()) / 1000000.0));
+            } FC_CAPTURE_AND_RETHROW((plugins))
+        }
+
         void database::set_min_free_shared_memory_size(size_t value) {
             _min_free_shared_memory_size = value;
         }
@@ -345,6 +457,156 @@ namespace golos { namespace chain {
             _block_num_check_free_memory = value;
         }
 
+        void database::set_shared_memory_growth_horizon(uint32_t blocks) {
+            _shared_memory_growth_horizon = blocks;
+        }
+
+        void database::set_shared_memory_preallocation(bool value) {
+            _preallocate_shared_memory = value;
+        }
+
+        void database::set_shared_memory_policy(const shared_memory_policy &policy) {
+            _shared_memory_policy = policy;
+        }
+
+        void database::open_shared_memory(const fc::path &shared_mem_dir, uint32_t chainbase_flags, uint64_t shared_file_size) {
+            _shared_memory_policy.check_shared_memory_dir(shared_mem_dir, shared_file_size);
+
+            chainbase::database::open(shared_mem_dir, chainbase_flags, shared_file_size);
+            _shared_mem_dir = shared_mem_dir;
+
+            apply_shared_memory_policy();
+
+            auto marker_file = _shared_mem_dir / "shared_memory.flush";
+            if (fc::exists(marker_file)) {
+                auto marker = fc::json::from_file(marker_file).as<state_flush_marker>();
+                ilog("Shared memory was fully flushed at block ${n} (${t})", ("n", marker.block_num)("t", marker.time));
+            }
+
+            if ((chainbase_flags & chainbase::database::read_write) && _flush_blocks && _flush_state_rate) {
+                _flushed_state_pass = 0;
+                _state_flusher.start([this]() {
+                    state_flusher::region r;
+                    auto page_size = uint64_t(::sysconf(_SC_PAGESIZE));
+                    r.addr = reinterpret_cast<char *>(reinterpret_cast<uintptr_t>(get_segment_manager()) & ~(page_size - 1));
+                    r.size = max_memory();
+                    return r;
+                }, 16 * 1024 * 1024, _flush_state_rate);
+            }
+        }
+
+        void database::apply_shared_memory_policy() {
+            _shared_memory_policy.apply_to_mapping(get_segment_manager());
+        }
+
+        const shared_memory_resize_statistics &database::get_shared_memory_resize_statistics() const {
+            return _resize_statistics;
+        }
+
+        void database::set_undo_profiling(bool value) {
+            _undo_profiling = value;
+            _undo_copied_objects.clear();
+        }
+
+        bool database::undo_profiling() const {
+            return _undo_profiling;
+        }
+
+        std::vector<undo_operation_statistics> database::get_undo_statistics() const {
+            std::vector<undo_operation_statistics> result;
+            for (const auto &stat: _undo_statistics) {
+                if (stat.count || stat.created || stat.modified || stat.removed) {
+                    result.push_back(stat);
+                }
+            }
+            return result;
+        }
+
+        void database::reset_undo_statistics() {
+            _undo_statistics.clear();
+            _undo_copied_objects.clear();
+        }
+
+        database::session database::start_undo_session() {
+            auto session = chainbase::database::start_undo_session();
+            // sessions, which had the same revision, are ended
+            if (!_undo_copied_objects.empty()) {
+                _undo_copied_objects.erase(_undo_copied_objects.lower_bound(revision()), _undo_copied_objects.end());
+            }
+            return session;
+        }
+
+        block_profiler &database::get_block_profiler() {
+            return _block_profiler;
+        }
+
+        const block_profiler &database::get_block_profiler() const {
+            return _block_profiler;
+        }
+
+        void database::set_operation_cost_accounting(bool value) {
+            _operation_costs.enable(value);
+        }
+
+        std::vector<operation_cost_statistics> database::get_operation_cost_statistics() const {
+            std::vector<operation_cost_statistics> result;
+            std::vector<int64_t> operation_time(operation::count());
+
+            const auto &consumers = _operation_costs.consumers();
+            for (size_t c = 0; c < consumers.size(); ++c) {
+                const auto &costs = _operation_costs.costs(c);
+                for (size_t op = 0; op < costs.size(); ++op) {
+                    operation_time[op] += costs[op].time;
+                }
+            }
+
+            for (size_t c = 0; c < consumers.size(); ++c) {
+                const auto &costs = _operation_costs.costs(c);
+                for (size_t op = 0; op < costs.size(); ++op) {
+                    if (!costs[op].count) {
+                        continue;
+                    }
+
+                    operation o;
+                    o.set_which(op);
+
+                    operation_cost_statistics stat;
+                    stat.operation = o.visit(operation_name_visitor());
+                    stat.consumer = consumers[c];
+                    stat.count = costs[op].count;
+                    stat.time = fc::microseconds(costs[op].time);
+                    if (operation_time[op]) {
+                        stat.share = uint16_t(costs[op].time * STEEMIT_100_PERCENT / operation_time[op]);
+                    }
+                    result.push_back(std::move(stat));
+                }
+            }
+            return result;
+        }
+
+        void database::reset_operation_cost_statistics() {
+            _operation_costs.reset();
+        }
+
+        undo_operation_statistics &database::current_undo_statistics() {
+            if (_undo_statistics.empty()) {
+                _undo_statistics.resize(operation::count() + 1);
+                _undo_statistics[0].operation = "block";
+            }
+            return _undo_statistics[_current_undo_operation];
+        }
+
+        bool database::is_first_undo_copy(uint16_t type_id, int64_t id) {
+            // sessions above the current one are ended, sessions far below it become current
+            //   only when blocks are popped, so they aren't kept
+            constexpr int64_t tracked_sessions = 4;
+            auto rev = revision();
+            auto &sessions = _undo_copied_objects;
+            sessions.erase(sessions.upper_bound(rev), sessions.end());
+            sessions.erase(sessions.begin(), sessions.lower_bound(rev - tracked_sessions));
+            return sessions[rev].emplace(type_id, id).second;
+        }
+
 
         void database::set_store_account_metadata(store_metadata_modes store_account_metadata) {
             _store_account_metadata = store_account_metadata;
@@ -370,23 +632,157 @@ namespace golos { namespace chain {
             return _store_memo_in_savings_withdraws;
         }
 
+        void database::set_comment_cashout_threads(uint32_t threads) {
+            _comment_cashout_threads = threads;
+        }
+
+        void database::set_maintenance_scheduler(bool value) {
+            _maintenance.set_enabled(value);
+        }
+
+        std::vector<maintenance_task_statistics> database::get_maintenance_statistics() const {
+            return _maintenance.get_statistics();
+        }
+
+        void database::set_transaction_check_threads(uint32_t threads) {
+            _transaction_checker.set_threads(threads);
+        }
+
+        transaction_check_statistics database::get_transaction_check_statistics() const {
+            return _transaction_checker.get_statistics();
+        }
+
+        void database::initialize_maintenance_tasks() {
+            auto enabled = _maintenance.enabled();
+            _maintenance = maintenance_scheduler();
+            _maintenance.set_enabled(enabled);
+
+            // deadline of the first object in the index or never
+            auto first = [](const auto &idx, auto getter) {
+                return idx.empty() ? time_point_sec::maximum() : time_point_sec(getter(*idx.begin()));
+            };
+
+            auto task = _maintenance.add_task("clear_expired_proposals", [=]() {
+                return first(get_index<proposal_index, by_expiration>(), [](const auto &o) {
+                    return o.expiration_time;
+                });
+            });
+            FC_ASSERT(task == expired_proposals_task);
+            _maintenance.track<proposal_object>(task, [](const auto &o) {return o.expiration_time;});
+
+            task = _maintenance.add_task("clear_expired_orders", [=]() {
+                return first(get_index<limit_order_index, by_expiration>(), [](const auto &o) {
+                    return o.expiration;
+                });
+            });
+            FC_ASSERT(task == expired_orders_task);
+            _maintenance.track<limit_order_object>(task, [](const auto &o) {return o.expiration;});
+
+            task = _maintenance.add_task("clear_expired_delegations", [=]() {
+                return first(get_index<vesting_delegation_expiration_index, by_expiration>(), [](const auto &o) {
+                    return o.expiration;
+                });
+            });
+            FC_ASSERT(task == expired_delegations_task);
+            _maintenance.track<vesting_delegation_expiration_object>(task, [](const auto &o) {return o.expiration;});
+
+            task = _maintenance.add_task("process_conversions", [=]() {
+                return first(get_index<convert_request_index, by_conversion_date>(), [](const auto &o) {
+                    return o.conversion_date;
+                });
+            });
+            FC_ASSERT(task == conversions_task);
+            _maintenance.track<convert_request_object>(task, [](const auto &o) {return o.conversion_date;});
+
+            task = _maintenance.add_task("process_savings_withdraws", [=]() {
+                return first(get_index<savings_withdraw_index, by_complete_from_rid>(), [](const auto &o) {
+                    return o.complete;
+                });
+            });
+            FC_ASSERT(task == savings_withdraws_task);
+            _maintenance.track<savings_withdraw_object>(task, [](const auto &o) {return o.complete;});
+
+            auto history_deadline = [](const owner_authority_history_object &o) {
+                return time_point_sec(o.last_valid_time + STEEMIT_OWNER_AUTH_RECOVERY_PERIOD);
+            };
+            task = _maintenance.add_task("account_recovery_processing", [=]() {
+                return std::min({
+                    first(get_index<account_recovery_request_index, by_expiration>(), [](const auto &o) {
+                        return o.expires;
+                    }),
+                    first(get_index<owner_authority_history_index>().indices(), history_deadline),
+                    first(get_index<change_recovery_account_request_index, by_effective_date>(), [](const auto &o) {
+                        return o.effective_on;
+                    })
+                });
+            });
+            FC_ASSERT(task == account_recovery_task);
+            _maintenance.track<account_recovery_request_object>(task, [](const auto &o) {return o.expires;});
+            _maintenance.track<owner_authority_history_object>(task, history_deadline);
+            _maintenance.track<change_recovery_account_request_object>(task, [](const auto &o) {return o.effective_on;});
+
+            task = _maintenance.add_task("expire_escrow_ratification", [=]() {
+                const auto &idx = get_index<escrow_index, by_ratification_deadline>();
+                auto itr = idx.lower_bound(false);
+                return itr == idx.end() ? time_point_sec::maximum() : itr->ratification_deadline;
+            });
+            FC_ASSERT(task == escrow_ratification_task);
+            // approval of an escrow can only postpone its expiration, so its deadline is kept
+            _maintenance.track<escrow_object>(task, [](const auto &o) {return o.ratification_deadline;});
+
+            task = _maintenance.add_task("process_decline_voting_rights", [=]() {
+                return first(get_index<decline_voting_rights_request_index, by_effective_date>(), [](const auto &o) {
+                    return o.effective_date;
+                });
+            });
+            FC_ASSERT(task == decline_voting_rights_task);
+            _maintenance.track<decline_voting_rights_request_object>(task, [](const auto &o) {return o.effective_date;});
+        }
+
+        void database::run_maintenance_task(maintenance_task task, void (database::*process)()) {
+            if (!_maintenance.is_due(task, head_block_time())) {
+                return;
+            }
+            (this->*process)();
+            auto profile = _block_profiler.measure(_maintenance.probe_stage(task));
+            _maintenance.update_deadline(task);
+        }
+
         void database::set_skip_virtual_ops() {
             _skip_virtual_ops = true;
         }
 
-        bool database::_resize(uint32_t current_block_num) {
+        bool database::_resize(uint32_t current_block_num, uint64_t inc_size) {
             if (_inc_shared_memory_size == 0) {
                 elog("Auto-scaling of shared file size is not configured!. Do it immediately!");
                 return false;
             }
 
+            wait_shared_memory_preallocation();
+
             uint64_t max_mem = max_memory();
 
-            size_t new_max = max_mem + _inc_shared_memory_size;
+            // the size of a file on hugetlbfs should be a multiple of the huge page size
+            size_t new_max = _shared_memory_policy.align_size(max_mem + std::max<uint64_t>(inc_size, _inc_shared_memory_size));
             wlog(
                 "Memory is almost full on block ${block}, increasing to ${mem}M",
                 ("block", current_block_num)("mem", new_max / (1024 * 1024)));
-            resize(new_max);
+
+            auto start = fc::time_point::now();
+            {
+                auto pause_flusher = _state_flusher.pause();
+                resize(new_max);
+                apply_shared_memory_policy();
+            }
+            auto elapsed = fc::time_point::now() - start;
+
+            auto &stats = _resize_statistics;
+            stats.resize_count++;
+            stats.total_resize_time += elapsed;
+            stats.max_resize_time = std::max(stats.max_resize_time, elapsed);
+            stats.last_resize_time = elapsed;
+            stats.last_resize_block_num = current_block_num;
+            stats.preallocated_size = 0;
 
             uint64_t free_mem = free_memory();
             uint64_t reserved_mem = reserved_memory();
@@ -397,11 +793,52 @@ namespace golos { namespace chain {
 
             uint32_t free_mb = uint32_t(free_mem / (1024 * 1024));
             uint32_t reserved_mb = uint32_t(reserved_mem / (1024 * 1024));
-            wlog("Free memory is now ${free}M (${reserved}M)", ("free", free_mb)("reserved", reserved_mb));
+            wlog(
+                "Free memory is now ${free}M (${reserved}M), resize took ${t} sec",
+                ("free", free_mb)("reserved", reserved_mb)("t", double(elapsed.count()) / 1000000.0));
             _last_free_gb_printed = free_mb / 1024;
             return true;
         }
 
+        void database::preallocate_shared_memory(uint64_t size) {
+            if (_shared_memory_preallocation.valid() || _shared_mem_dir.empty() ||
+                _resize_statistics.preallocated_size >= size
+            ) {
+                return;
+            }
+
+            auto file = (_shared_mem_dir / "shared_memory.bin").string();
+            uint64_t offset = max_memory();
+
+            _resize_statistics.preallocated_size = size;
+            _shared_memory_preallocation = std::async(std::launch::async, [file, offset, size]() {
+#ifdef __linux__
+                // space beyond the end of the file is reserved without changing its size,
+                //   so the next resize only extends the file over the allocated blocks
+                int fd = ::open(file.c_str(), O_RDWR);
+                if (fd < 0) {
+                    wlog("Can't open ${file} to preallocate shared memory: ${e}", ("file", file)("e", std::strerror(errno)));
+                    return;
+                }
+                auto start = fc::time_point::now();
+                if (::fallocate(fd, FALLOC_FL_KEEP_SIZE, offset, size) != 0) {
+                    wlog("Can't preallocate shared memory: ${e}", ("e", std::strerror(errno)));
+                } else {
+                    ilog(
+                        "Preallocated ${mem}M of shared memory in ${t} sec",
+                        ("mem", size / (1024 * 1024))("t", double((fc::time_point::now() - start).count()) / 1000000.0));
+                }
+                ::close(fd);
+#endif
+            });
+        }
+
+        void database::wait_shared_memory_preallocation() {
+            if (_shared_memory_preallocation.valid()) {
+                _shared_memory_preallocation.get();
+            }
+        }
+
         void database::check_free_memory(bool skip_print, uint32_t current_block_num) {
             if (0 != current_block_num % _block_num_check_free_memory) {
                 return;
@@ -416,10 +853,33 @@ namespace golos { namespace chain {
                 set_reserved_memory(0);
             }
 
+            // the growth rate is averaged to predict the memory needed for the next blocks
+            uint64_t used_mem = max_memory() - free_memory();
+            auto &stats = _resize_statistics;
+            if (_last_used_memory_block_num != 0 && current_block_num > _last_used_memory_block_num &&
+                used_mem > _last_used_memory
+            ) {
+                uint64_t per_block = (used_mem - _last_used_memory) / (current_block_num - _last_used_memory_block_num);
+                stats.used_memory_per_block = stats.used_memory_per_block
+                    ? (stats.used_memory_per_block * 3 + per_block) / 4
+                    : per_block;
+            }
+            _last_used_memory = used_mem;
+            _last_used_memory_block_num = current_block_num;
+
+            uint64_t expected_mem = uint64_t(stats.used_memory_per_block) * _shared_memory_growth_horizon;
+            uint64_t min_free_mem = std::max<uint64_t>(_min_free_shared_memory_size, expected_mem);
+            uint64_t inc_mem = std::max<uint64_t>(_inc_shared_memory_size, expected_mem);
+
             if (_inc_shared_memory_size != 0 && _min_free_shared_memory_size != 0 &&
-                free_mem < _min_free_shared_memory_size
+                free_mem < min_free_mem
             ) {
-                _resize(current_block_num);
+                _resize(current_block_num, inc_mem);
+            } else if (_inc_shared_memory_size != 0 && _min_free_shared_memory_size != 0) {
+                // the resize is expected before the next horizon passes
+                if (_preallocate_shared_memory && free_mem < min_free_mem + expected_mem) {
+                    preallocate_shared_memory(inc_mem);
+                }
             } else if (!skip_print && _inc_shared_memory_size == 0 && _min_free_shared_memory_size == 0) {
                 uint32_t free_gb = uint32_t(free_mem / (1024 * 1024 * 1024));
                 if ((free_gb < _last_free_gb_printed) || (free_gb > _last_free_gb_printed + 1)) {
@@ -454,6 +914,9 @@ namespace golos { namespace chain {
                 // DB state (issue #336).
                 clear_pending();
 
+                wait_shared_memory_preallocation();
+                _state_flusher.stop();
+
                 chainbase::database::flush();
                 chainbase::database::close();
 
@@ -537,7 +1000,7 @@ namespace golos { namespace chain {
                     return tmp;
                 }
 
-                return b->data;
+                return b->data();
             } FC_CAPTURE_AND_RETHROW()
         }
 
@@ -547,7 +1010,7 @@ namespace golos { namespace chain {
 
                 auto results = _fork_db.fetch_block_by_number(block_num);
                 if (results.size() == 1) {
-                    b = results[0]->data;
+                    b = results[0]->data();
                 } else {
                     b = _block_log.read_block_by_num(block_num);
                 }
@@ -727,6 +1190,14 @@ namespace golos { namespace chain {
             } FC_CAPTURE_AND_RETHROW((name))
         }
 
+        const authority &database::get_cached_authority(const account_name_type &name, authority::classification level) const {
+            return _authority_cache.get(get_authority(name), level);
+        }
+
+        authority_cache_statistics database::get_authority_cache_statistics() const {
+            return _authority_cache.get_statistics();
+        }
+
         const savings_withdraw_object* database::find_savings_withdraw(const account_name_type& owner, uint32_t request_id) const {
             return find<savings_withdraw_object, by_from_rid>(boost::make_tuple(owner, request_id));
         }
@@ -868,6 +1339,10 @@ namespace golos { namespace chain {
                    (_checkpoints.rbegin()->first >= head_block_num());
         }
 
+        void database::set_checkpoint_trusted_sync(bool value) {
+            _checkpoint_trusted_sync = value;
+        }
+
         uint32_t database::validate_block(const signed_block& new_block, uint32_t skip) {
             uint32_t validate_block_steps =
                 skip_merkle_check |
@@ -969,7 +1444,8 @@ namespace golos { namespace chain {
             if (blocks.size() > 1) {
                 vector<std::pair<account_name_type, fc::time_point_sec>> witness_time_pairs;
                 for (const auto &b : blocks) {
-                    witness_time_pairs.push_back(std::make_pair(b->data.witness, b->data.timestamp));
+                    auto block = b->data();
+                    witness_time_pairs.push_back(std::make_pair(block.witness, block.timestamp));
                 }
 
                 ilog(
@@ -985,16 +1461,16 @@ namespace golos { namespace chain {
                     shared_ptr<fork_item> new_head = _fork_db.push_block(new_block);
                     _maybe_warn_multiple_production(new_head->num);
                     //If the head block from the longest chain does not build off of the current head, we need to switch forks.
-                    if (new_head->data.previous != head_block_id()) {
+                    if (new_head->previous_id() != head_block_id()) {
                         //If the newly pushed block is the same height as head, we get head back in new_head
                         //Only switch forks if new_head is actually higher than head
-                        if (new_head->data.block_num() > head_block_num()) {
+                        if (new_head->num > head_block_num()) {
                             // wlog( "Switching to fork: ${id}", ("id",new_head->data.id()) );
-                            auto branches = _fork_db.fetch_branch_from(new_head->data.id(), head_block_id());
+                            auto branches = _fork_db.fetch_branch_from(new_head->id, head_block_id());
 
                             // pop blocks until we hit the forked block
                             while (head_block_id() !=
-                                   branches.second.back()->data.previous) {
+                                   branches.second.back()->previous_id()) {
                                 pop_block();
                             }
 
@@ -1005,7 +1481,7 @@ namespace golos { namespace chain {
                                 optional<fc::exception> except;
                                 try {
                                     auto session = start_undo_session();
-                                    apply_block((*ritr)->data, skip);
+                                    apply_block((*ritr)->data(), skip);
                                     session.push();
                                 }
                                 catch (const fc::exception &e) {
@@ -1015,14 +1491,14 @@ namespace golos { namespace chain {
                                     // wlog( "exception thrown while switching forks ${e}", ("e",except->to_detail_string() ) );
                                     // remove the rest of branches.first from the fork_db, those blocks are invalid
                                     while (ritr != branches.first.rend()) {
-                                        _fork_db.remove((*ritr)->data.id());
+                                        _fork_db.remove((*ritr)->id);
                                         ++ritr;
                                     }
                                     _fork_db.set_head(branches.second.front());
 
                                     // pop all blocks from the bad fork
                                     while (head_block_id() !=
-                                           branches.second.back()->data.previous) {
+                                           branches.second.back()->previous_id()) {
                                         pop_block();
                                     }
 
@@ -1031,7 +1507,7 @@ namespace golos { namespace chain {
                                          ritr !=
                                          branches.second.rend(); ++ritr) {
                                         auto session = start_undo_session();
-                                        apply_block((*ritr)->data, skip);
+                                        apply_block((*ritr)->data(), skip);
                                         session.push();
                                     }
                                     throw *except;
@@ -1270,9 +1746,11 @@ namespace golos { namespace chain {
 
                 _fork_db.pop_block();
                 undo();
+                pop_state_digest();
 
                 _popped_tx.insert(_popped_tx.begin(), head_block->transactions.begin(), head_block->transactions.end());
 
+                notify_popped_block(*head_block);
             }
             FC_CAPTURE_AND_RETHROW()
         }
@@ -1298,12 +1776,14 @@ namespace golos { namespace chain {
             note.op_in_trx = _current_op_in_trx;
 
             if (!is_producing() || _enable_plugins_on_push_transaction) {
+                auto profile = _block_profiler.measure("signal:pre_apply_operation");
                 STEEMIT_TRY_NOTIFY(pre_apply_operation, note);
             }
         }
 
         void database::notify_post_apply_operation(const operation_notification &note) {
             if (!is_producing() || _enable_plugins_on_push_transaction) {
+                auto profile = _block_profiler.measure("signal:post_apply_operation");
                 STEEMIT_TRY_NOTIFY(post_apply_operation, note);
             }
         }
@@ -1322,9 +1802,14 @@ namespace golos { namespace chain {
         }
 
         void database::notify_applied_block(const signed_block &block) {
+            auto profile = _block_profiler.measure("signal:applied_block");
             STEEMIT_TRY_NOTIFY(applied_block, block)
         }
 
+        void database::notify_popped_block(const signed_block &block) {
+            STEEMIT_TRY_NOTIFY(popped_block, block)
+        }
+
         void database::notify_on_pending_transaction(const signed_transaction &tx) {
             STEEMIT_TRY_NOTIFY(on_pending_transaction, tx)
         }
@@ -1479,6 +1964,13 @@ namespace golos { namespace chain {
             vector<account_name_type> active_witnesses;
             active_witnesses.reserve(STEEMIT_MAX_WITNESSES);
 
+            /// Most of the witnesses keep their schedule type between rounds, they aren't modified then
+            auto set_schedule = [&](const witness_object &w, witness_object::witness_schedule_type schedule) {
+                if (w.schedule != schedule) {
+                    modify(w, [&](witness_object &wo) { wo.schedule = schedule; });
+                }
+            };
+
             /// Add the highest voted witnesses
             flat_set<witness_id_type> selected_voted;
             selected_voted.reserve(STEEMIT_MAX_VOTED_WITNESSES);
@@ -1494,7 +1986,7 @@ namespace golos { namespace chain {
                 }
                 selected_voted.insert(itr->id);
                 active_witnesses.push_back(itr->owner);
-                modify(*itr, [&](witness_object &wo) { wo.schedule = witness_object::top19; });
+                set_schedule(*itr, witness_object::top19);
             }
 
             auto num_elected = active_witnesses.size();
@@ -1511,11 +2003,10 @@ namespace golos { namespace chain {
                 if (selected_voted.find(mitr->id) == selected_voted.end()) {
                     // Only consider a miner who has a valid block signing key
                     if (!(has_hardfork(STEEMIT_HARDFORK_0_14__278) &&
-                          get_witness(mitr->owner).signing_key ==
-                          public_key_type())) {
+                          mitr->signing_key == public_key_type())) {
                         selected_miners.insert(mitr->id);
                         active_witnesses.push_back(mitr->owner);
-                        modify(*mitr, [&](witness_object &wo) { wo.schedule = witness_object::miner; });
+                        set_schedule(*mitr, witness_object::miner);
                     }
                 }
                 // Remove processed miner from the queue
@@ -1553,7 +2044,7 @@ namespace golos { namespace chain {
                 if (selected_miners.find(sitr->id) == selected_miners.end()
                     && selected_voted.find(sitr->id) == selected_voted.end()) {
                     active_witnesses.push_back(sitr->owner);
-                    modify(*sitr, [&](witness_object &wo) { wo.schedule = witness_object::timeshare; });
+                    set_schedule(*sitr, witness_object::timeshare);
                     ++witness_count;
                 }
             }
@@ -1598,7 +2089,7 @@ namespace golos { namespace chain {
                 flat_map<std::tuple<hardfork_version, time_point_sec>, uint32_t> hardfork_version_votes;
 
                 for (uint32_t i = 0; i < wso.num_scheduled_witnesses; i++) {
-                    auto witness = get_witness(wso.current_shuffled_witnesses[i]);
+                    const auto &witness = get_witness(wso.current_shuffled_witnesses[i]);
                     if (witness_versions.find(witness.running_version) ==
                         witness_versions.end()) {
                         witness_versions[witness.running_version] = 1;
@@ -2349,6 +2840,7 @@ namespace golos { namespace chain {
         share_type database::pay_curators(const comment_curation_info& c, share_type max_rewards) {
             try {
                 share_type unclaimed_rewards = max_rewards;
+                const auto permlink = to_string(c.comment.permlink);
 
                 if (c.total_vote_weight > 0 && c.comment.allow_curation_rewards) {
                     uint128_t total_weight(c.total_vote_weight);
@@ -2377,7 +2869,7 @@ namespace golos { namespace chain {
 
                         if (claim > 0) { // min_amt is non-zero satoshis
                             unclaimed_rewards -= claim;
-                            pay_curator(*itr->vote, claim, c.comment.author, to_string(c.comment.permlink));
+                            pay_curator(*itr->vote, claim, c.comment.author, permlink);
                         } else {
                             break;
                         }
@@ -2386,7 +2878,7 @@ namespace golos { namespace chain {
                         // pay needed claim + rest unclaimed tokens (close to zero value) to curator with greates weight
                         // BTW: it has to be unclaimed_rewards.value not heaviest_vote_after_auw_weight + unclaimed_rewards.value, coz
                         //      unclaimed_rewards already contains this.
-                        pay_curator(*heaviest_itr->vote, unclaimed_rewards.value, c.comment.author, to_string(c.comment.permlink));
+                        pay_curator(*heaviest_itr->vote, unclaimed_rewards.value, c.comment.author, permlink);
                         unclaimed_rewards = 0;
                     }
                 }
@@ -2399,7 +2891,7 @@ namespace golos { namespace chain {
                 }
                 // Case: auction window destination is reward fund or there are not curator which can get the auw reward
                 else if (c.comment.auction_window_reward_destination != protocol::to_author && unclaimed_rewards > 0) {
-                    push_virtual_operation(auction_window_reward_operation(asset(unclaimed_rewards, STEEM_SYMBOL), c.comment.author, to_string(c.comment.permlink)));
+                    push_virtual_operation(auction_window_reward_operation(asset(unclaimed_rewards, STEEM_SYMBOL), c.comment.author, permlink));
                     modify(get_dynamic_global_properties(), [&](dynamic_global_property_object &props) {
                         props.total_reward_fund_steem += asset(unclaimed_rewards, STEEM_SYMBOL);
                     });
@@ -2410,7 +2902,7 @@ namespace golos { namespace chain {
             } FC_CAPTURE_AND_RETHROW()
         }
 
-        void database::cashout_comment_helper(const comment_object &comment) {
+        void database::cashout_comment_helper(const comment_object &comment, const comment_curation_info *curation_info) {
             protocol::curation_curve curve = comment.curation_reward_curve;
             try {
                 if (comment.net_rshares > 0) {
@@ -2428,9 +2920,13 @@ namespace golos { namespace chain {
 
                         share_type author_tokens = reward_tokens.to_uint64() - curation_tokens;
 
-                        comment_curation_info curation_info(*this, comment, false);
-                        curve = curation_info.curve;
-                        author_tokens += pay_curators(curation_info, curation_tokens);
+                        std::unique_ptr<comment_curation_info> computed_info;
+                        if (!curation_info) {
+                            computed_info = std::make_unique<comment_curation_info>(*this, comment, false);
+                            curation_info = computed_info.get();
+                        }
+                        curve = curation_info->curve;
+                        author_tokens += pay_curators(*curation_info, curation_tokens);
 
                         share_type total_beneficiary = 0;
 
@@ -2531,10 +3027,15 @@ namespace golos { namespace chain {
                 return;
             }
 
+            const bool has_hardfork_0_17__431 = has_hardfork(STEEMIT_HARDFORK_0_17__431);
+            if (has_hardfork_0_17__431 && _comment_cashout_threads != 1) {
+                process_comment_cashout_batch();
+                return;
+            }
+
             int count = 0;
             const auto &cidx = get_index<comment_index>().indices().get<by_cashout_time>();
             const auto &com_by_root = get_index<comment_index>().indices().get<by_root>();
-            const bool has_hardfork_0_17__431 = has_hardfork(STEEMIT_HARDFORK_0_17__431);
             const auto block_time = head_block_time();
 
             auto current = cidx.begin();
@@ -2554,6 +3055,46 @@ namespace golos { namespace chain {
             }
         }
 
+        void database::process_comment_cashout_batch() {
+            const auto &cidx = get_index<comment_index>().indices().get<by_cashout_time>();
+            const auto block_time = head_block_time();
+
+            // the cashout sets cashout_time to maximum only for the paid comment,
+            //   so the comments due in the block can be collected before the payouts
+            std::vector<const comment_object *> comments;
+            uint64_t votes = 0;
+            for (auto itr = cidx.begin(); itr != cidx.end() && itr->cashout_time <= block_time; ++itr) {
+                comments.push_back(&*itr);
+                if (itr->net_rshares > 0) {
+                    votes += itr->total_votes;
+                }
+            }
+            if (comments.empty()) {
+                return;
+            }
+
+            uint32_t threads = _comment_cashout_threads;
+            if (!threads) {
+                // threads don't pay off for a few votes
+                constexpr uint64_t min_votes_per_thread = 256;
+                threads = std::max(1u, std::thread::hardware_concurrency());
+                threads = uint32_t(std::min<uint64_t>(threads, votes / min_votes_per_thread + 1));
+            }
+
+            std::vector<std::unique_ptr<comment_curation_info>> curation_infos(comments.size());
+
+            // computing of curation only reads the state, the payouts are applied after it
+            _worker_pool.run(comments.size(), threads, [&](size_t i) {
+                if (comments[i]->net_rshares > 0) {
+                    curation_infos[i] = std::make_unique<comment_curation_info>(*this, *comments[i], false);
+                }
+            });
+
+            for (size_t i = 0; i < comments.size(); ++i) {
+                cashout_comment_helper(*comments[i], curation_infos[i].get());
+            }
+        }
+
        /**
         *  At a start overall the network has an inflation rate of 15.15% of virtual golos per year.
         *  Each year the inflation rate is reduced by 0.42% and stops at 0.95% of virtual golos per year in 33 years.
@@ -3067,6 +3608,9 @@ namespace golos { namespace chain {
         }
 
         void database::initialize_indexes() {
+            _snapshot_indexes.clear();
+            _index_memory_profilers.clear();
+
             add_core_index<dynamic_global_property_index>(*this);
             add_core_index<account_index>(*this);
             add_core_index<account_authority_index>(*this);
@@ -3096,6 +3640,9 @@ namespace golos { namespace chain {
             add_core_index<proposal_index>(*this);
             add_core_index<required_approval_index>(*this);
 
+            // it isn't a part of snapshots, it's computed after they are loaded
+            add_index<state_digest_index>();
+
             _plugin_index_signal();
         }
 
@@ -3371,7 +3918,49 @@ namespace golos { namespace chain {
             return skip;
         }
 
+        void database::check_block_transactions(const signed_block &next_block, uint32_t skip) {
+            const bool check_signatures = !(skip & (skip_transaction_signatures | skip_authority_check));
+            const bool check_operations = !(skip & skip_validate_operations);
+            if (!check_signatures && !check_operations) {
+                return;
+            }
+
+            auto &checks = _transaction_checker.start_block(next_block.transactions);
+
+            // checks only read the state before the block, conflicts are found when transactions are applied
+            _worker_pool.run(checks.size(), _transaction_checker.threads(), [&](size_t i) {
+                auto &c = checks[i];
+                auto get_authority_view = [&](authority::classification level) {
+                    return [&, level](const account_name_type &name) {
+                        const auto &auth = get_authority(name);
+                        c.reads.emplace_back(&auth, auth.revision);
+                        return &_authority_cache.get(auth, level);
+                    };
+                };
+
+                try {
+                    if (check_operations) {
+                        c.trx->validate();
+                    }
+                    if (check_signatures) {
+                        c.trx->verify_authority(STEEMIT_CHAIN_ID,
+                            get_authority_view(authority::active),
+                            get_authority_view(authority::owner),
+                            get_authority_view(authority::posting),
+                            STEEMIT_MAX_SIG_CHECK_DEPTH);
+                    }
+                    c.valid = true;
+                } catch (...) {
+                    // the transaction is checked again when it's applied
+                }
+            });
+        }
+
         void database::_validate_transaction(const signed_transaction &trx, uint32_t skip) {
+            if (_transaction_checker.passed(trx, _current_trx_in_block)) {
+                skip |= skip_validate_operations | skip_transaction_signatures | skip_authority_check;
+            }
+
             if (!(skip & skip_validate_operations)) {   /* issue #505 explains why this skip_flag is disabled */
                 trx.validate();
             }
@@ -3380,15 +3969,15 @@ namespace golos { namespace chain {
                 const chain_id_type &chain_id = STEEMIT_CHAIN_ID;
 
                 auto get_active = [&](const account_name_type& name) {
-                    return authority(get_authority(name).active);
+                    return &get_cached_authority(name, authority::active);
                 };
 
                 auto get_owner = [&](const account_name_type& name) {
-                    return authority(get_authority(name).owner);
+                    return &get_cached_authority(name, authority::owner);
                 };
 
                 auto get_posting = [&](const account_name_type& name) {
-                    return authority(get_authority(name).posting);
+                    return &get_cached_authority(name, authority::posting);
                 };
 
                 try {
@@ -3471,6 +4060,34 @@ namespace golos { namespace chain {
             _next_flush_block = 0;
         }
 
+        void database::set_flush_state_rate(uint64_t bytes_per_second) {
+            _flush_state_rate = bytes_per_second;
+        }
+
+        void database::flush_state(uint32_t block_num) {
+            auto start = fc::time_point::now();
+            _flushed_state_pass = _state_flusher.completed_passes();
+            chainbase::database::flush();
+
+            state_flush_marker marker;
+            marker.block_num = block_num;
+            marker.block_id = head_block_id();
+            marker.revision = revision();
+            marker.time = head_block_time();
+
+            // the marker is replaced atomically, so it always describes a completed flush
+            auto marker_file = _shared_mem_dir / "shared_memory.flush";
+            auto tmp_file = _shared_mem_dir / "shared_memory.flush.tmp";
+            fc::json::save_to_file(marker, tmp_file);
+            fc::rename(tmp_file, marker_file);
+
+            auto elapsed = fc::time_point::now() - start;
+            if (elapsed > fc::milliseconds(100)) {
+                wlog("Flushing shared memory at block ${b} took ${t} sec",
+                    ("b", block_num)("t", double(elapsed.count()) / 1000000.0));
+            }
+        }
+
         const block_log &database::get_block_log() const {
             return _block_log;
         }
@@ -3490,7 +4107,7 @@ namespace golos { namespace chain {
                                   itr->second, "Block did not match checkpoint", ("checkpoint", *itr)("block_id", next_block.id()));
 
                     if (_checkpoints.rbegin()->first >= block_num) {
-                        skip = skip_witness_signature
+                        skip |= skip_witness_signature
                                | skip_transaction_signatures
                                | skip_transaction_dupe_check
                                | skip_fork_db
@@ -3502,6 +4119,12 @@ namespace golos { namespace chain {
                                | skip_witness_schedule_check
                                | skip_validate_operations
                                | skip_validate_invariants;
+
+                        // a forged block would stay in the fork database until its branch fails a checkpoint
+                        //   and would stall the trusted sync, so it's rejected at once
+                        if (_checkpoint_trusted_sync) {
+                            skip &= ~(skip_witness_signature | skip_witness_schedule_check);
+                        }
                     }
                 }
 
@@ -3534,9 +4157,13 @@ namespace golos { namespace chain {
                     }
 
                     if (_next_flush_block == block_num) {
-                        _next_flush_block = 0;
-//                        ilog("Flushing database shared memory at block ${b}", ("b", block_num));
-                        chainbase::database::flush();
+                        if (_state_flusher.is_running() && _state_flusher.completed_passes() < _flushed_state_pass + 2) {
+                            // a full background pass started after the previous flush keeps this one short
+                            _next_flush_block = block_num + 1;
+                        } else {
+                            _next_flush_block = 0;
+                            flush_state(block_num);
+                        }
                     }
                 }
 
@@ -3549,6 +4176,11 @@ namespace golos { namespace chain {
                 const auto &gprops = get_dynamic_global_properties();
                 //block_id_type next_block_id = next_block.id();
 
+                _block_profiler.start_block(next_block_num);
+                _maintenance.start_block(next_block.previous, next_block.id());
+                _authority_cache.trim();
+
+                _block_profiler.next_stage("validate_block");
                 _validate_block(next_block, skip);
 
                 const witness_object &signing_witness = validate_block_header(skip, next_block);
@@ -3577,56 +4209,100 @@ namespace golos { namespace chain {
                     );
                 }
 
-                for (const auto &trx : next_block.transactions) {
-                    /* We do not need to push the undo state for each transaction
-                     * because they either all apply and are valid or the
-                     * entire block fails to apply.  We only need an "undo" state
-                     * for transactions when validating broadcast transactions or
-                     * when building a block.
-                     */
-                    apply_transaction(trx, skip);
-                    ++_current_trx_in_block;
+                if (_transaction_checker.enabled() && next_block.transactions.size() > 1) {
+                    _block_profiler.next_stage("check_transactions");
+                    check_block_transactions(next_block, skip);
+                }
+
+                _block_profiler.next_stage("transactions");
+                try {
+                    for (const auto &trx : next_block.transactions) {
+                        /* We do not need to push the undo state for each transaction
+                         * because they either all apply and are valid or the
+                         * entire block fails to apply.  We only need an "undo" state
+                         * for transactions when validating broadcast transactions or
+                         * when building a block.
+                         */
+                        apply_transaction(trx, skip);
+                        ++_current_trx_in_block;
+                    }
+                } catch (...) {
+                    _transaction_checker.reset();
+                    throw;
                 }
+                _transaction_checker.reset();
 
                 _current_trx_in_block = -1;
                 _current_op_in_trx = 0;
                 _current_virtual_op = 0;
 
+                _block_profiler.next_stage("update_global_dynamic_data");
                 update_global_dynamic_data(next_block, skip);
+                _block_profiler.next_stage("update_signing_witness");
                 update_signing_witness(signing_witness, next_block);
 
+                _block_profiler.next_stage("update_last_irreversible_block");
                 update_last_irreversible_block(skip);
 
+                _block_profiler.next_stage("create_block_summary");
                 create_block_summary(next_block);
-                clear_expired_proposals();
+                _block_profiler.next_stage("clear_expired_proposals");
+                run_maintenance_task(expired_proposals_task, &database::clear_expired_proposals);
+                _block_profiler.next_stage("clear_expired_transactions");
                 clear_expired_transactions();
-                clear_expired_orders();
-                clear_expired_delegations();
+                _block_profiler.next_stage("clear_expired_orders");
+                run_maintenance_task(expired_orders_task, &database::clear_expired_orders);
+                _block_profiler.next_stage("clear_expired_delegations");
+                run_maintenance_task(expired_delegations_task, &database::clear_expired_delegations);
+                _block_profiler.next_stage("update_witness_schedule");
                 update_witness_schedule();
 
+                _block_profiler.next_stage("update_median_feed");
                 update_median_feed();
+                _block_profiler.next_stage("update_virtual_supply_after_feed");
                 update_virtual_supply();
 
+                _block_profiler.next_stage("clear_null_account_balance");
                 clear_null_account_balance();
+                _block_profiler.next_stage("process_funds");
                 process_funds();
-                process_conversions();
+                _block_profiler.next_stage("process_conversions");
+                run_maintenance_task(conversions_task, &database::process_conversions);
+                _block_profiler.next_stage("process_comment_cashout");
                 process_comment_cashout();
+                _block_profiler.next_stage("process_vesting_withdrawals");
                 process_vesting_withdrawals();
-                process_savings_withdraws();
+                _block_profiler.next_stage("process_savings_withdraws");
+                run_maintenance_task(savings_withdraws_task, &database::process_savings_withdraws);
+                _block_profiler.next_stage("pay_liquidity_reward");
                 pay_liquidity_reward();
+                _block_profiler.next_stage("update_virtual_supply_after_rewards");
                 update_virtual_supply();
 
-                account_recovery_processing();
-                expire_escrow_ratification();
-                process_decline_voting_rights();
+                _block_profiler.next_stage("account_recovery_processing");
+                run_maintenance_task(account_recovery_task, &database::account_recovery_processing);
+                _block_profiler.next_stage("expire_escrow_ratification");
+                run_maintenance_task(escrow_ratification_task, &database::expire_escrow_ratification);
+                _block_profiler.next_stage("process_decline_voting_rights");
+                run_maintenance_task(decline_voting_rights_task, &database::process_decline_voting_rights);
 
+                _block_profiler.next_stage("process_hardforks");
                 process_hardforks();
 
+                _block_profiler.next_stage("notify_applied_block");
                 // notify observers that the block has been applied
                 notify_applied_block(next_block);
 
+                _block_profiler.next_stage("notify_changed_objects");
                 notify_changed_objects();
 
+                if (_state_digest) {
+                    _block_profiler.next_stage("push_state_digest");
+                    push_state_digest();
+                }
+
+                _block_profiler.end_block();
+
             } FC_CAPTURE_LOG_AND_RETHROW((next_block.block_num()))
         }
 
@@ -3833,9 +4509,57 @@ namespace golos { namespace chain {
                 ++_current_virtual_op;
                 note.virtual_op = _current_virtual_op;
             }
-            notify_pre_apply_operation(note);
-            _my->_evaluator_registry.get_evaluator(op).apply(op);
-            notify_post_apply_operation(note);
+
+            auto apply = [&]() {
+                notify_pre_apply_operation(note);
+                auto prev_note = _current_operation_notification;
+                _current_operation_notification = &note;
+                try {
+                    auto cost = _operation_costs.measure(operation_cost_accounting::evaluator, op.which());
+                    if (_block_profiler.enabled()) {
+                        if (_evaluator_stage_names.empty()) {
+                            _evaluator_stage_names.resize(operation::count());
+                        }
+                        auto &name = _evaluator_stage_names[op.which()];
+                        if (name.empty()) {
+                            name = "evaluator:" + op.visit(operation_name_visitor());
+                        }
+                        auto profile = _block_profiler.measure(name);
+                        _my->_evaluator_registry.get_evaluator(op).apply(op);
+                    } else {
+                        _my->_evaluator_registry.get_evaluator(op).apply(op);
+                    }
+                } catch (...) {
+                    _current_operation_notification = prev_note;
+                    throw;
+                }
+                _current_operation_notification = prev_note;
+                notify_post_apply_operation(note);
+            };
+
+            if (!_undo_profiling) {
+                apply();
+                return;
+            }
+
+            // changes of plugin indexes made on notifications are counted too
+            auto prev_operation = _current_undo_operation;
+            _current_undo_operation = op.which() + 1;
+            auto start = fc::time_point::now();
+            try {
+                apply();
+            } catch (...) {
+                _current_undo_operation = prev_operation;
+                throw;
+            }
+
+            auto &stat = current_undo_statistics();
+            if (stat.operation.empty()) {
+                stat.operation = op.visit(operation_name_visitor());
+            }
+            ++stat.count;
+            stat.apply_time += fc::time_point::now() - start;
+            _current_undo_operation = prev_operation;
         }
 
         const witness_object &database::validate_block_header(uint32_t skip, const signed_block &next_block) const {
@@ -4026,13 +4750,32 @@ namespace golos { namespace chain {
             try {
                 const dynamic_global_property_object &dpo = get_dynamic_global_properties();
 
+                if (_checkpoint_trusted_sync && _checkpoints.size() &&
+                    _checkpoints.rbegin()->second != block_id_type() &&
+                    _checkpoints.rbegin()->first >= head_block_num()
+                ) {
+                    // below the last checkpoint a block is final only when the chain has reached a checkpoint,
+                    //   apply_block has matched the id of each checkpoint block on the way
+                    auto itr = _checkpoints.upper_bound(head_block_num());
+                    if (itr != _checkpoints.begin()) {
+                        --itr;
+                        if (itr->first > dpo.last_irreversible_block_num) {
+                            modify(dpo, [&](dynamic_global_property_object &_dpo) {
+                                _dpo.last_irreversible_block_num = itr->first;
+                            });
+                        }
+                    }
+                }
                 /**
     * Prior to voting taking over, we must be more conservative...
     *
     */
-                if (head_block_num() < STEEMIT_START_MINER_VOTING_BLOCK) {
+                else if (head_block_num() < STEEMIT_START_MINER_VOTING_BLOCK) {
                     modify(dpo, [&](dynamic_global_property_object &_dpo) {
-                        if (head_block_num() > STEEMIT_MAX_WITNESSES) {
+                        // a checkpoint reached by the trusted sync may be above it
+                        if (head_block_num() > STEEMIT_MAX_WITNESSES &&
+                            head_block_num() - STEEMIT_MAX_WITNESSES > _dpo.last_irreversible_block_num
+                        ) {
                             _dpo.last_irreversible_block_num =
                                     head_block_num() - STEEMIT_MAX_WITNESSES;
                         }
@@ -4078,19 +4821,14 @@ namespace golos { namespace chain {
 
                 if (!(skip & skip_block_log)) {
                     // output to block log based on new last irreverisible block num
-                    const auto &tmp_head = _block_log.head();
-                    uint64_t log_head_num = 0;
-
-                    if (tmp_head) {
-                        log_head_num = tmp_head->block_num();
-                    }
+                    uint64_t log_head_num = protocol::block_header::num_from_id(_block_log.head_id());
 
                     if (log_head_num < dpo.last_irreversible_block_num) {
                         while (log_head_num < dpo.last_irreversible_block_num) {
                             std::shared_ptr<fork_item> block = _fork_db.fetch_block_on_main_branch_by_number(
                                     log_head_num + 1);
                             FC_ASSERT(block, "Current fork in the fork database does not contain the last_irreversible_block");
-                            _block_log.append(block->data);
+                            _block_log.append(block->id, block->num, block->packed_data());
                             log_head_num++;
                         }
 
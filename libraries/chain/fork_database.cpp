@@ -2,15 +2,31 @@
 
 #include <golos/chain/database_exceptions.hpp>
 
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+
 namespace golos {
     namespace chain {
 
+        fork_item::fork_item(const signed_block &d)
+                : num(d.block_num()), id(d.id()), previous(d.previous), _packed(fc::raw::pack(d)) {
+        }
+
+        signed_block fork_item::data() const {
+            signed_block block;
+            fc::raw::unpack(_packed, block);
+            return block;
+        }
+
         fork_database::fork_database() {
         }
 
         void fork_database::reset() {
             _head.reset();
             _index.clear();
+            _by_num.clear();
+            _first_num = 0;
         }
 
         void fork_database::pop_block() {
@@ -21,8 +37,8 @@ namespace golos {
         }
 
         void fork_database::start_block(signed_block b) {
-            auto item = std::make_shared<fork_item>(std::move(b));
-            _index.insert(item);
+            auto item = std::allocate_shared<fork_item>(fork_item_allocator(), b);
+            _insert(item);
             _head = item;
         }
 
@@ -31,15 +47,15 @@ namespace golos {
  *
  */
         shared_ptr<fork_item> fork_database::push_block(const signed_block &b) {
-            auto item = std::make_shared<fork_item>(b);
+            auto item = std::allocate_shared<fork_item>(fork_item_allocator(), b);
             try {
                 _push_block(item);
             }
             catch (const unlinkable_block_exception &e) {
                 wlog("Pushing block to fork database that failed to link: ${id}, ${num}", ("id", b.id())("num", b.block_num()));
-                wlog("Head: ${num}, ${id}", ("num", _head->data.block_num())("id", _head->data.id()));
+                wlog("Head: ${num}, ${id}", ("num", _head->num)("id", _head->id));
                 throw;
-                _unlinked_index.insert(item);
+                _unlinked.push_back(item);
             }
             return _head;
         }
@@ -64,7 +80,7 @@ namespace golos {
                 item->prev = *itr;
             }
 
-            _index.insert(item);
+            _insert(item);
             if (!_head || item->num > _head->num) {
                 _head = item;
             }
@@ -77,16 +93,39 @@ namespace golos {
  *  _push_next(..) calls _push_block(...) which will in turn call _push_next
  */
         void fork_database::_push_next(const item_ptr &new_item) {
-            auto &prev_idx = _unlinked_index.get<by_previous>();
+            auto find_next = [&]() {
+                return std::find_if(_unlinked.begin(), _unlinked.end(), [&](const item_ptr &item) {
+                    return item->previous == new_item->id;
+                });
+            };
 
-            auto itr = prev_idx.find(new_item->id);
-            while (itr != prev_idx.end()) {
+            auto itr = find_next();
+            while (itr != _unlinked.end()) {
                 auto tmp = *itr;
-                prev_idx.erase(itr);
+                _unlinked.erase(itr);
                 _push_block(tmp);
 
-                itr = prev_idx.find(new_item->id);
+                itr = find_next();
+            }
+        }
+
+        void fork_database::_insert(const item_ptr &item) {
+            if (!_index.insert(item).second) {
+                return;
+            }
+
+            if (_by_num.empty()) {
+                _first_num = item->num;
+            } else if (item->num < _first_num) {
+                _by_num.insert(_by_num.begin(), _first_num - item->num, branch_type());
+                _first_num = item->num;
             }
+
+            auto pos = item->num - _first_num;
+            if (pos >= _by_num.size()) {
+                _by_num.resize(pos + 1);
+            }
+            _by_num[pos].push_back(item);
         }
 
         void fork_database::set_max_size(uint32_t s) {
@@ -95,31 +134,23 @@ namespace golos {
                 return;
             }
 
+            auto min_num = std::max(int64_t(0), int64_t(_head->num) - _max_size);
+
             { /// index
-                auto &by_num_idx = _index.get<block_num>();
-                auto itr = by_num_idx.begin();
-                while (itr != by_num_idx.end()) {
-                    if ((*itr)->num <
-                        std::max(int64_t(0), int64_t(_head->num) - _max_size)) {
-                        by_num_idx.erase(itr);
-                    } else {
-                        break;
+                while (!_by_num.empty() && _first_num < min_num) {
+                    for (const auto &item: _by_num.front()) {
+                        _index.erase(item->id);
                     }
-                    itr = by_num_idx.begin();
+                    _by_num.pop_front();
+                    ++_first_num;
                 }
             }
-            { /// unlinked_index
-                auto &by_num_idx = _unlinked_index.get<block_num>();
-                auto itr = by_num_idx.begin();
-                while (itr != by_num_idx.end()) {
-                    if ((*itr)->num <
-                        std::max(int64_t(0), int64_t(_head->num) - _max_size)) {
-                        by_num_idx.erase(itr);
-                    } else {
-                        break;
-                    }
-                    itr = by_num_idx.begin();
-                }
+            { /// unlinked
+                _unlinked.erase(
+                    std::remove_if(_unlinked.begin(), _unlinked.end(), [&](const item_ptr &item) {
+                        return item->num < min_num;
+                    }),
+                    _unlinked.end());
             }
         }
 
@@ -129,9 +160,9 @@ namespace golos {
             if (itr != index.end()) {
                 return true;
             }
-            auto &unlinked_index = _unlinked_index.get<block_id>();
-            auto unlinked_itr = unlinked_index.find(id);
-            return unlinked_itr != unlinked_index.end();
+            return std::any_of(_unlinked.begin(), _unlinked.end(), [&](const item_ptr &item) {
+                return item->id == id;
+            });
         }
 
         item_ptr fork_database::fetch_block(const block_id_type &id) const {
@@ -140,27 +171,20 @@ namespace golos {
             if (itr != index.end()) {
                 return *itr;
             }
-            auto &unlinked_index = _unlinked_index.get<block_id>();
-            auto unlinked_itr = unlinked_index.find(id);
-            if (unlinked_itr != unlinked_index.end()) {
-                return *unlinked_itr;
+            for (const auto &item: _unlinked) {
+                if (item->id == id) {
+                    return item;
+                }
             }
             return item_ptr();
         }
 
         vector<item_ptr> fork_database::fetch_block_by_number(uint32_t num) const {
             try {
-                vector<item_ptr> result;
-                auto itr = _index.get<block_num>().find(num);
-                while (itr != _index.get<block_num>().end()) {
-                    if ((*itr)->num == num) {
-                        result.push_back(*itr);
-                    } else {
-                        break;
-                    }
-                    ++itr;
+                if (num < _first_num || num - _first_num >= _by_num.size()) {
+                    return vector<item_ptr>();
                 }
-                return result;
+                return _by_num[num - _first_num];
             }
             FC_LOG_AND_RETHROW()
         }
@@ -180,20 +204,20 @@ namespace golos {
                 auto second_branch = *second_branch_itr;
 
 
-                while (first_branch->data.block_num() >
-                       second_branch->data.block_num()) {
+                while (first_branch->num >
+                       second_branch->num) {
                     result.first.push_back(first_branch);
                     first_branch = first_branch->prev.lock();
                     FC_ASSERT(first_branch);
                 }
-                while (second_branch->data.block_num() >
-                       first_branch->data.block_num()) {
+                while (second_branch->num >
+                       first_branch->num) {
                     result.second.push_back(second_branch);
                     second_branch = second_branch->prev.lock();
                     FC_ASSERT(second_branch);
                 }
-                while (first_branch->data.previous !=
-                       second_branch->data.previous) {
+                while (first_branch->previous !=
+                       second_branch->previous) {
                     result.first.push_back(first_branch);
                     result.second.push_back(second_branch);
                     first_branch = first_branch->prev.lock();
@@ -237,7 +261,16 @@ namespace golos {
         }
 
         void fork_database::remove(block_id_type id) {
-            _index.get<block_id>().erase(id);
+            auto itr = _index.find(id);
+            if (itr == _index.end()) {
+                return;
+            }
+
+            auto item = *itr;
+            _index.erase(itr);
+
+            auto &bucket = _by_num[item->num - _first_num];
+            bucket.erase(std::find(bucket.begin(), bucket.end(), item));
         }
 
     }
@@ -157,6 +157,9 @@ public:
     shared_authority posting; ///< used for voting and posting
 
     time_point_sec last_owner_update;
+
+    /// increased by each modification, copies of authorities are checked by it
+    uint32_t revision = 0;
 };
 
 class account_bandwidth_object
@@ -510,7 +513,8 @@ FC_REFLECT((golos::chain::account_object),
     (id)(name)(memo_key)(proxy)(last_account_update)
     (created)(mined)
     (owner_challenged)(active_challenged)(last_owner_proved)(last_active_proved)(recovery_account)(last_account_recovery)(reset_account)
-    (comment_count)(lifetime_vote_count)(post_count)(can_vote)(voting_power)(last_vote_time)
+    (comment_count)(lifetime_vote_count)(post_count)(can_vote)(voting_power)
+    (posts_capacity)(comments_capacity)(voting_capacity)(last_vote_time)
     (balance)
     (savings_balance)
     (sbd_balance)(sbd_seconds)(sbd_seconds_last_update)(sbd_last_interest_payment)
@@ -528,7 +532,7 @@ FC_REFLECT((golos::chain::account_object),
 CHAINBASE_SET_INDEX_TYPE(golos::chain::account_object, golos::chain::account_index)
 
 FC_REFLECT((golos::chain::account_authority_object),
-        (id)(account)(owner)(active)(posting)(last_owner_update)
+        (id)(account)(owner)(active)(posting)(last_owner_update)(revision)
 )
 CHAINBASE_SET_INDEX_TYPE(golos::chain::account_authority_object, golos::chain::account_authority_index)
 
@@ -539,7 +543,7 @@ CHAINBASE_SET_INDEX_TYPE(golos::chain::account_bandwidth_object, golos::chain::a
 FC_REFLECT((golos::chain::account_metadata_object), (id)(account)(json_metadata))
 CHAINBASE_SET_INDEX_TYPE(golos::chain::account_metadata_object, golos::chain::account_metadata_index)
 
-FC_REFLECT((golos::chain::vesting_delegation_object), (id)(delegator)(delegatee)(vesting_shares)(interest_rate)(min_delegation_time))
+FC_REFLECT((golos::chain::vesting_delegation_object), (id)(delegator)(delegatee)(vesting_shares)(interest_rate)(min_delegation_time)(payout_strategy))
 CHAINBASE_SET_INDEX_TYPE(golos::chain::vesting_delegation_object, golos::chain::vesting_delegation_index)
 
 FC_REFLECT((golos::chain::vesting_delegation_expiration_object), (id)(delegator)(vesting_shares)(expiration))
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <golos/chain/account_object.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace golos { namespace chain {
+
+    struct authority_cache_statistics {
+        uint64_t size = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    /**
+     *  Copies of account authorities for the signature verification keyed by the account, the level and
+     *  the revision of the authority object.  Each modification increases the revision and drops copies of
+     *  the account, undone modifications restore older revisions, so a stale copy is never returned.
+     *  Copies stay valid until the authority is modified or the cache is trimmed under the write lock,
+     *  lookups can be done by several readers.
+     */
+    class authority_cache final {
+    public:
+        using level_type = authority::classification;
+
+        static constexpr size_t max_size = 300000;
+
+        const authority &get(const account_authority_object &auth, level_type level);
+
+        template<typename ObjectType>
+        void on_change(const ObjectType &) {
+        }
+
+        void on_change(const account_authority_object &auth);
+
+        /** Drops all copies when there are too many of them, it shouldn't be called during the verification */
+        void trim();
+
+        void clear();
+
+        authority_cache_statistics get_statistics() const;
+
+    private:
+        struct entry {
+            uint32_t revision = 0;
+            authority value;
+        };
+
+        using key_type = std::pair<account_name_type, level_type>;
+
+        mutable std::mutex _mutex;
+        std::map<key_type, entry> _entries;
+        uint64_t _hits = 0;
+        uint64_t _misses = 0;
+    };
+
+} } // golos::chain
+
+FC_REFLECT((golos::chain::authority_cache_statistics), (size)(hits)(misses))
@@ -49,6 +49,12 @@ namespace golos {
 
             uint64_t append(const signed_block& b);
 
+            /** Appends the block already packed by the caller */
+            uint64_t append(const signed_block& b, const std::vector<char>& packed);
+
+            /** Appends the packed block without unpacking it, the head is read from the log when it's requested */
+            uint64_t append(const block_id_type& id, uint32_t block_num, const std::vector<char>& packed);
+
             void flush();
 
             std::pair<signed_block, uint64_t> read_block(uint64_t file_pos) const;
@@ -64,6 +70,9 @@ namespace golos {
 
             const optional <signed_block>& head() const;
 
+            /** Id of the head block, it doesn't read the head block */
+            block_id_type head_id() const;
+
             static const uint64_t npos = std::numeric_limits<uint64_t>::max();
 
         private:
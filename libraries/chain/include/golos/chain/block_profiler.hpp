@@ -0,0 +1,144 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <array>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace golos { namespace chain {
+
+    struct profiler_stage_statistics {
+        std::string name;
+        uint64_t count = 0;
+        fc::microseconds total;
+        fc::microseconds max;
+        /// upper bounds of the histogram buckets containing the percentiles
+        fc::microseconds p50;
+        fc::microseconds p90;
+        fc::microseconds p99;
+    };
+
+    struct slow_block_stage {
+        std::string name;
+        uint32_t count = 0;
+        fc::microseconds time;
+    };
+
+    struct slow_block_report {
+        uint32_t block_num = 0;
+        fc::microseconds time;
+        /// stages of the block sorted by their time, nested stages (evaluators, signals) are included in outer ones
+        std::vector<slow_block_stage> stages;
+    };
+
+    /**
+     *  Times the stages of block application, evaluators and plugin signals.  Statistics are kept in log2
+     *  histograms of two generations, which are rotated every window blocks, so they cover the last
+     *  window to 2 * window blocks.  The profiler is used under the write lock of the database,
+     *  its statistics should be read under the read lock.  When it's disabled, each measure is a flag check.
+     */
+    class block_profiler final {
+        struct stage;
+
+    public:
+        /** Adds the time from its construction to its destruction to the stage */
+        class scope final {
+        public:
+            scope(block_profiler *profiler, stage *s);
+
+            scope(scope &&other);
+
+            scope(const scope &) = delete;
+
+            ~scope();
+
+        private:
+            block_profiler *_profiler;
+            stage *_stage;
+            fc::time_point _start;
+        };
+
+        void enable(uint32_t window, fc::microseconds slow_block_time);
+
+        void disable();
+
+        bool enabled() const {
+            return _enabled;
+        }
+
+        /** The name is converted to a string only when the profiler is enabled */
+        template<typename Name>
+        scope measure(const Name &name) {
+            return scope(this, _enabled ? &get_stage(name) : nullptr);
+        }
+
+        /** Starts timing of a block, the following stages are attributed to it */
+        void start_block(uint32_t block_num);
+
+        /** Ends the current top-level stage of the block and starts the next one */
+        void next_stage(const char *name) {
+            if (_enabled) {
+                switch_stage(name);
+            }
+        }
+
+        /** Ends the block, it's reported if it took more than the slow block time */
+        void end_block();
+
+        std::vector<profiler_stage_statistics> get_statistics() const;
+
+        std::vector<slow_block_report> get_slow_blocks() const;
+
+        void reset();
+
+    private:
+        static constexpr size_t bucket_count = 32;
+        static constexpr size_t max_slow_blocks = 16;
+
+        struct generation {
+            std::array<uint64_t, bucket_count> buckets{};
+            uint64_t count = 0;
+            int64_t total = 0;
+            int64_t max = 0;
+        };
+
+        struct stage {
+            std::string name;
+            std::array<generation, 2> generations;
+            /// time and calls in the current block, they are reset when the block is started
+            int64_t block_time = 0;
+            uint32_t block_count = 0;
+        };
+
+        stage &get_stage(const std::string &name);
+
+        void switch_stage(const char *name);
+
+        void add(stage &s, int64_t usec);
+
+        bool _enabled = false;
+        uint32_t _window = 1200;
+        fc::microseconds _slow_block_time;
+
+        std::map<std::string, stage> _stages;
+        size_t _generation = 0;
+        uint32_t _blocks_in_generation = 0;
+
+        uint32_t _block_num = 0;
+        fc::time_point _block_start;
+        stage *_current_stage = nullptr;
+        fc::time_point _stage_start;
+        std::vector<stage *> _block_stages;
+
+        std::deque<slow_block_report> _slow_blocks;
+    };
+
+} } // golos::chain
+
+FC_REFLECT((golos::chain::profiler_stage_statistics), (name)(count)(total)(max)(p50)(p90)(p99))
+FC_REFLECT((golos::chain::slow_block_stage), (name)(count)(time))
+FC_REFLECT((golos::chain::slow_block_report), (block_num)(time)(stages))
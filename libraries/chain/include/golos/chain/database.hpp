@@ -1,17 +1,31 @@
 #pragma once
 
+#include <golos/chain/authority_cache.hpp>
 #include <golos/chain/global_property_object.hpp>
 #include <golos/chain/node_property_object.hpp>
 #include <golos/chain/fork_database.hpp>
 #include <golos/chain/block_log.hpp>
+#include <golos/chain/block_profiler.hpp>
+#include <golos/chain/dynamic_size.hpp>
 #include <golos/chain/hardfork.hpp>
+#include <golos/chain/operation_cost.hpp>
+#include <golos/chain/maintenance_scheduler.hpp>
+#include <golos/chain/shared_memory_policy.hpp>
+#include <golos/chain/state_digest.hpp>
+#include <golos/chain/state_flusher.hpp>
+#include <golos/chain/transaction_checker.hpp>
+#include <golos/chain/worker_pool.hpp>
 #include <golos/protocol/protocol.hpp>
 
 #include <fc/signals.hpp>
 
 #include <fc/log/logger.hpp>
 
+#include <deque>
+#include <functional>
+#include <future>
 #include <map>
+#include <set>
 
 namespace golos { namespace chain {
 
@@ -30,6 +44,53 @@ namespace golos { namespace chain {
 
         struct comment_curation_info;
 
+        class abstract_snapshot_index;
+
+        /** Written next to the shared memory file after it's fully flushed at a block boundary */
+        struct state_flush_marker {
+            uint32_t block_num = 0;
+            block_id_type block_id;
+            int64_t revision = 0;
+            fc::time_point_sec time;
+        };
+
+        class abstract_index_memory_profiler;
+
+        struct index_memory_info;
+
+        /** Growth of the shared memory file, the time is spent with the database locked */
+        struct shared_memory_resize_statistics {
+            uint32_t resize_count = 0;
+            fc::microseconds total_resize_time;
+            fc::microseconds max_resize_time;
+            fc::microseconds last_resize_time;
+            uint32_t last_resize_block_num = 0;
+            /// average growth of used memory per block observed between the checks of free memory
+            uint64_t used_memory_per_block = 0;
+            /// bytes allocated on disk ahead of the next resize
+            uint64_t preallocated_size = 0;
+        };
+
+        /**
+         *  Changes of objects made by the operations of one type. Chainbase copies an object to the undo state
+         *  on its first modification or removal in a session, so copied and copied_size count the object with its
+         *  dynamic memory only once per session.  It's an upper bound: an object copied by a squashed child
+         *  session is counted again if it's changed in the parent session.  The undo state itself is kept by
+         *  the thirdparty/chainbase submodule, these statistics only measure it.
+         */
+        struct undo_operation_statistics {
+            /// operation name, "block" is the processing of blocks outside of operations
+            std::string operation;
+            uint64_t count = 0;
+            uint64_t created = 0;
+            uint64_t modified = 0;
+            uint64_t removed = 0;
+            /// objects copied to the undo state, each copy is an allocation in the shared memory
+            uint64_t copied = 0;
+            uint64_t copied_size = 0;
+            fc::microseconds apply_time;
+        };
+
         /**
          *   @class database
          *   @brief tracks the blockchain state in an extensible manner
@@ -40,7 +101,65 @@ namespace golos { namespace chain {
 
             ~database();
 
-            using chainbase::database::remove;
+            template<typename ObjectType, typename Constructor>
+            const ObjectType &create(Constructor &&con) {
+                const auto &obj = chainbase::database::create<ObjectType>(std::forward<Constructor>(con));
+                if (_undo_profiling) {
+                    ++current_undo_statistics().created;
+                    // objects created in the session aren't copied on their changes
+                    is_first_undo_copy(ObjectType::type_id, obj.id._id);
+                }
+                _maintenance.on_change(obj);
+                _authority_cache.on_change(obj);
+                if (_state_digest) {
+                    add_state_digest(ObjectType::type_id, object_digest(obj));
+                }
+                return obj;
+            }
+
+            template<typename ObjectType, typename Modifier>
+            void modify(const ObjectType &obj, Modifier &&m) {
+                if (_undo_profiling) {
+                    auto &stat = current_undo_statistics();
+                    ++stat.modified;
+                    if (is_first_undo_copy(ObjectType::type_id, obj.id._id)) {
+                        ++stat.copied;
+                        stat.copied_size += sizeof(ObjectType) + dynamic_size(obj);
+                    }
+                }
+                uint64_t old_digest = _state_digest ? object_digest(obj) : 0;
+                chainbase::database::modify(obj, std::forward<Modifier>(m));
+                _maintenance.on_change(obj);
+                _authority_cache.on_change(obj);
+                if (_state_digest) {
+                    add_state_digest(ObjectType::type_id, object_digest(obj) - old_digest);
+                }
+            }
+
+            /** Cached copies of authorities are checked by the revision, so each modification increases it */
+            template<typename Modifier>
+            void modify(const account_authority_object &obj, Modifier &&m) {
+                modify<account_authority_object>(obj, [&](account_authority_object &auth) {
+                    m(auth);
+                    ++auth.revision;
+                });
+            }
+
+            template<typename ObjectType>
+            void remove(const ObjectType &obj) {
+                if (_undo_profiling) {
+                    auto &stat = current_undo_statistics();
+                    ++stat.removed;
+                    if (is_first_undo_copy(ObjectType::type_id, obj.id._id)) {
+                        ++stat.copied;
+                        stat.copied_size += sizeof(ObjectType) + dynamic_size(obj);
+                    }
+                }
+                if (_state_digest) {
+                    add_state_digest(ObjectType::type_id, 0 - object_digest(obj));
+                }
+                chainbase::database::remove(obj);
+            }
 
             bool is_producing() const {
                 return _is_producing;
@@ -108,13 +227,153 @@ namespace golos { namespace chain {
             void reindex(const fc::path &data_dir, const fc::path &shared_mem_dir, uint32_t from_block_num, uint64_t shared_file_size = (
                     1024l * 1024l * 1024l * 8l));
 
+            using operation_handler = std::function<void(const operation_notification &)>;
+
+            /** Returns false to stop the stream before the operation */
+            using operation_filter = std::function<bool(const operation_notification &)>;
+
+            /** Streams the stored operations from the block to the filter in the order they were applied */
+            using operation_source = std::function<void(uint32_t from_block, const operation_filter &)>;
+
+            /** The source should stream all operations from the genesis, a filtered or trimmed one isn't set */
+            void set_operation_source(operation_source source);
+
+            /**
+             *  Registers a plugin whose indexes depend only on the stream of operations
+             *  @param clear removes all objects of the plugin indexes
+             *  @param apply handles an operation the same way as on pre_apply_operation
+             */
+            void add_operation_consumer(const std::string &plugin, std::function<void()> clear, operation_handler apply);
+
+            /**
+             *  Rebuilds indexes of the plugins from the stored operations without replaying the blockchain state,
+             *  the shared memory is resized between blocks of operations.  The plugins are processed one by one:
+             *  they share the shared memory allocator and the resize, so they aren't rebuilt in parallel.
+             */
+            void reindex_plugins(const std::vector<std::string> &plugins);
+
+            /**
+             * @brief Write the state of all indexes at the head block to the snapshot directory
+             * @param threads number of indexes written in parallel, 0 means the number of cores
+             */
+            void write_snapshot(const fc::path &snapshot_dir, uint32_t threads = 0);
+
+            /**
+             * @brief Open an empty database and fill it from the snapshot directory
+             *
+             * The block log should contain the snapshot head block, blocks after it can be applied with @ref reindex.
+             */
+            void open_from_snapshot(const fc::path &data_dir, const fc::path &shared_mem_dir,
+                    const fc::path &snapshot_dir, uint64_t shared_file_size = 0, uint32_t chainbase_flags = 0);
+
+            /** Registers the index to be written to and read from snapshots, called by add_core_index/add_plugin_index */
+            void add_snapshot_index(std::shared_ptr<abstract_snapshot_index> index);
+
+            /** Registers the index to be reported by @ref get_index_memory_statistics */
+            void add_index_memory_profiler(std::shared_ptr<abstract_index_memory_profiler> profiler);
+
+            /**
+             * @brief Estimate memory used by each registered index, the database must be locked for reading
+             * @param sample_limit maximum number of objects per index scanned for dynamic memory, 0 means all
+             */
+            std::vector<index_memory_info> get_index_memory_statistics(uint64_t sample_limit = 0) const;
+
             void set_min_free_shared_memory_size(size_t);
             void set_inc_shared_memory_size(size_t);
             void set_block_num_check_free_size(uint32_t);
+            /** Keep enough free memory for the number of blocks at the observed growth rate, 0 disables the prediction */
+            void set_shared_memory_growth_horizon(uint32_t blocks);
+            /** Allocate disk space for the next resize in a background thread */
+            void set_shared_memory_preallocation(bool);
+            /** Huge pages and NUMA placement of the shared memory file, should be set before opening */
+            void set_shared_memory_policy(const shared_memory_policy &policy);
             void check_free_memory(bool skip_print, uint32_t current_block_num);
+            const shared_memory_resize_statistics &get_shared_memory_resize_statistics() const;
+
+            /** Count changes of objects per operation type, it's disabled by default */
+            void set_undo_profiling(bool);
+            bool undo_profiling() const;
+            std::vector<undo_operation_statistics> get_undo_statistics() const;
+            void reset_undo_statistics();
+
+            /** Starts an undo session of chainbase, the undo profiling counts copies of objects per session */
+            session start_undo_session();
+
+            /** Timing of block stages, evaluators and plugin signals, it's disabled by default */
+            block_profiler &get_block_profiler();
+            const block_profiler &get_block_profiler() const;
+
+            /** Time and calls of operation handlers per operation type and consumer, it's disabled by default */
+            void set_operation_cost_accounting(bool);
+            std::vector<operation_cost_statistics> get_operation_cost_statistics() const;
+            void reset_operation_cost_statistics();
+
+            /** Wraps a handler of a signal, so its time is added to the stage of the block profiler */
+            template<typename Handler>
+            auto with_profiler_stage(std::string stage, Handler handler) {
+                return [this, stage = std::move(stage), handler](auto &&... args) mutable {
+                    auto profile = _block_profiler.measure(stage);
+                    handler(std::forward<decltype(args)>(args)...);
+                };
+            }
+
+            /** Wraps a handler of applied_block, its time goes to the signal:applied_block:<plugin> stage */
+            template<typename Handler>
+            auto with_applied_block_profile(const std::string &plugin, Handler handler) {
+                return with_profiler_stage("signal:applied_block:" + plugin, std::move(handler));
+            }
+
+            /**
+             *  Wraps a handler of pre_apply_operation or post_apply_operation, so its time is accounted to the consumer
+             *  and to the signal:<consumer> stage of the block profiler
+             */
+            template<typename Handler>
+            auto with_operation_cost(const std::string &consumer, Handler handler) {
+                auto id = _operation_costs.add_consumer(consumer);
+                return with_profiler_stage("signal:" + consumer, [this, id, handler](auto &note) mutable {
+                    auto cost = _operation_costs.measure(id, note.op.which());
+                    handler(note);
+                });
+            }
 
             void set_skip_virtual_ops();
 
+            /** The notification of the operation applied by the current evaluator, evaluators store found objects in it */
+            operation_notification *current_operation_notification() {
+                return _current_operation_notification;
+            }
+
+            /**
+             *  Threads of the worker pool computing curation of comments paid out in a block,
+             *  0 means the number of cores, 1 disables batching
+             */
+            void set_comment_cashout_threads(uint32_t threads);
+
+            /** Skip per-block maintenance tasks, which have no due objects, it's enabled by default */
+            void set_maintenance_scheduler(bool);
+            std::vector<maintenance_task_statistics> get_maintenance_statistics() const;
+
+            /**
+             *  Threads of the worker pool checking signatures and authorities of block transactions before they
+             *  are applied, 0 means the number of cores, 1 checks transactions one by one when they are applied.
+             *  Operations are still applied one by one.
+             */
+            void set_transaction_check_threads(uint32_t threads);
+            transaction_check_statistics get_transaction_check_statistics() const;
+
+            /** Keep digests of indexes updated by each change of objects, it's disabled by default */
+            void set_state_digest(bool);
+            bool has_state_digest() const;
+
+            /**
+             *  @param block_num one of the last blocks, 0 is the head block
+             *  @return digests of indexes after the block
+             */
+            state_digest_info get_state_digest(uint32_t block_num = 0) const;
+
+            /** Computes digests of indexes from all their objects, it's slow and used to check the kept ones */
+            state_digest_info compute_state_digest() const;
+
             void set_store_account_metadata(store_metadata_modes store_account_metadata);
             void set_accounts_to_store_metadata(const std::vector<std::string>& accounts_to_store_metadata);
             bool store_metadata_for_account(const std::string& name) const;
@@ -206,6 +465,10 @@ namespace golos { namespace chain {
 
             const account_authority_object &get_authority(const account_name_type &name) const;
 
+            /** A copy of the authority, which stays valid until the authority is modified */
+            const authority &get_cached_authority(const account_name_type &name, authority::classification level) const;
+            authority_cache_statistics get_authority_cache_statistics() const;
+
             const dynamic_global_property_object &get_dynamic_global_properties() const;
 
             const feed_history_object &get_feed_history() const;
@@ -245,6 +508,14 @@ namespace golos { namespace chain {
 
             bool before_last_checkpoint() const;
 
+            /**
+             *  Below the last checkpoint, blocks become irreversible only when the chain reaches a checkpoint
+             *  with the matching id, instead of by witness confirmations.  Until then they stay in the fork
+             *  database with their undo history, so the blocks are committed and written to the block log
+             *  up to that checkpoint at once.  Witness signatures and schedule are still checked.
+             */
+            void set_checkpoint_trusted_sync(bool value);
+
             uint32_t validate_block(const signed_block &b, uint32_t skip = skip_nothing);
 
             bool push_block(const signed_block &b, uint32_t skip = skip_nothing);
@@ -296,6 +567,8 @@ namespace golos { namespace chain {
             inline const void push_virtual_operation(const operation &op, bool force = false); // vops are not needed for low mem. Force will push them on low mem.
             void notify_applied_block(const signed_block &block);
 
+            void notify_popped_block(const signed_block &block);
+
             void notify_on_pending_transaction(const signed_transaction &tx);
 
             void notify_on_applied_transaction(const signed_transaction &tx);
@@ -316,6 +589,12 @@ namespace golos { namespace chain {
              */
             fc::signal<void(const signed_block &)> applied_block;
 
+            /**
+             *  This signal is emitted after the head block has been popped and its changes have been undone,
+             *  the write lock is held.
+             */
+            fc::signal<void(const signed_block &)> popped_block;
+
             /**
              * This signal is emitted any time a new transaction is added to the pending
              * block state.
@@ -431,10 +710,18 @@ namespace golos { namespace chain {
 
             share_type pay_curators(const comment_curation_info& c, share_type max_rewards);
 
-            void cashout_comment_helper(const comment_object &comment);
+            /** @param curation_info precomputed curation of the comment, it's computed in place if it's nullptr */
+            void cashout_comment_helper(const comment_object &comment, const comment_curation_info *curation_info = nullptr);
 
             void process_comment_cashout();
 
+            /**
+             *  Pays out all comments due in the block at once: curation of the comments is computed in parallel
+             *  before the payouts, because the votes of a comment are changed only by its own cashout.
+             *  The payouts are applied in the order of the cashout index, so the result is the same as of one-by-one cashout.
+             */
+            void process_comment_cashout_batch();
+
             void process_funds();
 
             void process_conversions();
@@ -541,6 +828,12 @@ namespace golos { namespace chain {
 
             void set_flush_interval(uint32_t flush_blocks);
 
+            /**
+             * @brief Sync the shared memory file in background between the flushes of @ref set_flush_interval
+             * @param bytes_per_second rate of the background pass over the file, 0 means synchronous flushes only
+             */
+            void set_flush_state_rate(uint64_t bytes_per_second);
+
 #ifdef STEEMIT_BUILD_TESTNET
             bool liquidity_rewards_enabled = true;
             bool skip_price_feed_limit_check = true;
@@ -605,7 +898,17 @@ namespace golos { namespace chain {
 
             void apply_hardfork(uint32_t hardfork);
 
-            bool _resize(uint32_t block_num);
+            bool _resize(uint32_t block_num, uint64_t inc_size = 0);
+
+            void preallocate_shared_memory(uint64_t size);
+
+            void open_shared_memory(const fc::path &shared_mem_dir, uint32_t chainbase_flags, uint64_t shared_file_size);
+
+            void apply_shared_memory_policy();
+
+            void flush_state(uint32_t block_num);
+
+            void wait_shared_memory_preallocation();
 
             void pay_curator(const comment_vote_object& cvo, const uint64_t& claim, const account_name_type& author, const std::string& permlink);
 
@@ -630,6 +933,18 @@ namespace golos { namespace chain {
 
             fc::signal<void()> _plugin_index_signal;
 
+            std::vector<std::shared_ptr<abstract_snapshot_index>> _snapshot_indexes;
+
+            struct operation_consumer {
+                std::function<void()> clear;
+                operation_handler apply;
+            };
+
+            operation_source _operation_source;
+            std::map<std::string, operation_consumer> _operation_consumers;
+
+            std::vector<std::shared_ptr<abstract_index_memory_profiler>> _index_memory_profilers;
+
             transaction_id_type _current_trx_id;
             uint32_t _current_block_num = 0;
             uint16_t _current_trx_in_block = 0;
@@ -637,9 +952,13 @@ namespace golos { namespace chain {
             uint32_t _current_virtual_op = 0;
 
             flat_map<uint32_t, block_id_type> _checkpoints;
+            bool _checkpoint_trusted_sync = false;
 
             uint32_t _flush_blocks = 0;
             uint32_t _next_flush_block = 0;
+            uint64_t _flush_state_rate = 0;
+            uint64_t _flushed_state_pass = 0;
+            state_flusher _state_flusher;
 
             uint32_t _last_free_gb_printed = 0;
 
@@ -648,7 +967,71 @@ namespace golos { namespace chain {
 
             uint32_t _block_num_check_free_memory = 1000;
 
+            fc::path _shared_mem_dir;
+            uint32_t _shared_memory_growth_horizon = 0;
+            bool _preallocate_shared_memory = false;
+            uint64_t _last_used_memory = 0;
+            uint32_t _last_used_memory_block_num = 0;
+            std::future<void> _shared_memory_preallocation;
+            shared_memory_policy _shared_memory_policy;
+            shared_memory_resize_statistics _resize_statistics;
+
+            undo_operation_statistics &current_undo_statistics();
+
+            /** @return true if the object isn't in the undo state of the current session yet */
+            bool is_first_undo_copy(uint16_t type_id, int64_t id);
+
+            bool _undo_profiling = false;
+            /// the first item is the block processing, the others are indexed by operation::which() + 1
+            std::vector<undo_operation_statistics> _undo_statistics;
+            int _current_undo_operation = 0;
+            /// objects changed in the undo sessions by the revisions of the sessions
+            std::map<int64_t, std::set<std::pair<uint16_t, int64_t>>> _undo_copied_objects;
+
+            block_profiler _block_profiler;
+            /// stage names of evaluators indexed by operation::which()
+            std::vector<std::string> _evaluator_stage_names;
+
+            operation_cost_accounting _operation_costs;
+
+            /// maintenance tasks in the order of their registration
+            enum maintenance_task : size_t {
+                expired_proposals_task,
+                expired_orders_task,
+                expired_delegations_task,
+                conversions_task,
+                savings_withdraws_task,
+                account_recovery_task,
+                escrow_ratification_task,
+                decline_voting_rights_task
+            };
+
+            void initialize_maintenance_tasks();
+            void run_maintenance_task(maintenance_task task, void (database::*process)());
+
+            void check_block_transactions(const signed_block &next_block, uint32_t skip);
+
+            void add_state_digest(uint16_t type_id, uint64_t delta);
+            void initialize_state_digest();
+            void rebuild_state_digest();
+            void push_state_digest();
+            void pop_state_digest();
+            state_digest_info make_state_digest_info() const;
+
+            maintenance_scheduler _maintenance;
+            mutable authority_cache _authority_cache;
+            transaction_checker _transaction_checker;
+
+            operation_notification *_current_operation_notification = nullptr;
+
+            bool _state_digest = false;
+            /// digests after the last blocks, so diverged nodes can find the first different block
+            std::deque<state_digest_info> _state_digest_history;
+
             uint32_t _clear_votes_block = 0;
+            uint32_t _comment_cashout_threads = 0;
+            /// threads of the parallel stages of blocks, they are used under the write lock
+            worker_pool _worker_pool;
             bool _skip_virtual_ops = false;
             bool _enable_plugins_on_push_transaction = true;
 
@@ -662,3 +1045,12 @@ namespace golos { namespace chain {
         };
 
 } } // golos::chain
+
+FC_REFLECT((golos::chain::state_flush_marker), (block_num)(block_id)(revision)(time))
+
+FC_REFLECT((golos::chain::undo_operation_statistics),
+    (operation)(count)(created)(modified)(removed)(copied)(copied_size)(apply_time))
+
+FC_REFLECT((golos::chain::shared_memory_resize_statistics),
+    (resize_count)(total_resize_time)(max_resize_time)(last_resize_time)(last_resize_block_num)
+    (used_memory_per_block)(preallocated_size))
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+
+#include <boost/interprocess/containers/deque.hpp>
+#include <boost/interprocess/containers/flat_map.hpp>
+#include <boost/interprocess/containers/flat_set.hpp>
+#include <boost/interprocess/containers/string.hpp>
+#include <boost/interprocess/containers/vector.hpp>
+
+#include <type_traits>
+#include <utility>
+
+namespace golos { namespace chain {
+
+    namespace detail {
+
+        template<typename T>
+        struct dynamic_size_of {
+            struct member_visitor {
+                const T &value;
+                uint64_t &size;
+
+                template<typename Member, class Class, Member (Class::*member)>
+                void operator()(const char *) const {
+                    size += dynamic_size_of<Member>::get(value.*member);
+                }
+            };
+
+            using is_reflected = std::integral_constant<bool,
+                fc::reflector<T>::is_defined::value && !std::is_enum<T>::value>;
+
+            static uint64_t get(const T &v) {
+                return get(v, is_reflected());
+            }
+
+            static uint64_t get(const T &v, std::true_type) {
+                uint64_t size = 0;
+                fc::reflector<T>::visit(member_visitor{v, size});
+                return size;
+            }
+
+            static uint64_t get(const T &, std::false_type) {
+                return 0;
+            }
+        };
+
+        template<typename Container>
+        uint64_t elements_dynamic_size(const Container &c) {
+            uint64_t size = 0;
+            for (const auto &e: c) {
+                size += dynamic_size_of<typename Container::value_type>::get(e);
+            }
+            return size;
+        }
+
+        template<typename A, typename B>
+        struct dynamic_size_of<std::pair<A, B>> {
+            static uint64_t get(const std::pair<A, B> &v) {
+                return dynamic_size_of<A>::get(v.first) + dynamic_size_of<B>::get(v.second);
+            }
+        };
+
+        template<typename C, typename Tr, typename A>
+        struct dynamic_size_of<boost::interprocess::basic_string<C, Tr, A>> {
+            static uint64_t get(const boost::interprocess::basic_string<C, Tr, A> &v) {
+                // short strings are kept inside the object
+                uint64_t size = (v.capacity() + 1) * sizeof(C);
+                return size > sizeof(v) ? size : 0;
+            }
+        };
+
+        template<typename T, typename A>
+        struct dynamic_size_of<boost::interprocess::vector<T, A>> {
+            static uint64_t get(const boost::interprocess::vector<T, A> &v) {
+                return v.capacity() * sizeof(T) + elements_dynamic_size(v);
+            }
+        };
+
+        template<typename T, typename A>
+        struct dynamic_size_of<boost::interprocess::deque<T, A>> {
+            static uint64_t get(const boost::interprocess::deque<T, A> &v) {
+                return v.size() * sizeof(T) + elements_dynamic_size(v);
+            }
+        };
+
+        template<typename T, typename C, typename A>
+        struct dynamic_size_of<boost::interprocess::flat_set<T, C, A>> {
+            static uint64_t get(const boost::interprocess::flat_set<T, C, A> &v) {
+                return v.capacity() * sizeof(T) + elements_dynamic_size(v);
+            }
+        };
+
+        template<typename K, typename T, typename C, typename A>
+        struct dynamic_size_of<boost::interprocess::flat_map<K, T, C, A>> {
+            static uint64_t get(const boost::interprocess::flat_map<K, T, C, A> &v) {
+                using value_type = typename boost::interprocess::flat_map<K, T, C, A>::value_type;
+                return v.capacity() * sizeof(value_type) + elements_dynamic_size(v);
+            }
+        };
+
+    } // detail
+
+    /** Memory owned by the object outside of it: capacity of strings, buffers and interprocess containers */
+    template<typename T>
+    uint64_t dynamic_size(const T &v) {
+        return detail::dynamic_size_of<T>::get(v);
+    }
+
+} } // golos::chain
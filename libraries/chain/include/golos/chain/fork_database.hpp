@@ -4,9 +4,10 @@
 
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/member.hpp>
-#include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/mem_fun.hpp>
+#include <boost/pool/pool_alloc.hpp>
+
+#include <deque>
 
 
 namespace golos {
@@ -17,13 +18,22 @@ namespace golos {
         using golos::protocol::signed_block;
         using golos::protocol::block_id_type;
 
+        /**
+         *  The block is kept in the packed form, it's unpacked only when someone asks for it,
+         *  e.g. on switching forks or on API calls. Most blocks pass the fork database without unpacking.
+         */
         struct fork_item {
-            fork_item(signed_block d)
-                    : num(d.block_num()), id(d.id()), data(std::move(d)) {
-            }
+            fork_item(const signed_block &d);
 
             block_id_type previous_id() const {
-                return data.previous;
+                return previous;
+            }
+
+            /** Unpacks the block on each call, only the packed form is kept in the item */
+            signed_block data() const;
+
+            const std::vector<char> &packed_data() const {
+                return _packed;
             }
 
             weak_ptr<fork_item> prev;
@@ -34,11 +44,17 @@ namespace golos {
              */
             bool invalid = false;
             block_id_type id;
-            signed_block data;
+            block_id_type previous;
+
+        private:
+            std::vector<char> _packed;
         };
 
         typedef shared_ptr<fork_item> item_ptr;
 
+        /// fork_items and their control blocks are taken from a pool, they have the same size
+        typedef boost::fast_pool_allocator<fork_item> fork_item_allocator;
+
 
         /**
          *  As long as blocks are pushed in order the fork
@@ -95,29 +111,36 @@ namespace golos {
             shared_ptr<fork_item> fetch_block_on_main_branch_by_number(uint32_t block_num) const;
 
             struct block_id;
-            struct block_num;
-            struct by_previous;
             typedef multi_index_container<
                     item_ptr,
                     indexed_by<
-                            hashed_unique<tag<block_id>, member<fork_item, block_id_type, &fork_item::id>, std::hash<fc::ripemd160>>,
-                            hashed_non_unique<tag<by_previous>, const_mem_fun<fork_item, block_id_type, &fork_item::previous_id>, std::hash<fc::ripemd160>>,
-                            ordered_non_unique<tag<block_num>, member<fork_item, uint32_t, &fork_item::num>>
+                            hashed_unique<tag<block_id>, member<fork_item, block_id_type, &fork_item::id>, std::hash<fc::ripemd160>>
                     >
             > fork_multi_index_type;
 
             void set_max_size(uint32_t s);
 
+            /** @return number of blocks in the database */
+            size_t size() const {
+                return _index.size();
+            }
+
         private:
             /** @return a pointer to the newly pushed item */
             void _push_block(const item_ptr &b);
 
             void _push_next(const item_ptr &newly_inserted);
 
+            void _insert(const item_ptr &item);
+
             uint32_t _max_size = 1024;
 
-            fork_multi_index_type _unlinked_index;
+            /// blocks waiting for their previous block, there are few of them, so it's a plain vector
+            branch_type _unlinked;
             fork_multi_index_type _index;
+            /// blocks by number, the bucket of block N is _by_num[N - _first_num]
+            std::deque<branch_type> _by_num;
+            uint32_t _first_num = 0;
             shared_ptr<fork_item> _head;
         };
     }
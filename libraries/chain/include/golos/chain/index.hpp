@@ -1,6 +1,8 @@
 #pragma once
 
 #include <golos/chain/database.hpp>
+#include <golos/chain/index_memory.hpp>
+#include <golos/chain/state_snapshot.hpp>
 
 namespace golos {
     namespace chain {
@@ -8,6 +10,8 @@ namespace golos {
         template<typename MultiIndexType>
         void _add_index_impl(database &db) {
             db.add_index<MultiIndexType>();
+            db.add_snapshot_index(std::make_shared<snapshot_index<MultiIndexType>>());
+            db.add_index_memory_profiler(std::make_shared<index_memory_profiler<MultiIndexType>>());
         }
 
         template<typename MultiIndexType>
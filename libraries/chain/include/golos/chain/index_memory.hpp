@@ -0,0 +1,71 @@
+#pragma once
+
+#include <golos/chain/database.hpp>
+#include <golos/chain/dynamic_size.hpp>
+
+#include <boost/core/demangle.hpp>
+#include <boost/mpl/size.hpp>
+
+#include <typeinfo>
+
+namespace golos { namespace chain {
+
+    /**
+     *  Memory used by an index in the shared memory file. Sizes are estimated from the layout of the objects:
+     *  each node of the multi_index container keeps the object and three pointers per ordered index,
+     *  dynamic memory is the capacity of strings and containers owned by the objects.
+     */
+    struct index_memory_info {
+        std::string name;
+        uint64_t object_count = 0;
+        uint64_t object_size = 0;
+        uint64_t node_size = 0;
+        uint64_t dynamic_size = 0;
+        /// number of objects scanned for dynamic memory, the rest is extrapolated
+        uint64_t scanned_count = 0;
+    };
+
+    class abstract_index_memory_profiler {
+    public:
+        virtual ~abstract_index_memory_profiler() = default;
+
+        /**
+         *  @param sample_limit maximum number of objects to scan for dynamic memory, 0 means all objects
+         */
+        virtual index_memory_info profile(const database &db, uint64_t sample_limit) const = 0;
+    };
+
+    template<typename MultiIndexType>
+    class index_memory_profiler final : public abstract_index_memory_profiler {
+    public:
+        using object_type = typename MultiIndexType::value_type;
+
+        index_memory_info profile(const database &db, uint64_t sample_limit) const override {
+            const auto &indices = db.get_index<MultiIndexType>().indices();
+            constexpr uint64_t index_count = boost::mpl::size<typename MultiIndexType::index_type_list>::value;
+
+            index_memory_info info;
+            info.name = boost::core::demangle(typeid(object_type).name());
+            info.object_count = indices.size();
+            info.object_size = sizeof(object_type);
+            info.node_size = info.object_count * (sizeof(object_type) + index_count * 3 * sizeof(void *));
+
+            for (const auto &o: indices) {
+                if (sample_limit && info.scanned_count >= sample_limit) {
+                    break;
+                }
+                info.dynamic_size += dynamic_size(o);
+                ++info.scanned_count;
+            }
+
+            if (info.scanned_count && info.scanned_count < info.object_count) {
+                info.dynamic_size = info.dynamic_size * info.object_count / info.scanned_count;
+            }
+            return info;
+        }
+    };
+
+} } // golos::chain
+
+FC_REFLECT((golos::chain::index_memory_info),
+    (name)(object_count)(object_size)(node_size)(dynamic_size)(scanned_count))
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <golos/protocol/types.hpp>
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace golos { namespace chain {
+
+    struct maintenance_task_statistics {
+        std::string name;
+        fc::time_point_sec deadline;
+        uint64_t runs = 0;
+        uint64_t skips = 0;
+    };
+
+    /**
+     *  Keeps the earliest deadline of each maintenance task of a block, so the block skips tasks without due work.
+     *  A deadline is lowered when an object of a tracked type is created or modified, and it's taken from the index
+     *  after the task runs.  Deadlines only have to be not later than the real ones, removed objects just cause
+     *  an extra run.  Undone blocks can restore removed objects, so deadlines are reset when the block
+     *  isn't built on the last maintained one.
+     */
+    class maintenance_scheduler final {
+    public:
+        using deadline_getter = std::function<fc::time_point_sec(const void *)>;
+        /// returns the earliest deadline in the indexes of the task
+        using deadline_probe = std::function<fc::time_point_sec()>;
+
+        size_t add_task(const std::string &name, deadline_probe probe) {
+            _tasks.emplace_back();
+            _tasks.back().name = name;
+            _tasks.back().probe_stage = "probe:" + name;
+            _tasks.back().probe = std::move(probe);
+            return _tasks.size() - 1;
+        }
+
+        /** Deadlines of the task are lowered to the deadlines of created and modified objects of the type */
+        template<typename ObjectType, typename Getter>
+        void track(size_t task, Getter getter) {
+            if (_tracked.size() <= ObjectType::type_id) {
+                _tracked.resize(ObjectType::type_id + 1);
+            }
+            _tracked[ObjectType::type_id].push_back({task, [getter](const void *o) {
+                return fc::time_point_sec(getter(*static_cast<const ObjectType *>(o)));
+            }});
+        }
+
+        template<typename ObjectType>
+        void on_change(const ObjectType &o) {
+            if (ObjectType::type_id < _tracked.size()) {
+                for (const auto &t: _tracked[ObjectType::type_id]) {
+                    auto &deadline = _tasks[t.task].deadline;
+                    deadline = std::min(deadline, t.get(&o));
+                }
+            }
+        }
+
+        void set_enabled(bool value) {
+            _enabled = value;
+            reset();
+        }
+
+        bool enabled() const {
+            return _enabled;
+        }
+
+        /** Resets deadlines if the block doesn't follow the last maintained one */
+        void start_block(const protocol::block_id_type &previous, const protocol::block_id_type &id) {
+            if (previous != _last_block_id) {
+                reset();
+            }
+            _last_block_id = id;
+        }
+
+        /** All tasks are due in the next block */
+        void reset() {
+            for (auto &t: _tasks) {
+                t.deadline = fc::time_point_sec::min();
+            }
+            _last_block_id = protocol::block_id_type();
+        }
+
+        bool is_due(size_t task, fc::time_point_sec now) {
+            auto &t = _tasks[task];
+            if (!_enabled || t.deadline <= now) {
+                ++t.runs;
+                return true;
+            }
+            ++t.skips;
+            return false;
+        }
+
+        /** Takes the deadline from the indexes after the task runs */
+        void update_deadline(size_t task) {
+            _tasks[task].deadline = _tasks[task].probe();
+        }
+
+        const std::string &probe_stage(size_t task) const {
+            return _tasks[task].probe_stage;
+        }
+
+        std::vector<maintenance_task_statistics> get_statistics() const {
+            std::vector<maintenance_task_statistics> result;
+            for (const auto &t: _tasks) {
+                result.push_back({t.name, t.deadline, t.runs, t.skips});
+            }
+            return result;
+        }
+
+    private:
+        struct task {
+            std::string name;
+            std::string probe_stage;
+            deadline_probe probe;
+            fc::time_point_sec deadline = fc::time_point_sec::min();
+            uint64_t runs = 0;
+            uint64_t skips = 0;
+        };
+
+        struct tracked_type {
+            size_t task;
+            deadline_getter get;
+        };
+
+        bool _enabled = true;
+        std::vector<task> _tasks;
+        /// tracked types are indexed by the chainbase type id
+        std::vector<std::vector<tracked_type>> _tracked;
+        protocol::block_id_type _last_block_id;
+    };
+
+} } // golos::chain
+
+FC_REFLECT((golos::chain::maintenance_task_statistics), (name)(deadline)(runs)(skips))
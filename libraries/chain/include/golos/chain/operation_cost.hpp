@@ -0,0 +1,133 @@
+#pragma once
+
+#include <fc/reflect/reflect.hpp>
+#include <fc/time.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace golos { namespace chain {
+
+    struct operation_cost_statistics {
+        std::string operation;
+        std::string consumer;
+        uint64_t count = 0;
+        fc::microseconds time;
+        /// share of the consumer in the time of the operation type spent by all consumers, 10000 is 100%
+        uint16_t share = 0;
+    };
+
+    /**
+     *  Cumulative time and calls of operation handlers per operation type and consumer.  The core evaluators
+     *  are the first consumer, plugins are added when they wrap their handlers with database::with_operation_cost().
+     *  The time of an evaluator doesn't include the plugin handlers of virtual operations pushed by it.
+     *  It's used under the write lock of the database, its costs should be read under the read lock.
+     */
+    class operation_cost_accounting final {
+    public:
+        static constexpr size_t evaluator = 0;
+
+        struct cost {
+            uint64_t count = 0;
+            int64_t time = 0;
+        };
+
+        /** Adds its time to the cost, the time of scopes nested in it is accounted only to their costs */
+        class scope final {
+        public:
+            scope(operation_cost_accounting *owner, cost *c)
+                    : _owner(owner), _cost(c) {
+                if (_cost) {
+                    _owner->_nested_time.push_back(0);
+                    _start = fc::time_point::now();
+                }
+            }
+
+            scope(scope &&other)
+                    : _owner(other._owner), _cost(other._cost), _start(other._start) {
+                other._cost = nullptr;
+            }
+
+            scope(const scope &) = delete;
+
+            ~scope() {
+                if (_cost) {
+                    auto time = (fc::time_point::now() - _start).count();
+                    auto &nested = _owner->_nested_time;
+                    ++_cost->count;
+                    _cost->time += time - nested.back();
+                    nested.pop_back();
+                    if (!nested.empty()) {
+                        nested.back() += time;
+                    }
+                }
+            }
+
+        private:
+            operation_cost_accounting *_owner;
+            cost *_cost;
+            fc::time_point _start;
+        };
+
+        operation_cost_accounting() {
+            add_consumer("evaluator");
+        }
+
+        /** @return the id of the consumer, handlers of the same consumer share it */
+        size_t add_consumer(const std::string &name) {
+            auto itr = std::find(_consumers.begin(), _consumers.end(), name);
+            if (itr != _consumers.end()) {
+                return itr - _consumers.begin();
+            }
+            _consumers.push_back(name);
+            _costs.emplace_back();
+            return _consumers.size() - 1;
+        }
+
+        void enable(bool value) {
+            _enabled = value;
+        }
+
+        bool enabled() const {
+            return _enabled;
+        }
+
+        scope measure(size_t consumer, int operation) {
+            return scope(this, _enabled ? &get_cost(consumer, operation) : nullptr);
+        }
+
+        const std::vector<std::string> &consumers() const {
+            return _consumers;
+        }
+
+        /** @return costs of the consumer indexed by operation::which() */
+        const std::vector<cost> &costs(size_t consumer) const {
+            return _costs[consumer];
+        }
+
+        void reset() {
+            for (auto &c: _costs) {
+                c.clear();
+            }
+        }
+
+    private:
+        cost &get_cost(size_t consumer, int operation) {
+            auto &c = _costs[consumer];
+            if (c.size() <= size_t(operation)) {
+                c.resize(operation + 1);
+            }
+            return c[operation];
+        }
+
+        bool _enabled = false;
+        std::vector<std::string> _consumers;
+        std::vector<std::vector<cost>> _costs;
+        /// time of nested scopes per active scope, plugins handle virtual operations pushed by evaluators
+        std::vector<int64_t> _nested_time;
+    };
+
+} } // golos::chain
+
+FC_REFLECT((golos::chain::operation_cost_statistics), (operation)(consumer)(count)(time)(share))
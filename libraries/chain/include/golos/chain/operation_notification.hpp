@@ -19,6 +19,12 @@ struct operation_notification {
     uint16_t op_in_trx = 0;
     uint32_t virtual_op = 0;
     const operation& op;
+
+    /// objects found by the evaluator, so handlers of post_apply_operation don't search them again,
+    ///   they are set by evaluators of some operations (vote_operation) and are null in pre_apply_operation
+    const comment_object* comment = nullptr;
+    const account_object* account = nullptr;
+    const comment_vote_object* vote = nullptr;
 };
 
 } } // golos::chain
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+
+namespace golos { namespace chain {
+
+    /**
+     *  An immutable copy of some state, which is published at block boundaries under the write lock
+     *  and read by API calls without locking the database. Readers always get a consistent value
+     *  of the last published block, and they don't hold the writer while they are processing it.
+     *  Only the state in the view is read this way, other reads still take the read lock.
+     */
+    template<typename T>
+    class read_view final {
+    public:
+        using value_ptr = std::shared_ptr<const T>;
+
+        /** @return the last published value or nullptr if nothing is published */
+        value_ptr get() const {
+            return std::atomic_load(&_value);
+        }
+
+        void publish(T value) {
+            std::atomic_store(&_value, value_ptr(std::make_shared<const T>(std::move(value))));
+        }
+
+        void reset() {
+            std::atomic_store(&_value, value_ptr());
+        }
+
+    private:
+        value_ptr _value;
+    };
+
+} } // golos::chain
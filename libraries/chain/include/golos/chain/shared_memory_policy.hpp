@@ -0,0 +1,61 @@
+#pragma once
+
+#include <fc/filesystem.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <string>
+#include <vector>
+
+namespace golos { namespace chain {
+
+    /**
+     *  How pages of the shared memory file are placed. Tree walks of the indexes touch many pages,
+     *  huge pages reduce TLB misses, NUMA policy keeps the state close to the cores using it.
+     */
+    struct shared_memory_policy {
+        enum hugepages_mode {
+            hugepages_none,
+            /// madvise(MADV_HUGEPAGE), works for files on tmpfs with shmem_enabled=advise
+            hugepages_transparent,
+            /// shared-file-dir is on a hugetlbfs mount, sizes should be multiples of the huge page size
+            hugepages_hugetlbfs
+        };
+
+        enum numa_mode {
+            numa_none,
+            numa_interleave,
+            numa_bind
+        };
+
+        hugepages_mode hugepages = hugepages_none;
+        numa_mode numa = numa_none;
+        /// empty means all nodes
+        std::vector<uint32_t> numa_nodes;
+        /// page size of the hugetlbfs mount, it's set by @ref check_shared_memory_dir
+        uint64_t huge_page_size = 0;
+
+        /** Parses none|transparent|hugetlbfs */
+        static hugepages_mode parse_hugepages(const std::string &value);
+
+        /** Parses none|interleave[:nodes]|bind:nodes, where nodes is a comma separated list */
+        void parse_numa(const std::string &value);
+
+        /** Validates the directory and size of the shared memory file for the policy */
+        void check_shared_memory_dir(const fc::path &dir, uint64_t shared_file_size);
+
+        /** Rounds the size of the shared memory file up to the huge page size */
+        uint64_t align_size(uint64_t size) const;
+
+        /**
+         *  Applies the policy to the whole mapping of the file, which contains the address, with madvise and mbind.
+         *  Should be called after each remapping.
+         */
+        void apply_to_mapping(const void *addr) const;
+    };
+
+} } // golos::chain
+
+FC_REFLECT_ENUM(golos::chain::shared_memory_policy::hugepages_mode,
+    (hugepages_none)(hugepages_transparent)(hugepages_hugetlbfs))
+FC_REFLECT_ENUM(golos::chain::shared_memory_policy::numa_mode, (numa_none)(numa_interleave)(numa_bind))
+FC_REFLECT((golos::chain::shared_memory_policy), (hugepages)(numa)(numa_nodes))
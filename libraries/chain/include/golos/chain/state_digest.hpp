@@ -0,0 +1,90 @@
+#pragma once
+
+#include <golos/chain/steem_object_types.hpp>
+
+#include <chainbase/chainbase.hpp>
+
+#include <fc/crypto/city.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace golos { namespace chain {
+
+    namespace bip = boost::interprocess;
+
+    namespace detail {
+        template<typename ObjectType>
+        uint64_t object_digest(const ObjectType &o, std::true_type) {
+            auto data = fc::raw::pack(o);
+            return fc::city_hash64(data.data(), data.size());
+        }
+
+        template<typename ObjectType>
+        uint64_t object_digest(const ObjectType &, std::false_type) {
+            return 0;
+        }
+    }
+
+    /** Hash of the packed object, objects without reflection don't change the state digest */
+    template<typename ObjectType>
+    uint64_t object_digest(const ObjectType &o) {
+        return detail::object_digest(o,
+            std::integral_constant<bool, fc::reflector<ObjectType>::is_defined::value>());
+    }
+
+    /**
+     *  Digests of chainbase indexes.  The digest of an index is the sum of the digests of its objects modulo 2^64,
+     *  so it's updated on each create, modify and remove without reading other objects and doesn't depend
+     *  on the order of changes.  It's kept in the state, so it follows undone blocks.
+     */
+    class state_digest_object final : public object<state_digest_object_type, state_digest_object> {
+    public:
+        using digest_allocator_type = allocator<std::pair<uint16_t, uint64_t>>;
+        using digest_map_type = bip::flat_map<uint16_t, uint64_t, std::less<uint16_t>, digest_allocator_type>;
+
+        state_digest_object() = delete;
+
+        template<typename Constructor, typename Allocator>
+        state_digest_object(Constructor &&c, allocator<Allocator> a)
+                : indexes(digest_allocator_type(a.get_segment_manager())) {
+            c(*this);
+        }
+
+        id_type id;
+
+        /// digests by the type id of the index objects
+        digest_map_type indexes;
+    };
+
+    using state_digest_index = multi_index_container<
+        state_digest_object,
+        indexed_by<
+            ordered_unique<
+                tag<by_id>,
+                member<state_digest_object, state_digest_id_type, &state_digest_object::id>>>,
+        allocator<state_digest_object>>;
+
+    struct index_digest {
+        std::string name;
+        uint16_t type_id = 0;
+        uint64_t digest = 0;
+    };
+
+    struct state_digest_info {
+        uint32_t block_num = 0;
+        block_id_type block_id;
+        /// hash of the index digests, it's equal on nodes with the same state and set of indexes
+        uint64_t digest = 0;
+        std::vector<index_digest> indexes;
+    };
+
+} } // golos::chain
+
+FC_REFLECT((golos::chain::index_digest), (name)(type_id)(digest))
+FC_REFLECT((golos::chain::state_digest_info), (block_num)(block_id)(digest)(indexes))
+
+CHAINBASE_SET_INDEX_TYPE(golos::chain::state_digest_object, golos::chain::state_digest_index)
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <fc/time.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace golos { namespace chain {
+
+    /**
+     *  Writes dirty pages of the shared memory file to disk in a background thread.
+     *  The mapping is synced chunk by chunk with a bounded rate, so a flush at a block boundary
+     *  only has to write the pages changed since the last full pass.
+     */
+    class state_flusher final {
+    public:
+        struct region {
+            char *addr = nullptr;
+            uint64_t size = 0;
+        };
+
+        state_flusher() = default;
+
+        ~state_flusher();
+
+        /**
+         * @param get_region returns the current mapping, it's called with the pause lock held
+         * @param chunk_size bytes synced at once
+         * @param rate maximum bytes per second walked by the flusher
+         */
+        void start(std::function<region()> get_region, uint64_t chunk_size, uint64_t rate);
+
+        void stop();
+
+        bool is_running() const;
+
+        /** Holds the flusher between chunks, should be locked while the file is remapped */
+        std::unique_lock<std::mutex> pause();
+
+        /** Number of passes over the whole file completed since the start */
+        uint64_t completed_passes() const;
+
+        /** Time spent in msync by the background thread */
+        fc::microseconds total_sync_time() const;
+
+    private:
+        void run();
+
+        std::function<region()> _get_region;
+        uint64_t _chunk_size = 0;
+        uint64_t _rate = 0;
+
+        std::thread _thread;
+        std::mutex _region_mutex;
+        std::mutex _stop_mutex;
+        std::condition_variable _stop_cv;
+        bool _stop = false;
+
+        std::atomic<uint64_t> _completed_passes{0};
+        std::atomic<int64_t> _total_sync_time{0};
+    };
+
+} } // golos::chain
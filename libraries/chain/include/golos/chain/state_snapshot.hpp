@@ -0,0 +1,168 @@
+#pragma once
+
+#include <golos/chain/database.hpp>
+#include <golos/chain/state_digest.hpp>
+
+#include <fc/crypto/sha256.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/optional.hpp>
+
+#include <boost/core/demangle.hpp>
+
+#include <istream>
+#include <ostream>
+#include <typeinfo>
+
+namespace golos { namespace chain {
+
+    /**
+     *  A snapshot is a directory with a manifest and one file per chainbase index.  The index file is
+     *  a stream of [uint32_t size][fc::raw packed object] records in the order of object ids,
+     *  so it can be written and loaded without keeping the index in memory.
+     */
+    constexpr uint32_t snapshot_version = 1;
+
+    struct snapshot_index_info {
+        std::string name;
+        std::string file;
+        uint64_t object_count = 0;
+        /// sha256 of the index file
+        fc::sha256 digest;
+        /// digest of the index in the state, it's checked against the loaded objects
+        fc::optional<uint64_t> state_digest;
+    };
+
+    struct snapshot_manifest {
+        uint32_t version = 0;
+        chain_id_type chain_id;
+        uint32_t head_block_num = 0;
+        block_id_type head_block_id;
+        fc::time_point_sec head_block_time;
+        std::vector<snapshot_index_info> indexes;
+    };
+
+    class abstract_snapshot_index {
+    public:
+        virtual ~abstract_snapshot_index() = default;
+
+        virtual const std::string &name() const = 0;
+
+        virtual uint16_t type_id() const = 0;
+
+        /** Sum of digests of all objects of the index, the database must be locked for reading */
+        virtual uint64_t state_digest(const database &db) const = 0;
+
+        /** Writes all objects of the index, the database must be locked for reading */
+        virtual void write(const database &db, std::ostream &out, snapshot_index_info &info) const = 0;
+
+        /** Inserts objects into the empty index keeping their ids, the database must be locked for writing */
+        virtual void read(database &db, std::istream &in, const snapshot_index_info &info) const = 0;
+    };
+
+    template<typename MultiIndexType>
+    class snapshot_index final : public abstract_snapshot_index {
+    public:
+        using object_type = typename MultiIndexType::value_type;
+
+        static_assert(fc::reflector<object_type>::is_defined::value,
+            "Objects of chainbase indexes should be reflected with all their fields to be written to snapshots");
+
+        snapshot_index()
+                : _name(boost::core::demangle(typeid(object_type).name())) {
+        }
+
+        const std::string &name() const override {
+            return _name;
+        }
+
+        uint16_t type_id() const override {
+            return object_type::type_id;
+        }
+
+        uint64_t state_digest(const database &db) const override {
+            uint64_t result = 0;
+            for (const auto &o: db.get_index<MultiIndexType>().indices()) {
+                result += object_digest(o);
+            }
+            return result;
+        }
+
+        void write(const database &db, std::ostream &out, snapshot_index_info &info) const override {
+            fc::sha256::encoder digest;
+            std::vector<char> buffer;
+            uint64_t state_digest = 0;
+
+            info.object_count = 0;
+            for (const auto &o: db.get_index<MultiIndexType>().indices()) {
+                buffer = fc::raw::pack(o);
+                uint32_t size = buffer.size();
+                // the same as object_digest() without packing the object again
+                state_digest += fc::city_hash64(buffer.data(), buffer.size());
+
+                out.write((const char *)&size, sizeof(size));
+                out.write(buffer.data(), size);
+                digest.write((const char *)&size, sizeof(size));
+                digest.write(buffer.data(), size);
+                ++info.object_count;
+            }
+
+            FC_ASSERT(out.good(), "Failed to write snapshot of ${index}", ("index", _name));
+            info.digest = digest.result();
+            info.state_digest = state_digest;
+        }
+
+        void read(database &db, std::istream &in, const snapshot_index_info &info) const override {
+            FC_ASSERT(db.get_index<MultiIndexType>().indices().empty(),
+                "Index ${index} should be empty to load a snapshot", ("index", _name));
+
+            fc::sha256::encoder digest;
+            std::vector<char> buffer;
+            uint64_t state_digest = 0;
+
+            for (uint64_t i = 0; i < info.object_count; ++i) {
+                uint32_t size = 0;
+                in.read((char *)&size, sizeof(size));
+                buffer.resize(size);
+                in.read(buffer.data(), size);
+                FC_ASSERT(in.good(), "Unexpected end of snapshot of ${index}", ("index", _name));
+                digest.write((const char *)&size, sizeof(size));
+                digest.write(buffer.data(), size);
+
+                // chainbase hands out ids sequentially and can't skip them, so the ids freed by removed objects
+                //   are skipped by creating and removing placeholders with the content of the next object,
+                //   it doesn't collide in unique indexes, because the object isn't created yet
+                while (true) {
+                    int64_t stored_id = 0;
+                    const auto &o = db.create<object_type>([&](object_type &obj) {
+                        auto assigned_id = obj.id;
+                        fc::datastream<const char *> ds(buffer.data(), buffer.size());
+                        fc::raw::unpack(ds, obj);
+                        stored_id = obj.id._id;
+                        obj.id = assigned_id;
+                    });
+
+                    if (o.id._id == stored_id) {
+                        state_digest += object_digest(o);
+                        break;
+                    }
+                    FC_ASSERT(o.id._id < stored_id, "Objects of ${index} are not ordered by id in the snapshot",
+                        ("index", _name)("id", stored_id)("next_id", o.id._id));
+                    db.remove(o);
+                }
+            }
+
+            FC_ASSERT(digest.result() == info.digest, "Snapshot of ${index} is corrupted", ("index", _name));
+            FC_ASSERT(!info.state_digest.valid() || *info.state_digest == state_digest,
+                "Objects of ${index} loaded from the snapshot differ from the written ones",
+                ("index", _name)("digest", state_digest)("expected", info.state_digest));
+        }
+
+    private:
+        std::string _name;
+    };
+
+} } // golos::chain
+
+FC_REFLECT((golos::chain::snapshot_index_info), (name)(file)(object_count)(digest)(state_digest))
+FC_REFLECT((golos::chain::snapshot_manifest),
+    (version)(chain_id)(head_block_num)(head_block_id)(head_block_time)(indexes))
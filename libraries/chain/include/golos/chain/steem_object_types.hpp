@@ -7,6 +7,11 @@
 
 #include <chainbase/chainbase.hpp>
 
+#include <boost/interprocess/containers/deque.hpp>
+#include <boost/interprocess/containers/flat_map.hpp>
+#include <boost/interprocess/containers/flat_set.hpp>
+#include <boost/interprocess/containers/vector.hpp>
+
 #include <golos/protocol/types.hpp>
 #include <golos/protocol/authority.hpp>
 
@@ -70,7 +75,8 @@ namespace golos { namespace chain {
             vesting_delegation_expiration_object_type,
             account_metadata_object_type,
             proposal_object_type,
-            required_approval_object_type
+            required_approval_object_type,
+            state_digest_object_type
         };
 
         class dynamic_global_property_object;
@@ -103,6 +109,7 @@ namespace golos { namespace chain {
         class vesting_delegation_expiration_object;
         class account_metadata_object;
         class proposal_object;
+        class state_digest_object;
 
         typedef object_id<dynamic_global_property_object> dynamic_global_property_id_type;
         typedef object_id<account_object> account_id_type;
@@ -133,6 +140,7 @@ namespace golos { namespace chain {
         typedef object_id<account_metadata_object> account_metadata_id_type;
         typedef object_id<proposal_object> proposal_object_id_type;
         typedef object_id<required_approval_object> required_approval_object_id_type;
+        typedef object_id<state_digest_object> state_digest_id_type;
 
         enum bandwidth_type {
             post,         ///< Rate limiting posting reward eligibility over time
@@ -175,6 +183,113 @@ namespace fc {
         inline void unpack(Stream &s, chainbase::object_id<T> &id, uint32_t = 0) {
             s.read((char *)&id._id, sizeof(id._id));
         }
+
+        // containers in shared memory are packed the same way as their std counterparts,
+        //   unpacking expects the container to be already constructed with its allocator
+
+        template<typename Stream>
+        inline void pack(Stream &s, const golos::chain::shared_string &v) {
+            pack(s, unsigned_int((uint32_t)v.size()));
+            if (v.size()) {
+                s.write(v.data(), v.size());
+            }
+        }
+
+        template<typename Stream>
+        inline void unpack(Stream &s, golos::chain::shared_string &v, uint32_t = 0) {
+            unsigned_int size;
+            unpack(s, size);
+            v.resize(size.value);
+            if (size.value) {
+                s.read(&v[0], size.value);
+            }
+        }
+
+        template<typename Stream, typename T, typename A>
+        inline void pack(Stream &s, const boost::interprocess::vector<T, A> &v) {
+            pack(s, unsigned_int((uint32_t)v.size()));
+            for (const auto &item : v) {
+                pack(s, item);
+            }
+        }
+
+        template<typename Stream, typename T, typename A>
+        inline void unpack(Stream &s, boost::interprocess::vector<T, A> &v, uint32_t depth = 0) {
+            unsigned_int size;
+            unpack(s, size);
+            v.clear();
+            v.reserve(size.value);
+            for (uint32_t i = 0; i < size.value; ++i) {
+                T item;
+                unpack(s, item, depth);
+                v.push_back(std::move(item));
+            }
+        }
+
+        template<typename Stream, typename T, typename A>
+        inline void pack(Stream &s, const boost::interprocess::deque<T, A> &v) {
+            pack(s, unsigned_int((uint32_t)v.size()));
+            for (const auto &item : v) {
+                pack(s, item);
+            }
+        }
+
+        template<typename Stream, typename T, typename A>
+        inline void unpack(Stream &s, boost::interprocess::deque<T, A> &v, uint32_t depth = 0) {
+            unsigned_int size;
+            unpack(s, size);
+            v.clear();
+            for (uint32_t i = 0; i < size.value; ++i) {
+                T item;
+                unpack(s, item, depth);
+                v.push_back(std::move(item));
+            }
+        }
+
+        template<typename Stream, typename K, typename C, typename A>
+        inline void pack(Stream &s, const boost::interprocess::flat_set<K, C, A> &v) {
+            pack(s, unsigned_int((uint32_t)v.size()));
+            for (const auto &item : v) {
+                pack(s, item);
+            }
+        }
+
+        template<typename Stream, typename K, typename C, typename A>
+        inline void unpack(Stream &s, boost::interprocess::flat_set<K, C, A> &v, uint32_t depth = 0) {
+            unsigned_int size;
+            unpack(s, size);
+            v.clear();
+            v.reserve(size.value);
+            for (uint32_t i = 0; i < size.value; ++i) {
+                K item;
+                unpack(s, item, depth);
+                v.insert(v.end(), std::move(item));
+            }
+        }
+
+        template<typename Stream, typename K, typename V, typename C, typename A>
+        inline void pack(Stream &s, const boost::interprocess::flat_map<K, V, C, A> &v) {
+            pack(s, unsigned_int((uint32_t)v.size()));
+            for (const auto &item : v) {
+                pack(s, item.first);
+                pack(s, item.second);
+            }
+        }
+
+        template<typename Stream, typename K, typename V, typename C, typename A>
+        inline void unpack(Stream &s, boost::interprocess::flat_map<K, V, C, A> &v, uint32_t depth = 0) {
+            unsigned_int size;
+            unpack(s, size);
+            v.clear();
+            v.reserve(size.value);
+            for (uint32_t i = 0; i < size.value; ++i) {
+                K key;
+                V value;
+                unpack(s, key, depth);
+                unpack(s, value, depth);
+                v.insert(v.end(), std::make_pair(std::move(key), std::move(value)));
+            }
+        }
     }
 
     namespace raw {
@@ -234,6 +349,7 @@ FC_REFLECT_ENUM(golos::chain::object_type,
                 (account_metadata_object_type)
                 (proposal_object_type)
                 (required_approval_object_type)
+                (state_digest_object_type)
 )
 
 FC_REFLECT_TYPENAME((golos::chain::shared_string))
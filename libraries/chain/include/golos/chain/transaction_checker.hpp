@@ -0,0 +1,99 @@
+#pragma once
+
+#include <golos/chain/account_object.hpp>
+#include <golos/protocol/transaction.hpp>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <utility>
+#include <vector>
+
+namespace golos { namespace chain {
+
+    struct transaction_check_statistics {
+        /// transactions checked before their blocks
+        uint64_t checked = 0;
+        /// checks used by transactions instead of the serial ones
+        uint64_t passed = 0;
+        /// checks, which read authorities modified by earlier transactions of the block
+        uint64_t conflicts = 0;
+        /// checks, which threw, the transactions are checked again to get the same error
+        uint64_t failed = 0;
+    };
+
+    /**
+     *  Results of the validation, signature and authority checks of block transactions, which are done by several
+     *  threads against the state before the block.  Each check keeps the read set of authorities with their
+     *  revisions.  A transaction uses its check only when the read set wasn't modified by earlier transactions
+     *  of the block, otherwise it's checked again when it's applied, so the result equals the serial one.
+     *  It's the only place where signatures of block transactions are recovered in parallel, operations
+     *  aren't applied speculatively.
+     */
+    class transaction_checker final {
+    public:
+        struct check {
+            const protocol::signed_transaction *trx = nullptr;
+            bool valid = false;
+            std::vector<std::pair<const account_authority_object *, uint32_t>> reads;
+        };
+
+        /** 0 means the number of cores, 1 disables checks */
+        void set_threads(uint32_t threads) {
+            _threads = threads;
+        }
+
+        uint32_t threads() const {
+            return _threads;
+        }
+
+        bool enabled() const {
+            return _threads != 1;
+        }
+
+        std::vector<check> &start_block(const std::vector<protocol::signed_transaction> &transactions) {
+            _checks.clear();
+            _checks.resize(transactions.size());
+            for (size_t i = 0; i < transactions.size(); ++i) {
+                _checks[i].trx = &transactions[i];
+            }
+            _statistics.checked += transactions.size();
+            return _checks;
+        }
+
+        /** @return true if the transaction at the position in the block passed its check, which isn't conflicting */
+        bool passed(const protocol::signed_transaction &trx, size_t index) {
+            if (index >= _checks.size() || _checks[index].trx != &trx) {
+                return false;
+            }
+            const auto &c = _checks[index];
+            if (!c.valid) {
+                ++_statistics.failed;
+                return false;
+            }
+            for (const auto &r: c.reads) {
+                if (r.first->revision != r.second) {
+                    ++_statistics.conflicts;
+                    return false;
+                }
+            }
+            ++_statistics.passed;
+            return true;
+        }
+
+        void reset() {
+            _checks.clear();
+        }
+
+        const transaction_check_statistics &get_statistics() const {
+            return _statistics;
+        }
+
+    private:
+        uint32_t _threads = 1;
+        std::vector<check> _checks;
+        transaction_check_statistics _statistics;
+    };
+
+} } // golos::chain
+
+FC_REFLECT((golos::chain::transaction_check_statistics), (checked)(passed)(conflicts)(failed))
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace golos { namespace chain {
+
+    /**
+     *  Threads shared by the parallel stages of block application (curation of paid out comments, checks of
+     *  block transactions).  They are started on the first use and wait for the next job between blocks,
+     *  so a block doesn't pay for creating threads.  The calling thread works on the job too.
+     */
+    class worker_pool final {
+    public:
+        using task_type = std::function<void(size_t)>;
+
+        worker_pool() = default;
+
+        ~worker_pool();
+
+        worker_pool(const worker_pool &) = delete;
+
+        worker_pool &operator=(const worker_pool &) = delete;
+
+        /**
+         *  Calls the task for each index from 0 to count, returns when all calls are done
+         *  @param threads maximum threads working on the job including the caller, 0 means the number of cores
+         *  @throw the first exception thrown by the task, the remaining indexes aren't processed then
+         */
+        void run(size_t count, uint32_t threads, const task_type &task);
+
+        /** Number of started threads, the caller isn't counted */
+        size_t size() const;
+
+    private:
+        struct job {
+            const task_type *task = nullptr;
+            size_t count = 0;
+            size_t next = 0;
+            /// threads which may still join the job
+            uint32_t free_slots = 0;
+            /// helpers working on the job
+            uint32_t running = 0;
+            std::exception_ptr error;
+        };
+
+        void work(job &j, std::unique_lock<std::mutex> &lock);
+
+        void thread_main();
+
+        mutable std::mutex _mutex;
+        std::condition_variable _job_cv;
+        std::condition_variable _done_cv;
+        std::vector<std::thread> _threads;
+        job *_job = nullptr;
+        bool _stop = false;
+    };
+
+} } // golos::chain
@@ -0,0 +1,18 @@
+#include <golos/chain/index_memory.hpp>
+
+namespace golos { namespace chain {
+
+    void database::add_index_memory_profiler(std::shared_ptr<abstract_index_memory_profiler> profiler) {
+        _index_memory_profilers.push_back(std::move(profiler));
+    }
+
+    std::vector<index_memory_info> database::get_index_memory_statistics(uint64_t sample_limit) const {
+        std::vector<index_memory_info> result;
+        result.reserve(_index_memory_profilers.size());
+        for (const auto &profiler: _index_memory_profilers) {
+            result.push_back(profiler->profile(*this, sample_limit));
+        }
+        return result;
+    }
+
+} } // golos::chain
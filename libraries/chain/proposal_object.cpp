@@ -59,15 +59,15 @@ namespace golos { namespace chain {
         auto ops = operations();
 
         auto get_active = [&](const account_name_type& name) {
-            return authority(db.get_authority(name).active);
+            return &db.get_cached_authority(name, authority::active);
         };
 
         auto get_owner = [&](const account_name_type& name) {
-            return authority(db.get_authority(name).owner);
+            return &db.get_cached_authority(name, authority::owner);
         };
 
         auto get_posting = [&](const account_name_type& name) {
-            return authority(db.get_authority(name).posting);
+            return &db.get_cached_authority(name, authority::posting);
         };
 
         golos::protocol::verify_authority(
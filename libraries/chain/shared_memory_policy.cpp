@@ -0,0 +1,209 @@
+#include <golos/chain/shared_memory_policy.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/fstream.hpp>
+#include <fc/log/logger.hpp>
+
+#include <boost/algorithm/string.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace golos { namespace chain {
+
+    namespace {
+        constexpr uint32_t max_numa_nodes = 1024;
+
+#ifdef __linux__
+        constexpr long hugetlbfs_magic = 0x958458f6;
+
+        std::vector<unsigned long> numa_node_mask(const std::vector<uint32_t> &nodes) {
+            constexpr uint32_t bits = sizeof(unsigned long) * 8;
+            std::vector<unsigned long> mask(max_numa_nodes / bits, nodes.empty() ? ~0ul : 0ul);
+            for (auto node: nodes) {
+                mask[node / bits] |= 1ul << (node % bits);
+            }
+            return mask;
+        }
+
+        int numa_mpol_mode(shared_memory_policy::numa_mode mode) {
+            return mode == shared_memory_policy::numa_bind ? MPOL_BIND : MPOL_INTERLEAVE;
+        }
+
+        /**
+         *  Finds the mapping of the file, which contains the address.  The mapping can be split by the kernel
+         *  into several areas with different attributes, so the adjacent areas of the same file are joined.
+         */
+        bool find_mapping(uintptr_t addr, uintptr_t &begin, uintptr_t &end) {
+            struct area {
+                uintptr_t begin;
+                uintptr_t end;
+                std::string inode;
+            };
+
+            std::vector<area> areas;
+            std::ifstream maps("/proc/self/maps");
+            std::string line;
+            while (std::getline(maps, line)) {
+                // begin-end perms offset dev inode path
+                std::vector<std::string> fields;
+                boost::split(fields, line, boost::is_any_of(" "), boost::token_compress_on);
+                auto dash = fields[0].find('-');
+                if (fields.size() < 5 || dash == std::string::npos) {
+                    continue;
+                }
+                areas.push_back({
+                    std::stoull(fields[0].substr(0, dash), nullptr, 16),
+                    std::stoull(fields[0].substr(dash + 1), nullptr, 16),
+                    fields[3] + ":" + fields[4]});
+            }
+
+            for (size_t i = 0; i < areas.size(); ++i) {
+                if (areas[i].begin > addr || addr >= areas[i].end) {
+                    continue;
+                }
+                auto first = i;
+                while (first > 0 && areas[first - 1].end == areas[first].begin &&
+                       areas[first - 1].inode == areas[i].inode
+                ) {
+                    --first;
+                }
+                auto last = i;
+                while (last + 1 < areas.size() && areas[last + 1].begin == areas[last].end &&
+                       areas[last + 1].inode == areas[i].inode
+                ) {
+                    ++last;
+                }
+                begin = areas[first].begin;
+                end = areas[last].end;
+                return true;
+            }
+            return false;
+        }
+#endif
+    }
+
+    shared_memory_policy::hugepages_mode shared_memory_policy::parse_hugepages(const std::string &value) {
+        if (value == "none") {
+            return hugepages_none;
+        } else if (value == "transparent") {
+            return hugepages_transparent;
+        } else if (value == "hugetlbfs") {
+            return hugepages_hugetlbfs;
+        }
+        FC_THROW_EXCEPTION(fc::invalid_arg_exception,
+            "Unknown huge pages mode ${v}, expected none, transparent or hugetlbfs", ("v", value));
+    }
+
+    void shared_memory_policy::parse_numa(const std::string &value) {
+        auto pos = value.find(':');
+        auto mode = value.substr(0, pos);
+
+        numa_nodes.clear();
+        if (pos != std::string::npos) {
+            std::vector<std::string> nodes;
+            auto list = value.substr(pos + 1);
+            boost::split(nodes, list, boost::is_any_of(","));
+            for (const auto &node: nodes) {
+                auto n = std::stoul(node);
+                FC_ASSERT(n < max_numa_nodes, "Invalid NUMA node ${n}", ("n", node));
+                numa_nodes.push_back(n);
+            }
+        }
+
+        if (mode == "none") {
+            numa = numa_none;
+        } else if (mode == "interleave") {
+            numa = numa_interleave;
+        } else if (mode == "bind") {
+            FC_ASSERT(!numa_nodes.empty(), "NUMA nodes are required for the bind policy, e.g. bind:0");
+            numa = numa_bind;
+        } else {
+            FC_THROW_EXCEPTION(fc::invalid_arg_exception,
+                "Unknown NUMA policy ${v}, expected none, interleave[:nodes] or bind:nodes", ("v", value));
+        }
+    }
+
+    void shared_memory_policy::check_shared_memory_dir(const fc::path &dir, uint64_t shared_file_size) {
+        huge_page_size = 0;
+        if (hugepages != hugepages_hugetlbfs) {
+            return;
+        }
+#ifdef __linux__
+        struct statfs fs;
+        FC_ASSERT(::statfs(dir.string().c_str(), &fs) == 0,
+            "Can't get file system of ${dir}: ${e}", ("dir", dir)("e", std::strerror(errno)));
+        FC_ASSERT(long(fs.f_type) == hugetlbfs_magic,
+            "Shared memory directory ${dir} isn't on a hugetlbfs mount", ("dir", dir));
+
+        uint64_t page_size = fs.f_bsize;
+        FC_ASSERT(shared_file_size % page_size == 0,
+            "Size of shared memory file should be a multiple of the huge page size ${p}",
+            ("p", page_size)("size", shared_file_size));
+        huge_page_size = page_size;
+        ilog("Shared memory file is on hugetlbfs with ${p}K pages", ("p", page_size / 1024));
+#else
+        FC_THROW("Huge pages are supported only on Linux");
+#endif
+    }
+
+    uint64_t shared_memory_policy::align_size(uint64_t size) const {
+        if (huge_page_size == 0) {
+            return size;
+        }
+        return (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+    }
+
+    void shared_memory_policy::apply_to_mapping(const void *addr) const {
+        if (hugepages == hugepages_none && numa == numa_none) {
+            return;
+        }
+#ifdef __linux__
+        uintptr_t begin = 0;
+        uintptr_t end = 0;
+        if (!find_mapping(reinterpret_cast<uintptr_t>(addr), begin, end)) {
+            wlog("Can't find the mapping of shared memory file to apply its policy");
+            return;
+        }
+        uint64_t size = end - begin;
+
+        if (hugepages == hugepages_transparent) {
+            if (::madvise(reinterpret_cast<void *>(begin), size, MADV_HUGEPAGE) != 0) {
+                wlog("Can't enable transparent huge pages for shared memory: ${e}", ("e", std::strerror(errno)));
+            } else {
+                const fc::path shmem_enabled_file("/sys/kernel/mm/transparent_hugepage/shmem_enabled");
+                std::string shmem_enabled;
+                if (fc::exists(shmem_enabled_file)) {
+                    fc::read_file_contents(shmem_enabled_file, shmem_enabled);
+                }
+                if (shmem_enabled.find("[never]") != std::string::npos ||
+                    shmem_enabled.find("[deny]") != std::string::npos
+                ) {
+                    wlog("Transparent huge pages are disabled for shared memory by the kernel, "
+                         "set /sys/kernel/mm/transparent_hugepage/shmem_enabled to advise");
+                }
+            }
+        }
+
+        // only the pages of the mapping follow the policy, memory of the threads isn't affected
+        if (numa != numa_none) {
+            auto mask = numa_node_mask(numa_nodes);
+            if (::syscall(SYS_mbind, begin, size, numa_mpol_mode(numa), mask.data(), max_numa_nodes + 1, 0) != 0) {
+                wlog("Can't set NUMA policy for shared memory: ${e}", ("e", std::strerror(errno)));
+            }
+        }
+#else
+        wlog("Huge pages and NUMA policy are supported only on Linux");
+#endif
+    }
+
+} } // golos::chain
@@ -0,0 +1,154 @@
+#include <golos/chain/state_digest.hpp>
+#include <golos/chain/state_snapshot.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace golos { namespace chain {
+
+    namespace {
+        /// blocks, which digests are kept in memory
+        constexpr size_t state_digest_history_size = 1200;
+
+        /// empty indexes aren't hashed, so nodes with different sets of empty plugin indexes have equal digests
+        uint64_t combine_digests(const std::vector<index_digest> &indexes) {
+            std::vector<std::pair<uint16_t, uint64_t>> digests;
+            for (const auto &i: indexes) {
+                if (i.digest) {
+                    digests.emplace_back(i.type_id, i.digest);
+                }
+            }
+            std::sort(digests.begin(), digests.end());
+
+            auto data = fc::raw::pack(digests);
+            return fc::city_hash64(data.data(), data.size());
+        }
+    }
+
+    void database::set_state_digest(bool value) {
+        _state_digest = value;
+    }
+
+    bool database::has_state_digest() const {
+        return _state_digest;
+    }
+
+    void database::add_state_digest(uint16_t type_id, uint64_t delta) {
+        if (delta == 0) {
+            return;
+        }
+        // it's missing while a snapshot is loaded, the digest is computed after it
+        const auto *digest = find<state_digest_object>();
+        if (digest == nullptr) {
+            return;
+        }
+        chainbase::database::modify(*digest, [&](state_digest_object &o) {
+            o.indexes[type_id] += delta;
+        });
+    }
+
+    void database::initialize_state_digest() {
+        _state_digest_history.clear();
+
+        const auto *digest = find<state_digest_object>();
+        if (!_state_digest) {
+            // it isn't updated anymore, so it'd be wrong when it's enabled again
+            if (digest != nullptr) {
+                chainbase::database::remove(*digest);
+            }
+            return;
+        }
+
+        if (digest == nullptr) {
+            rebuild_state_digest();
+        } else {
+            push_state_digest();
+        }
+    }
+
+    void database::rebuild_state_digest() {
+        auto start = fc::time_point::now();
+        wlog("Computing state digest. Please wait, don't break application...");
+
+        const auto *digest = find<state_digest_object>();
+        if (digest != nullptr) {
+            chainbase::database::remove(*digest);
+        }
+
+        auto info = compute_state_digest();
+        chainbase::database::create<state_digest_object>([&](state_digest_object &o) {
+            for (const auto &i: info.indexes) {
+                if (i.digest) {
+                    o.indexes[i.type_id] = i.digest;
+                }
+            }
+        });
+
+        _state_digest_history.clear();
+        push_state_digest();
+
+        auto end = fc::time_point::now();
+        wlog("Done computing state digest ${d}, elapsed time ${t} sec",
+            ("d", info.digest)("t", double((end - start).count()) / 1000000.0));
+    }
+
+    void database::push_state_digest() {
+        auto block_num = head_block_num();
+        while (!_state_digest_history.empty() && _state_digest_history.back().block_num >= block_num) {
+            _state_digest_history.pop_back();
+        }
+
+        _state_digest_history.push_back(make_state_digest_info());
+        if (_state_digest_history.size() > state_digest_history_size) {
+            _state_digest_history.pop_front();
+        }
+    }
+
+    void database::pop_state_digest() {
+        auto block_num = head_block_num();
+        while (!_state_digest_history.empty() && _state_digest_history.back().block_num > block_num) {
+            _state_digest_history.pop_back();
+        }
+    }
+
+    state_digest_info database::make_state_digest_info() const {
+        const auto &digest = get<state_digest_object>();
+
+        state_digest_info result;
+        result.block_num = head_block_num();
+        result.block_id = head_block_id();
+        for (const auto &index: _snapshot_indexes) {
+            auto itr = digest.indexes.find(index->type_id());
+            result.indexes.push_back({index->name(), index->type_id(), itr != digest.indexes.end() ? itr->second : 0});
+        }
+        result.digest = combine_digests(result.indexes);
+        return result;
+    }
+
+    state_digest_info database::get_state_digest(uint32_t block_num) const {
+        FC_ASSERT(_state_digest, "State digest is disabled, enable state-digest in config");
+
+        if (block_num == 0) {
+            block_num = head_block_num();
+        }
+        for (auto itr = _state_digest_history.rbegin(); itr != _state_digest_history.rend(); ++itr) {
+            if (itr->block_num == block_num) {
+                return *itr;
+            }
+        }
+        FC_THROW_EXCEPTION(fc::key_not_found_exception, "State digest of the block ${n} isn't kept",
+            ("n", block_num)("first", _state_digest_history.empty() ? 0 : _state_digest_history.front().block_num));
+    }
+
+    state_digest_info database::compute_state_digest() const {
+        state_digest_info result;
+        result.block_num = head_block_num();
+        result.block_id = head_block_id();
+        for (const auto &index: _snapshot_indexes) {
+            result.indexes.push_back({index->name(), index->type_id(), index->state_digest(*this)});
+        }
+        result.digest = combine_digests(result.indexes);
+        return result;
+    }
+
+} } // golos::chain
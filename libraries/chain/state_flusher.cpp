@@ -0,0 +1,104 @@
+#include <golos/chain/state_flusher.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace golos { namespace chain {
+
+    state_flusher::~state_flusher() {
+        stop();
+    }
+
+    void state_flusher::start(std::function<region()> get_region, uint64_t chunk_size, uint64_t rate) {
+        FC_ASSERT(!is_running(), "State flusher is already running");
+
+        auto page_size = uint64_t(::sysconf(_SC_PAGESIZE));
+        _get_region = std::move(get_region);
+        _chunk_size = std::max(page_size, chunk_size / page_size * page_size);
+        _rate = rate;
+        _stop = false;
+        _thread = std::thread([this]() { run(); });
+    }
+
+    void state_flusher::stop() {
+        if (!is_running()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_stop_mutex);
+            _stop = true;
+        }
+        _stop_cv.notify_all();
+        _thread.join();
+    }
+
+    bool state_flusher::is_running() const {
+        return _thread.joinable();
+    }
+
+    std::unique_lock<std::mutex> state_flusher::pause() {
+        return std::unique_lock<std::mutex>(_region_mutex);
+    }
+
+    uint64_t state_flusher::completed_passes() const {
+        return _completed_passes.load();
+    }
+
+    fc::microseconds state_flusher::total_sync_time() const {
+        return fc::microseconds(_total_sync_time.load());
+    }
+
+    void state_flusher::run() {
+        uint64_t offset = 0;
+
+        while (true) {
+            auto chunk_start = fc::time_point::now();
+            bool pass_completed = false;
+            bool mapped = false;
+            {
+                std::lock_guard<std::mutex> lock(_region_mutex);
+                auto r = _get_region();
+                mapped = r.addr != nullptr;
+
+                if (r.addr != nullptr && offset < r.size) {
+                    auto size = std::min(_chunk_size, r.size - offset);
+                    if (::msync(r.addr + offset, size, MS_SYNC) != 0) {
+                        wlog("Can't flush shared memory: ${e}", ("e", std::strerror(errno)));
+                    }
+                    offset += size;
+                    _total_sync_time += (fc::time_point::now() - chunk_start).count();
+                }
+
+                if (!mapped || offset >= r.size) {
+                    offset = 0;
+                    pass_completed = mapped;
+                }
+            }
+
+            if (pass_completed) {
+                ++_completed_passes;
+            }
+
+            // sleep the rest of the time the chunk takes at the configured rate
+            auto chunk_time = mapped
+                ? fc::microseconds(_rate ? int64_t(_chunk_size * 1000000 / _rate) : 0)
+                : fc::seconds(1);
+            auto wait = chunk_start + chunk_time - fc::time_point::now();
+
+            std::unique_lock<std::mutex> lock(_stop_mutex);
+            if (_stop_cv.wait_for(lock, std::chrono::microseconds(std::max<int64_t>(wait.count(), 0)),
+                    [this]() { return _stop; })
+            ) {
+                return;
+            }
+        }
+    }
+
+} } // golos::chain
@@ -0,0 +1,166 @@
+#include <golos/chain/state_snapshot.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/filesystem.hpp>
+
+#include <boost/algorithm/string/replace.hpp>
+
+#include <atomic>
+#include <exception>
+#include <fstream>
+#include <thread>
+
+namespace golos { namespace chain {
+
+    namespace {
+        const char *manifest_file_name = "manifest.json";
+
+        std::string snapshot_file_name(const std::string &index_name) {
+            return boost::algorithm::replace_all_copy(index_name, "::", ".") + ".bin";
+        }
+    }
+
+    void database::add_snapshot_index(std::shared_ptr<abstract_snapshot_index> index) {
+        _snapshot_indexes.push_back(std::move(index));
+    }
+
+    void database::write_snapshot(const fc::path &snapshot_dir, uint32_t threads) {
+        try {
+            auto start = fc::time_point::now();
+            wlog("Start writing state snapshot to ${dir}...", ("dir", snapshot_dir));
+
+            fc::create_directories(snapshot_dir);
+
+            if (!threads) {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            threads = std::min<uint32_t>(threads, _snapshot_indexes.size());
+
+            snapshot_manifest manifest;
+            manifest.version = snapshot_version;
+            manifest.chain_id = get_chain_id();
+            manifest.indexes.resize(_snapshot_indexes.size());
+
+            with_weak_read_lock([&]() {
+                manifest.head_block_num = head_block_num();
+                manifest.head_block_id = head_block_id();
+                manifest.head_block_time = head_block_time();
+
+                // indexes are independent, so each worker takes the next unwritten one
+                std::atomic<size_t> next_index(0);
+                std::vector<std::exception_ptr> errors(threads);
+                std::vector<std::thread> workers;
+
+                auto worker = [&](uint32_t n) {
+                    try {
+                        for (auto i = next_index++; i < _snapshot_indexes.size(); i = next_index++) {
+                            const auto &index = *_snapshot_indexes[i];
+                            auto &info = manifest.indexes[i];
+
+                            info.name = index.name();
+                            info.file = snapshot_file_name(info.name);
+
+                            std::ofstream out((snapshot_dir / info.file).string(), std::ios::binary | std::ios::trunc);
+                            index.write(*this, out, info);
+                        }
+                    } catch (...) {
+                        errors[n] = std::current_exception();
+                    }
+                };
+
+                for (uint32_t n = 1; n < threads; ++n) {
+                    workers.emplace_back(worker, n);
+                }
+                worker(0);
+
+                for (auto &w: workers) {
+                    w.join();
+                }
+                for (auto &e: errors) {
+                    if (e) {
+                        std::rethrow_exception(e);
+                    }
+                }
+            });
+
+            fc::json::save_to_file(manifest, snapshot_dir / manifest_file_name);
+
+            auto end = fc::time_point::now();
+            wlog("Done writing state snapshot at block ${n}, elapsed time ${t} sec",
+                ("n", manifest.head_block_num)("t", double((end - start).count()) / 1000000.0));
+        }
+        FC_CAPTURE_LOG_AND_RETHROW((snapshot_dir)(threads))
+    }
+
+    void database::open_from_snapshot(
+        const fc::path &data_dir, const fc::path &shared_mem_dir,
+        const fc::path &snapshot_dir, uint64_t shared_file_size, uint32_t chainbase_flags
+    ) {
+        try {
+            auto start = fc::time_point::now();
+            wlog("Start loading state snapshot from ${dir}. Please wait, don't break application...", ("dir", snapshot_dir));
+
+            auto manifest = fc::json::from_file(snapshot_dir / manifest_file_name).as<snapshot_manifest>();
+            FC_ASSERT(manifest.version == snapshot_version,
+                "Unsupported snapshot version ${v}, expected ${e}", ("v", manifest.version)("e", snapshot_version));
+            FC_ASSERT(manifest.chain_id == get_chain_id(), "Snapshot is created for another chain",
+                ("chain_id", manifest.chain_id)("expected", get_chain_id()));
+
+            init_schema();
+            open_shared_memory(shared_mem_dir, chainbase_flags | chainbase::database::read_write, shared_file_size);
+
+            initialize_indexes();
+            initialize_evaluators();
+            initialize_maintenance_tasks();
+
+            FC_ASSERT(!find<dynamic_global_property_object>(), "Snapshot can be loaded only into an empty database");
+
+            _block_log.open(data_dir / "block_log");
+
+            auto head_block = _block_log.read_block_by_num(manifest.head_block_num);
+            FC_ASSERT(head_block.valid() && head_block->id() == manifest.head_block_id,
+                "Block log doesn't contain the snapshot head block",
+                ("head_block_num", manifest.head_block_num)("head_block_id", manifest.head_block_id));
+
+            std::map<std::string, const snapshot_index_info *> infos;
+            for (const auto &info: manifest.indexes) {
+                infos[info.name] = &info;
+            }
+
+            with_strong_write_lock([&]() {
+                for (const auto &index: _snapshot_indexes) {
+                    auto itr = infos.find(index->name());
+                    FC_ASSERT(itr != infos.end(), "Snapshot doesn't contain the index ${index}", ("index", index->name()));
+
+                    std::ifstream in((snapshot_dir / itr->second->file).string(), std::ios::binary);
+                    FC_ASSERT(in.is_open(), "Can't open snapshot file ${file}", ("file", itr->second->file));
+                    index->read(*this, in, *itr->second);
+
+                    ilog("Loaded ${n} objects of ${index}", ("n", itr->second->object_count)("index", index->name()));
+                    infos.erase(itr);
+                }
+
+                FC_ASSERT(head_block_id() == manifest.head_block_id, "Snapshot state doesn't match its manifest");
+                set_revision(head_block_num());
+
+                initialize_state_digest();
+            });
+
+            for (const auto &info: infos) {
+                wlog("Index ${index} from snapshot isn't used by this node and is skipped", ("index", info.first));
+            }
+
+            _fork_db.start_block(*head_block);
+
+            with_strong_read_lock([&]() {
+                init_hardforks(); // Writes to local state, but reads from db
+            });
+
+            auto end = fc::time_point::now();
+            wlog("Done loading state snapshot at block ${n}, elapsed time ${t} sec",
+                ("n", manifest.head_block_num)("t", double((end - start).count()) / 1000000.0));
+        }
+        FC_CAPTURE_LOG_AND_RETHROW((data_dir)(shared_mem_dir)(snapshot_dir)(shared_file_size))
+    }
+
+} } // golos::chain
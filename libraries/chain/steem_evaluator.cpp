@@ -1,6 +1,7 @@
 #include <golos/chain/steem_evaluator.hpp>
 #include <golos/chain/database.hpp>
 #include <golos/chain/custom_operation_interpreter.hpp>
+#include <golos/chain/operation_notification.hpp>
 #include <golos/chain/steem_objects.hpp>
 #include <golos/chain/block_summary_object.hpp>
 
@@ -1399,7 +1400,17 @@ namespace golos { namespace chain {
                 const auto& comment = _db.get_comment(o.author, o.permlink);
                 const auto& voter = _db.get_account(o.voter);
 
+                // handlers of post_apply_operation take them instead of searching by names
+                auto* note = _db.current_operation_notification();
+                if (note != nullptr) {
+                    note->comment = &comment;
+                    note->account = &voter;
+                }
+
                 const auto& mprops = _db.get_witness_schedule_object().median_props;
+                const auto now = _db.head_block_time();
+                // it's read before the evaluator modifies the root comment
+                const auto payout_time = _db.calculate_discussion_payout_time(comment);
 
                 GOLOS_CHECK_LOGIC(!(voter.owner_challenged || voter.active_challenged),
                     logic_exception::account_is_currently_challenged,
@@ -1413,7 +1424,7 @@ namespace golos { namespace chain {
                         "Votes are not allowed on the comment.");
                 }
 
-                if (_db.calculate_discussion_payout_time(comment) == fc::time_point_sec::maximum()) {
+                if (payout_time == fc::time_point_sec::maximum()) {
                     // non-consensus vote (after cashout)
                     const auto& comment_vote_idx = _db.get_index<comment_vote_index>().indices().get<by_comment_voter>();
                     auto itr = comment_vote_idx.find(std::make_tuple(comment.id, voter.id));
@@ -1422,18 +1433,24 @@ namespace golos { namespace chain {
                             ++c.total_votes;
                         });
 
-                        _db.create<comment_vote_object>([&](comment_vote_object& cvo) {
+                        const auto& vote = _db.create<comment_vote_object>([&](comment_vote_object& cvo) {
                             cvo.voter = voter.id;
                             cvo.comment = comment.id;
                             cvo.vote_percent = o.weight;
-                            cvo.last_update = _db.head_block_time();
+                            cvo.last_update = now;
                             cvo.num_changes = -2;           // mark vote that it's ready to be removed (archived comment)
                         });
+                        if (note != nullptr) {
+                            note->vote = &vote;
+                        }
                     } else {
                         _db.modify(*itr, [&](comment_vote_object& cvo) {
                             cvo.vote_percent = o.weight;
-                            cvo.last_update = _db.head_block_time();
+                            cvo.last_update = now;
                         });
+                        if (note != nullptr) {
+                            note->vote = &*itr;
+                        }
                     }
                     return;
                 }
@@ -1441,7 +1458,7 @@ namespace golos { namespace chain {
                 const auto& comment_vote_idx = _db.get_index<comment_vote_index>().indices().get<by_comment_voter>();
                 auto itr = comment_vote_idx.find(std::make_tuple(comment.id, voter.id));
 
-                auto elapsed_seconds = (_db.head_block_time() - voter.last_vote_time).to_seconds();
+                auto elapsed_seconds = (now - voter.last_vote_time).to_seconds();
 
                 if (_db.has_hardfork(STEEMIT_HARDFORK_0_19__533_1002)) {
                     auto consumption = mprops.votes_window / mprops.votes_per_window;
@@ -1458,7 +1475,7 @@ namespace golos { namespace chain {
                         a.voting_capacity = current_capacity - consumption;
                     });
                 } else {
-                    GOLOS_CHECK_BANDWIDTH(_db.head_block_time(), voter.last_vote_time + STEEMIT_MIN_VOTE_INTERVAL_SEC-1,
+                    GOLOS_CHECK_BANDWIDTH(now, voter.last_vote_time + STEEMIT_MIN_VOTE_INTERVAL_SEC-1,
                         bandwidth_exception::vote_bandwidth, "Can only vote once every 3 seconds.");
                 }
 
@@ -1529,8 +1546,7 @@ namespace golos { namespace chain {
                     /// this is the rshares voting for or against the post
                     int64_t rshares = o.weight < 0 ? -abs_rshares : abs_rshares;
                     if (rshares > 0) {
-                        GOLOS_CHECK_LOGIC(_db.head_block_time() <
-                            _db.calculate_discussion_payout_time(comment) - STEEMIT_UPVOTE_LOCKOUT,
+                        GOLOS_CHECK_LOGIC(now < payout_time - STEEMIT_UPVOTE_LOCKOUT,
                             logic_exception::cannot_vote_within_last_minute_before_payout,
                             "Cannot increase reward of post within the last minute before payout.");
                     }
@@ -1540,7 +1556,7 @@ namespace golos { namespace chain {
 
                     _db.modify(voter, [&](account_object &a) {
                         a.voting_power = current_power - used_power;
-                        a.last_vote_time = _db.head_block_time();
+                        a.last_vote_time = now;
                     });
 
                     /// if the current net_rshares is less than 0, the post is getting 0 rewards so it is not factored into total rshares^2
@@ -1551,8 +1567,8 @@ namespace golos { namespace chain {
                     fc::uint128_t avg_cashout_sec = 0;
 
                     if (!_db.has_hardfork(STEEMIT_HARDFORK_0_17__431)) {
-                        fc::uint128_t cur_cashout_time_sec = _db.calculate_discussion_payout_time(comment).sec_since_epoch();
-                        fc::uint128_t new_cashout_time_sec = _db.head_block_time().sec_since_epoch();
+                        fc::uint128_t cur_cashout_time_sec = payout_time.sec_since_epoch();
+                        fc::uint128_t new_cashout_time_sec = now.sec_since_epoch();
 
                         if (_db.has_hardfork(STEEMIT_HARDFORK_0_12__177) &&
                             !_db.has_hardfork(STEEMIT_HARDFORK_0_13__257)
@@ -1602,7 +1618,7 @@ namespace golos { namespace chain {
 
                             if (c.max_cashout_time == fc::time_point_sec::maximum()) {
                                 c.max_cashout_time =
-                                        _db.head_block_time() + fc::seconds(STEEMIT_MAX_CASHOUT_WINDOW_SECONDS);
+                                        now + fc::seconds(STEEMIT_MAX_CASHOUT_WINDOW_SECONDS);
                             }
                         }
                     });
@@ -1613,17 +1629,17 @@ namespace golos { namespace chain {
                     new_rshares = _db.calculate_vshares(new_rshares);
                     old_rshares = _db.calculate_vshares(old_rshares);
 
-                    _db.create<comment_vote_object>([&](comment_vote_object &cv) {
+                    const auto& vote = _db.create<comment_vote_object>([&](comment_vote_object &cv) {
                         cv.voter = voter.id;
                         cv.comment = comment.id;
                         cv.rshares = rshares;
                         cv.vote_percent = o.weight;
-                        cv.last_update = _db.head_block_time();
+                        cv.last_update = now;
 
                         if (rshares > 0 && (comment.last_payout == fc::time_point_sec()) && comment.allow_curation_rewards) {
                             cv.orig_rshares = rshares;
 
-                            if (_db.head_block_time() > fc::time_point_sec(STEEMIT_HARDFORK_0_6_REVERSE_AUCTION_TIME)) {
+                            if (now > fc::time_point_sec(STEEMIT_HARDFORK_0_6_REVERSE_AUCTION_TIME)) {
                                 /// start enforcing this prior to the hardfork
 
                                 /// discount weight by time
@@ -1649,6 +1665,9 @@ namespace golos { namespace chain {
                             }
                         }
                     });
+                    if (note != nullptr) {
+                        note->vote = &vote;
+                    }
 
                     _db.adjust_rshares2(comment, old_rshares, new_rshares);
                 } else {
@@ -1663,15 +1682,14 @@ namespace golos { namespace chain {
                     int64_t rshares = o.weight < 0 ? -abs_rshares : abs_rshares;
 
                     if (itr->rshares < rshares) {
-                        GOLOS_CHECK_LOGIC(_db.head_block_time() <
-                            _db.calculate_discussion_payout_time(comment) - STEEMIT_UPVOTE_LOCKOUT,
+                        GOLOS_CHECK_LOGIC(now < payout_time - STEEMIT_UPVOTE_LOCKOUT,
                             logic_exception::cannot_vote_within_last_minute_before_payout,
                             "Cannot increase reward of post within the last minute before payout.");
                     }
 
                     _db.modify(voter, [&](account_object& a) {
                         a.voting_power = current_power - used_power;
-                        a.last_vote_time = _db.head_block_time();
+                        a.last_vote_time = now;
                     });
 
                     /// if the current net_rshares is less than 0, the post is getting 0 rewards so it is not factored into total rshares^2
@@ -1682,8 +1700,8 @@ namespace golos { namespace chain {
                     fc::uint128_t avg_cashout_sec = 0;
 
                     if (!_db.has_hardfork(STEEMIT_HARDFORK_0_17__431)) {
-                        fc::uint128_t cur_cashout_time_sec = _db.calculate_discussion_payout_time(comment).sec_since_epoch();
-                        fc::uint128_t new_cashout_time_sec = _db.head_block_time().sec_since_epoch();
+                        fc::uint128_t cur_cashout_time_sec = payout_time.sec_since_epoch();
+                        fc::uint128_t new_cashout_time_sec = now.sec_since_epoch();
 
                         if (_db.has_hardfork(STEEMIT_HARDFORK_0_12__177) &&
                             !_db.has_hardfork(STEEMIT_HARDFORK_0_13__257)
@@ -1737,7 +1755,7 @@ namespace golos { namespace chain {
 
                             if (c.max_cashout_time == fc::time_point_sec::maximum()) {
                                 c.max_cashout_time =
-                                    _db.head_block_time() + fc::seconds(STEEMIT_MAX_CASHOUT_WINDOW_SECONDS);
+                                    now + fc::seconds(STEEMIT_MAX_CASHOUT_WINDOW_SECONDS);
                             }
                         }
                     });
@@ -1751,11 +1769,14 @@ namespace golos { namespace chain {
                     _db.modify(*itr, [&](comment_vote_object &cv) {
                         cv.rshares = rshares;
                         cv.vote_percent = o.weight;
-                        cv.last_update = _db.head_block_time();
+                        cv.last_update = now;
                         cv.num_changes += 1;
 
                         cv.delegator_vote_interest_rates.clear();
                     });
+                    if (note != nullptr) {
+                        note->vote = &*itr;
+                    }
 
                     _db.adjust_rshares2(comment, old_rshares, new_rshares);
                 }
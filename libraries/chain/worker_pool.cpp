@@ -0,0 +1,97 @@
+#include <golos/chain/worker_pool.hpp>
+
+#include <algorithm>
+
+namespace golos { namespace chain {
+
+    worker_pool::~worker_pool() {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _job_cv.notify_all();
+        for (auto &t: _threads) {
+            t.join();
+        }
+    }
+
+    void worker_pool::run(size_t count, uint32_t threads, const task_type &task) {
+        if (count == 0) {
+            return;
+        }
+        if (!threads) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = uint32_t(std::min<size_t>(threads, count));
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_threads.size() + 1 < threads) {
+            _threads.emplace_back([this]() {
+                thread_main();
+            });
+        }
+
+        job j;
+        j.task = &task;
+        j.count = count;
+        j.free_slots = threads - 1;
+        _job = &j;
+        if (j.free_slots) {
+            _job_cv.notify_all();
+        }
+
+        work(j, lock);
+
+        // helpers, which haven't joined yet, won't see the job
+        _job = nullptr;
+        _done_cv.wait(lock, [&]() {
+            return j.running == 0;
+        });
+
+        if (j.error) {
+            std::rethrow_exception(j.error);
+        }
+    }
+
+    size_t worker_pool::size() const {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _threads.size();
+    }
+
+    void worker_pool::work(job &j, std::unique_lock<std::mutex> &lock) {
+        while (!j.error && j.next < j.count) {
+            auto i = j.next++;
+            lock.unlock();
+            try {
+                (*j.task)(i);
+                lock.lock();
+            } catch (...) {
+                lock.lock();
+                if (!j.error) {
+                    j.error = std::current_exception();
+                }
+            }
+        }
+    }
+
+    void worker_pool::thread_main() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _job_cv.wait(lock, [&]() {
+                return _stop || (_job != nullptr && _job->free_slots != 0);
+            });
+            if (_stop) {
+                return;
+            }
+
+            auto &j = *_job;
+            --j.free_slots;
+            ++j.running;
+            work(j, lock);
+            if (--j.running == 0) {
+                _done_cv.notify_all();
+            }
+        }
+    }
+
+} } // golos::chain
@@ -45,6 +45,25 @@
  */
 #define GRAPHENE_PEER_DATABASE_RETRY_DELAY                   15 // seconds
 
+/**
+ * The peer database keeps at most this many peers, preferring the ones
+ * we have most recently connected to
+ */
+#define GRAPHENE_PEER_DATABASE_MAX_SIZE                      1000
+
+/**
+ * Peers we have neither connected to nor heard about for this long
+ * are dropped from the peer database
+ */
+#define GRAPHENE_PEER_DATABASE_EXPIRATION_SEC                (60 * 60 * 24 * 14)
+
+/**
+ * Changes of the peer database are buffered and appended to its file
+ * when this many are pending or after the interval
+ */
+#define GRAPHENE_PEER_DATABASE_FLUSH_MAX_ENTRIES             64
+#define GRAPHENE_PEER_DATABASE_FLUSH_INTERVAL_SEC            10
+
 #define GRAPHENE_NET_PEER_HANDSHAKE_INACTIVITY_TIMEOUT       5
 
 #define GRAPHENE_NET_PEER_DISCONNECT_TIMEOUT                 20
@@ -57,6 +76,29 @@
 
 #define GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES        (1024 * 1024)
 
+/**
+ * Bytes each class of outbound messages may send to a peer per round while other classes
+ * are waiting, see message_priority in peer_connection.hpp.  Connection control messages
+ * have no budget.
+ */
+#define GRAPHENE_NET_NEW_BLOCK_QUEUE_BUDGET_IN_BYTES         (1024 * 1024)
+#define GRAPHENE_NET_INVENTORY_QUEUE_BUDGET_IN_BYTES         (64 * 1024)
+#define GRAPHENE_NET_TRANSACTION_QUEUE_BUDGET_IN_BYTES       (256 * 1024)
+#define GRAPHENE_NET_SYNC_BLOCK_QUEUE_BUDGET_IN_BYTES        (128 * 1024)
+#define GRAPHENE_NET_ADDRESS_QUEUE_BUDGET_IN_BYTES           (16 * 1024)
+
+/**
+ * Bytes per second of sync blocks sent to one peer, 0 means no limit.  The budget of the sync
+ * class is the most it may send at once after an idle period.
+ */
+#define GRAPHENE_NET_SYNC_BLOCK_BYTES_PER_SECOND             (2 * 1024 * 1024)
+
+/** how often the send task checks for other messages while only rate limited messages are waiting */
+#define GRAPHENE_NET_RATE_LIMITED_QUEUE_POLL_MS              10
+
+/** weight of the newest sample in the smoothed queue delay of outbound messages */
+#define GRAPHENE_NET_QUEUE_DELAY_SMOOTHING_PERCENT           10
+
 /**
  * When we receive a message from the network, we advertise it to
  * our peers and save a copy in a cache were we will find it if
@@ -68,6 +110,12 @@
  */
 #define GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS        5
 
+/**
+ * Upper bound on the memory used by the message cache.  During spam waves
+ * the least recently requested messages are evicted before they expire.
+ */
+#define GRAPHENE_NET_MESSAGE_CACHE_MAX_SIZE_IN_BYTES         (64 * 1024 * 1024)
+
 /**
  * We prevent a peer from offering us a list of blocks which, if we fetched them
  * all, would result in a blockchain that extended into the future.
@@ -103,3 +151,30 @@
 #define GRAPHENE_NET_MIN_BLOCK_IDS_TO_PREFETCH               10000
 
 #define GRAPHENE_NET_MAX_TRX_PER_SECOND                      1000
+
+/**
+ * Sync peers are scored by the round-trip time and block throughput of their
+ * recent sync batches.  Each new measurement is mixed into the running average
+ * with this weight (in percent).
+ */
+#define GRAPHENE_NET_SYNC_PEER_SCORE_SMOOTHING_PERCENT       25
+
+/**
+ * A peer must complete this many sync batches before its score is trusted
+ * enough to shrink its batches or rotate it out.  Until then it is treated
+ * as at least as good as the best measured peer, so that new peers get probed.
+ */
+#define GRAPHENE_NET_SYNC_PEER_SCORE_MIN_BATCHES             3
+
+/**
+ * Even the slowest sync peer is asked for at least this many blocks at a time
+ */
+#define GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING      10
+
+/**
+ * A measured sync peer whose throughput falls below this percentage of the
+ * fastest measured peer stops receiving sync requests for
+ * GRAPHENE_NET_SLOW_SYNC_PEER_COOLDOWN_SEC seconds, after which it is measured again.
+ */
+#define GRAPHENE_NET_SLOW_SYNC_PEER_THRESHOLD_PERCENT        10
+#define GRAPHENE_NET_SLOW_SYNC_PEER_COOLDOWN_SEC             60
@@ -40,6 +40,7 @@
 #include <boost/multi_index/sequenced_index.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 
+#include <array>
 #include <queue>
 #include <boost/container/deque.hpp>
 #include <fc/thread/future.hpp>
@@ -60,6 +61,78 @@ namespace golos {
             node_id_t requesting_peer;
         };
 
+        /**
+         * Tracks how well a peer serves us sync blocks.  The round-trip time is measured from
+         * sending a batch request to receiving the first block of the batch, the throughput
+         * over the whole batch; both are smoothed across batches.
+         */
+        struct peer_sync_score {
+            fc::microseconds round_trip_delay;
+            double blocks_per_second = 0;
+            uint32_t batches_completed = 0;
+            uint64_t blocks_delivered = 0;
+            uint32_t invalid_items = 0;
+            uint32_t times_rotated_out = 0;
+            fc::time_point deprioritized_until;
+
+            /// the batch currently requested from the peer
+            /// @{
+            fc::time_point batch_request_time;
+            uint32_t batch_size = 0;
+            uint32_t batch_received = 0;
+            /// @}
+
+            void on_batch_requested(uint32_t number_of_items);
+
+            void on_block_received();
+
+            void on_invalid_item();
+
+            /** stop asking this peer for sync blocks for a while and forget its measurements,
+             * so it is probed from scratch once the cooldown expires */
+            void rotate_out(fc::time_point until);
+
+            bool is_measured() const;
+
+            bool is_deprioritized() const;
+
+            /** blocks per second, penalized for invalid blocks the peer has sent us */
+            double rating() const;
+        };
+
+        /**
+         * Outbound messages to a peer are queued by class, in this order of preference.  Connection
+         * control messages are never held back, the other classes share the link by deficit round robin
+         * with a byte budget per class, so a busy class delays the classes below it but can't starve them.
+         * Blocks go to the sync class while the peer syncs from us, otherwise to the new block class.
+         * The block class of a peer is kept while blocks of that class are queued, so a peer gets its
+         * blocks in the order they were sent.  The sync class is also limited to a byte rate per peer,
+         * so serving a sync leaves bandwidth for relay to the other peers.
+         */
+        enum class message_priority : uint8_t {
+            control,
+            new_block,
+            inventory,
+            transaction,
+            sync_block,
+            address_gossip
+        };
+
+        constexpr size_t message_priority_count = 6;
+
+        /** statistics of one outbound queue, the queue delay is measured from queueing a message to
+         * the start of its transmission */
+        struct outbound_queue_statistics {
+            uint64_t messages_sent = 0;
+            uint64_t bytes_sent = 0;
+            size_t queued_messages = 0;
+            size_t queued_bytes = 0;
+            fc::microseconds average_queue_delay;
+            fc::microseconds max_queue_delay;
+
+            void on_message_sent(size_t bytes, fc::microseconds queue_delay);
+        };
+
         class peer_connection;
 
         class peer_connection_delegate {
@@ -168,8 +241,21 @@ namespace golos {
             };
 
 
+            struct outbound_queue {
+                std::queue<std::unique_ptr<queued_message>, std::list<std::unique_ptr<queued_message>>> messages;
+                /// bytes the queue may still send in the current round
+                int64_t deficit = 0;
+                /// bytes the queue may send now without exceeding its rate, used only for rate limited classes
+                int64_t rate_allowance = 0;
+                fc::time_point rate_allowance_time;
+                outbound_queue_statistics statistics;
+            };
+
+            /// class of the blocks queued for the peer, see message_priority
+            message_priority _block_priority;
+
             size_t _total_queued_messages_size;
-            std::queue<std::unique_ptr<queued_message>, std::list<std::unique_ptr<queued_message>>> _queued_messages;
+            std::array<outbound_queue, message_priority_count> _queued_messages;
             fc::future<void> _send_queued_messages_done;
         public:
             fc::time_point connection_initiation_time;
@@ -239,6 +325,7 @@ namespace golos {
             item_hash_t last_block_delegate_has_seen; /// the hash of the last block  this peer has told us about that the peer knows
             fc::time_point_sec last_block_time_delegate_has_seen;
             bool inhibit_fetching_sync_blocks;
+            peer_sync_score sync_score;
             /// @}
 
             /// non-synchronization state data
@@ -300,7 +387,7 @@ namespace golos {
 
             void on_connection_closed(message_oriented_connection *originating_connection) override;
 
-            void send_queueable_message(std::unique_ptr<queued_message> &&message_to_send);
+            void send_queueable_message(std::unique_ptr<queued_message> &&message_to_send, message_priority priority);
 
             void send_message(const message &message_to_send, size_t message_send_time_field_offset = (size_t)-1);
 
@@ -342,7 +429,20 @@ namespace golos {
 
             fc::optional<fc::ip::endpoint> get_endpoint_for_connecting() const;
 
+            message_priority get_message_priority(const message &message_to_send);
+
+            message_priority get_item_priority(const item_id &item_to_send);
+
+            const outbound_queue_statistics &get_outbound_queue_statistics(message_priority priority) const;
+
         private:
+            message_priority get_block_priority();
+
+            void refill_rate_allowance(
+                    outbound_queue &queue, int64_t bytes_per_second, int64_t max_allowance, fc::time_point now);
+
+            outbound_queue *select_next_outbound_queue(fc::microseconds &throttle_delay);
+
             void send_queued_messages_task();
 
             void accept_connection_task();
@@ -377,3 +477,12 @@ FC_REFLECT_ENUM(golos::network::peer_connection::connection_negotiation_status,
         (closed))
 
 FC_REFLECT((golos::network::peer_connection::timestamped_item_id), (item)(timestamp));
+
+FC_REFLECT_ENUM(golos::network::message_priority, (control)(new_block)(inventory)(transaction)(sync_block)(address_gossip))
+
+FC_REFLECT((golos::network::outbound_queue_statistics),
+        (messages_sent)(bytes_sent)(queued_messages)(queued_bytes)(average_queue_delay)(max_queue_delay))
+
+FC_REFLECT((golos::network::peer_sync_score),
+        (round_trip_delay)(blocks_per_second)(batches_completed)(blocks_delivered)
+        (invalid_items)(times_rotated_out)(deprioritized_until))
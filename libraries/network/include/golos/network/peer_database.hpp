@@ -49,6 +49,7 @@ namespace golos {
             fc::time_point_sec last_seen_time;
             fc::enum_type<uint8_t, potential_peer_last_connection_disposition> last_connection_disposition;
             fc::time_point_sec last_connection_attempt_time;
+            fc::time_point_sec last_successful_connection_time; ///< set by the node on each successful handshake
             uint32_t number_of_successful_connection_attempts;
             uint32_t number_of_failed_connection_attempts;
             fc::optional<fc::exception> last_error;
@@ -117,10 +118,15 @@ namespace golos {
 
             void update_entry(const potential_peer_record &updatedRecord);
 
+            /** appends the buffered changes to the file */
+            void flush();
+
             potential_peer_record lookup_or_create_entry_for_endpoint(const fc::ip::endpoint &endpointToLookup);
 
             fc::optional<potential_peer_record> lookup_entry_for_endpoint(const fc::ip::endpoint &endpointToLookup);
 
+            /** iterates peers from the most recently successfully connected to the least,
+             * peers we never connected to ordered by when we last heard about them */
             typedef detail::peer_database_iterator iterator;
 
             iterator begin() const;
@@ -137,4 +143,4 @@ namespace golos {
 } // end namespace golos::network
 
 FC_REFLECT_ENUM(golos::network::potential_peer_last_connection_disposition, (never_attempted_to_connect)(last_connection_failed)(last_connection_rejected)(last_connection_handshaking_failed)(last_connection_succeeded))
-FC_REFLECT((golos::network::potential_peer_record), (endpoint)(last_seen_time)(last_connection_disposition)(last_connection_attempt_time)(number_of_successful_connection_attempts)(number_of_failed_connection_attempts)(last_error))
+FC_REFLECT((golos::network::potential_peer_record), (endpoint)(last_seen_time)(last_connection_disposition)(last_connection_attempt_time)(last_successful_connection_time)(number_of_successful_connection_attempts)(number_of_failed_connection_attempts)(last_error))
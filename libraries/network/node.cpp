@@ -21,6 +21,7 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <deque>
@@ -109,6 +110,12 @@ namespace golos {
         namespace detail {
             namespace bmi = boost::multi_index;
 
+            /**
+             * Keeps the messages we have received or broadcast recently so we can serve them to peers.
+             * Messages expire after cache_duration_in_blocks blocks, and the cache is additionally
+             * bounded by a byte budget: when it is exceeded, the least recently used messages are
+             * evicted first.
+             */
             class blockchain_tied_message_cache {
             private:
                 static const uint32_t cache_duration_in_blocks = GRAPHENE_NET_MESSAGE_CACHE_DURATION_IN_BLOCKS;
@@ -119,11 +126,14 @@ namespace golos {
                 };
                 struct block_clock_index {
                 };
+                struct last_access_index {
+                };
 
                 struct message_info {
                     message_hash_type message_hash;
                     message message_body;
                     uint32_t block_clock_when_received;
+                    uint64_t last_access;
 
                     // for network performance stats
                     message_propagation_data propagation_data;
@@ -132,11 +142,13 @@ namespace golos {
                     message_info(const message_hash_type &message_hash,
                             const message &message_body,
                             uint32_t block_clock_when_received,
+                            uint64_t last_access,
                             const message_propagation_data &propagation_data,
                             fc::uint160_t message_contents_hash) :
                             message_hash(message_hash),
                             message_body(message_body),
                             block_clock_when_received(block_clock_when_received),
+                            last_access(last_access),
                             propagation_data(propagation_data),
                             message_contents_hash(message_contents_hash) {
                     }
@@ -149,16 +161,42 @@ namespace golos {
                                         bmi::ordered_non_unique<bmi::tag<message_contents_hash_index>,
                                                 bmi::member<message_info, fc::uint160_t, &message_info::message_contents_hash>>,
                                         bmi::ordered_non_unique<bmi::tag<block_clock_index>,
-                                                bmi::member<message_info, uint32_t, &message_info::block_clock_when_received>>>
+                                                bmi::member<message_info, uint32_t, &message_info::block_clock_when_received>>,
+                                        bmi::ordered_non_unique<bmi::tag<last_access_index>,
+                                                bmi::member<message_info, uint64_t, &message_info::last_access>>>
                         > message_cache_container;
 
                 message_cache_container _message_cache;
 
                 uint32_t block_clock;
+                uint64_t _access_clock;
+
+                size_t _max_size_in_bytes;
+                size_t _size_in_bytes;
+
+                uint64_t _hits;
+                uint64_t _misses;
+                uint64_t _evictions;
+
+                static size_t get_entry_size(const message_info &info) {
+                    // the entry with its payload plus roughly three pointers per node in each of the four indexes
+                    return sizeof(message_info) + info.message_body.data.size() + 4 * 3 * sizeof(void *);
+                }
+
+                template<typename Index>
+                typename Index::iterator erase(Index &index, typename Index::iterator iter);
+
+                void evict_to_budget();
 
             public:
                 blockchain_tied_message_cache() :
-                        block_clock(0) {
+                        block_clock(0),
+                        _access_clock(0),
+                        _max_size_in_bytes(GRAPHENE_NET_MESSAGE_CACHE_MAX_SIZE_IN_BYTES),
+                        _size_in_bytes(0),
+                        _hits(0),
+                        _misses(0),
+                        _evictions(0) {
                 }
 
                 void block_accepted();
@@ -173,14 +211,42 @@ namespace golos {
                 size_t size() const {
                     return _message_cache.size();
                 }
+
+                size_t size_in_bytes() const {
+                    return _size_in_bytes;
+                }
+
+                void set_max_size_in_bytes(size_t max_size_in_bytes);
+
+                size_t get_max_size_in_bytes() const {
+                    return _max_size_in_bytes;
+                }
+
+                fc::variant_object get_statistics() const;
             };
 
+            template<typename Index>
+            typename Index::iterator blockchain_tied_message_cache::erase(Index &index, typename Index::iterator iter) {
+                _size_in_bytes -= get_entry_size(*iter);
+                return index.erase(iter);
+            }
+
+            void blockchain_tied_message_cache::evict_to_budget() {
+                auto &by_last_access = _message_cache.get<last_access_index>();
+                while (_size_in_bytes > _max_size_in_bytes && !by_last_access.empty()) {
+                    erase(by_last_access, by_last_access.begin());
+                    ++_evictions;
+                }
+            }
+
             void blockchain_tied_message_cache::block_accepted() {
                 ++block_clock;
                 if (block_clock > cache_duration_in_blocks) {
-                    _message_cache.get<block_clock_index>().erase(_message_cache.get<block_clock_index>().begin(),
-                            _message_cache.get<block_clock_index>().lower_bound(
-                                    block_clock - cache_duration_in_blocks));
+                    auto &by_block_clock = _message_cache.get<block_clock_index>();
+                    auto expired_end = by_block_clock.lower_bound(block_clock - cache_duration_in_blocks);
+                    for (auto iter = by_block_clock.begin(); iter != expired_end;) {
+                        iter = erase(by_block_clock, iter);
+                    }
                 }
             }
 
@@ -188,19 +254,33 @@ namespace golos {
                     const message_hash_type &hash_of_message_to_cache,
                     const message_propagation_data &propagation_data,
                     const fc::uint160_t &message_content_hash) {
-                _message_cache.insert(message_info(hash_of_message_to_cache,
+                if (_message_cache.get<message_hash_index>().find(hash_of_message_to_cache) !=
+                    _message_cache.get<message_hash_index>().end()) {
+                    return;
+                }
+
+                auto result = _message_cache.insert(message_info(hash_of_message_to_cache,
                         message_to_cache,
                         block_clock,
+                        ++_access_clock,
                         propagation_data,
                         message_content_hash));
+                _size_in_bytes += get_entry_size(*result.first);
+                evict_to_budget();
             }
 
             message blockchain_tied_message_cache::get_message(const message_hash_type &hash_of_message_to_lookup) {
-                message_cache_container::index<message_hash_index>::type::const_iterator iter =
+                message_cache_container::index<message_hash_index>::type::iterator iter =
                         _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup);
                 if (iter != _message_cache.get<message_hash_index>().end()) {
+                    ++_hits;
+                    uint64_t access_time = ++_access_clock;
+                    _message_cache.get<message_hash_index>().modify(iter, [&](message_info &info) {
+                        info.last_access = access_time;
+                    });
                     return iter->message_body;
                 }
+                ++_misses;
                 FC_THROW_EXCEPTION(fc::key_not_found_exception, "Requested message not in cache");
             }
 
@@ -216,6 +296,22 @@ namespace golos {
                 FC_THROW_EXCEPTION(fc::key_not_found_exception, "Requested message not in cache");
             }
 
+            void blockchain_tied_message_cache::set_max_size_in_bytes(size_t max_size_in_bytes) {
+                _max_size_in_bytes = max_size_in_bytes;
+                evict_to_budget();
+            }
+
+            fc::variant_object blockchain_tied_message_cache::get_statistics() const {
+                fc::mutable_variant_object result;
+                result["entries"] = _message_cache.size();
+                result["size_in_bytes"] = _size_in_bytes;
+                result["max_size_in_bytes"] = _max_size_in_bytes;
+                result["hits"] = _hits;
+                result["misses"] = _misses;
+                result["evictions"] = _evictions;
+                return result;
+            }
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////
 
             // This specifies configuration info for the local node.  It's stored as JSON
@@ -429,7 +525,7 @@ namespace golos {
                 std::unique_ptr<statistics_gathering_node_delegate_wrapper> _delegate;
 
 #define NODE_CONFIGURATION_FILENAME      "node_config.json"
-#define POTENTIAL_PEER_DATABASE_FILENAME "peers.json"
+#define POTENTIAL_PEER_DATABASE_FILENAME "peers.dat"
                 fc::path _node_configuration_directory;
                 node_configuration _node_configuration;
 
@@ -615,6 +711,10 @@ namespace golos {
 
                 void trigger_fetch_sync_items_loop();
 
+                std::vector<peer_connection_ptr> get_sync_peers_by_score(double &best_rating);
+
+                unsigned get_maximum_sync_blocks_for_peer(const peer_connection_ptr &peer, double best_rating) const;
+
                 bool is_item_in_any_peers_inventory(const item_id &item) const;
 
                 void fetch_items_loop();
@@ -1073,6 +1173,7 @@ namespace golos {
                 _active_sync_requests.insert(active_sync_requests_map::value_type(item_to_request, fc::time_point::now()));
                 peer->last_sync_item_received_time = fc::time_point::now();
                 peer->sync_items_requested_from_peer.insert(item_to_request);
+                peer->sync_score.on_batch_requested(1);
                 peer->send_message(fetch_items_message(item_id_to_request.item_type, std::vector<item_hash_t>{
                         item_id_to_request.item_hash
                 }));
@@ -1087,6 +1188,7 @@ namespace golos {
                     peer->last_sync_item_received_time = fc::time_point::now();
                     peer->sync_items_requested_from_peer.insert(item_to_request);
                 }
+                peer->sync_score.on_batch_requested(items_to_request.size());
                 peer->send_message(fetch_items_message(golos::network::block_message_type, items_to_request));
             }
 
@@ -1103,14 +1205,20 @@ namespace golos {
                             ASSERT_TASK_NOT_PREEMPTED();
                             std::set<item_hash_t> sync_items_to_request;
 
+                            // offer items to the best-scoring peers first, so the fastest peers get the
+                            // earliest blocks and slow peers only get what is left over
+                            double best_rating = 0;
+                            std::vector<peer_connection_ptr> sync_peers = get_sync_peers_by_score(best_rating);
+
                             // for each idle peer that we're syncing with
-                            for (const peer_connection_ptr &peer : _active_connections) {
+                            for (const peer_connection_ptr &peer : sync_peers) {
                                 if (peer->we_need_sync_items_from_peer &&
                                     sync_item_requests_to_send.find(peer) ==
                                     sync_item_requests_to_send.end() &&
                                     // if we've already scheduled a request for this peer, don't consider scheduling another
                                     peer->idle()) {
                                     if (!peer->inhibit_fetching_sync_blocks) {
+                                        unsigned maximum_blocks_for_peer = get_maximum_sync_blocks_for_peer(peer, best_rating);
                                         // loop through the items it has that we don't yet have on our blockchain
                                         for (unsigned i = 0; i <
                                                              peer->ids_of_items_to_get.size(); ++i) {
@@ -1128,7 +1236,7 @@ namespace golos {
                                                 sync_item_requests_to_send[peer].push_back(item_to_potentially_request);
                                                 sync_items_to_request.insert(item_to_potentially_request);
                                                 if (sync_item_requests_to_send[peer].size() >=
-                                                    _maximum_blocks_per_peer_during_syncing) {
+                                                    maximum_blocks_for_peer) {
                                                         break;
                                                 }
                                             }
@@ -1164,6 +1272,60 @@ namespace golos {
                 }
             }
 
+            std::vector<peer_connection_ptr> node_impl::get_sync_peers_by_score(double &best_rating) {
+                VERIFY_CORRECT_THREAD();
+                std::vector<peer_connection_ptr> sync_peers;
+                sync_peers.reserve(_active_connections.size());
+                best_rating = 0;
+                for (const peer_connection_ptr &peer : _active_connections) {
+                    if (peer->we_need_sync_items_from_peer && !peer->sync_score.is_deprioritized()) {
+                        sync_peers.push_back(peer);
+                        if (peer->sync_score.is_measured()) {
+                            best_rating = std::max(best_rating, peer->sync_score.rating());
+                        }
+                    }
+                }
+
+                // rotate out peers that are persistently much slower than the best one, as long as
+                // that leaves someone else to sync from.  They get measured again after the cooldown.
+                fc::time_point cooldown_end = fc::time_point::now() + fc::seconds(GRAPHENE_NET_SLOW_SYNC_PEER_COOLDOWN_SEC);
+                for (auto itr = sync_peers.begin(); itr != sync_peers.end() && sync_peers.size() > 1;) {
+                    const peer_connection_ptr &peer = *itr;
+                    if (peer->idle() && peer->sync_score.is_measured() &&
+                        peer->sync_score.rating() * 100 < best_rating * GRAPHENE_NET_SLOW_SYNC_PEER_THRESHOLD_PERCENT) {
+                        fc_wlog(fc::logger::get("sync"),
+                                "not requesting sync blocks from slow peer ${peer} for ${sec} seconds: ${rate} blocks/s, best peer has ${best}",
+                                ("peer", peer->get_remote_endpoint())("sec", GRAPHENE_NET_SLOW_SYNC_PEER_COOLDOWN_SEC)
+                                        ("rate", peer->sync_score.blocks_per_second)("best", best_rating));
+                        peer->sync_score.rotate_out(cooldown_end);
+                        itr = sync_peers.erase(itr);
+                    } else {
+                        ++itr;
+                    }
+                }
+
+                // unmeasured peers go first so they get probed, then measured ones from fastest to slowest
+                std::stable_sort(sync_peers.begin(), sync_peers.end(),
+                        [](const peer_connection_ptr &a, const peer_connection_ptr &b) {
+                            if (a->sync_score.is_measured() != b->sync_score.is_measured()) {
+                                return !a->sync_score.is_measured();
+                            }
+                            return a->sync_score.rating() > b->sync_score.rating();
+                        });
+                return sync_peers;
+            }
+
+            unsigned node_impl::get_maximum_sync_blocks_for_peer(const peer_connection_ptr &peer, double best_rating) const {
+                if (!peer->sync_score.is_measured() || best_rating <= 0) {
+                    return _maximum_blocks_per_peer_during_syncing;
+                }
+                // size the batch in proportion to how fast the peer is compared to the best one,
+                // so all batches take roughly the same time to arrive
+                unsigned maximum_blocks = unsigned(_maximum_blocks_per_peer_during_syncing * peer->sync_score.rating() / best_rating);
+                return std::max<unsigned>(std::min(maximum_blocks, _maximum_blocks_per_peer_during_syncing),
+                        std::min<unsigned>(GRAPHENE_NET_MIN_BLOCKS_PER_PEER_DURING_SYNCING, _maximum_blocks_per_peer_during_syncing));
+            }
+
             bool node_impl::is_item_in_any_peers_inventory(const item_id &item) const {
                 for (const peer_connection_ptr &peer : _active_connections) {
                     if (peer->inventory_peer_advertised_to_us.find(item) !=
@@ -1704,6 +1866,11 @@ namespace golos {
                 update_bandwidth_data(bytes_read_this_second, bytes_written_this_second);
                 _bandwidth_monitor_last_update_time = current_time;
 
+                // changes of peers are buffered, so they are written even if no more changes come
+                if (current_time.sec_since_epoch() % GRAPHENE_PEER_DATABASE_FLUSH_INTERVAL_SEC == 0) {
+                    _potential_peer_db.flush();
+                }
+
                 if (!_node_is_shutting_down &&
                     !_bandwidth_monitor_loop_done.canceled()) {
                         _bandwidth_monitor_loop_done = fc::schedule([=]() { bandwidth_monitor_loop(); },
@@ -2336,6 +2503,7 @@ namespace golos {
                             fc::optional<potential_peer_record> updated_peer_record = _potential_peer_db.lookup_entry_for_endpoint(*inbound_endpoint);
                             if (updated_peer_record) {
                                 updated_peer_record->last_connection_disposition = last_connection_succeeded;
+                                updated_peer_record->last_successful_connection_time = fc::time_point::now();
                                 _potential_peer_db.update_entry(*updated_peer_record);
                             }
                         }
@@ -2445,6 +2613,7 @@ namespace golos {
                         // mark the connection as successful in the database
                         potential_peer_record updated_peer_record = _potential_peer_db.lookup_or_create_entry_for_endpoint(*inbound_endpoint);
                         updated_peer_record.last_connection_disposition = last_connection_succeeded;
+                        updated_peer_record.last_successful_connection_time = fc::time_point::now();
                         _potential_peer_db.update_entry(updated_peer_record);
                     }
 
@@ -3250,6 +3419,7 @@ namespace golos {
 
                         if (peer->ids_of_items_being_processed.find(block_message_to_send.block_id) !=
                             peer->ids_of_items_being_processed.end()) {
+                            peer->sync_score.on_invalid_item();
                             if (discontinue_fetching_blocks_from_peer) {
                                 wlog("inhibiting fetching sync blocks from peer ${endpoint} because it is on a fork that's too old",
                                         ("endpoint", peer->get_remote_endpoint()));
@@ -3550,6 +3720,7 @@ namespace golos {
 
                     disconnect_exception = e;
                     disconnect_reason = "You offered me a block that I have deemed to be invalid";
+                    originating_peer->sync_score.on_invalid_item();
 
                     peers_to_disconnect.insert(originating_peer->shared_from_this());
                     for (const peer_connection_ptr &peer : _active_connections) {
@@ -3600,6 +3771,7 @@ namespace golos {
                         originating_peer->sync_items_requested_from_peer.end()) {
                         originating_peer->sync_items_requested_from_peer.erase(sync_item_iter);
                         originating_peer->last_sync_item_received_time = fc::time_point::now();
+                        originating_peer->sync_score.on_block_received();
                         _active_sync_requests.erase(block_message_to_process.block_id);
                         process_block_during_sync(originating_peer, block_message_to_process, message_hash);
                         if (originating_peer->idle()) {
@@ -4471,11 +4643,12 @@ namespace golos {
                     // push back the time on all peers loaded from the database so we will be able to retry them immediately
                     for (peer_database::iterator itr = _potential_peer_db.begin();
                          itr != _potential_peer_db.end(); ++itr) {
-                        potential_peer_record updated_peer_record = *itr;
-                        updated_peer_record.last_connection_attempt_time = std::min<fc::time_point_sec>(updated_peer_record.last_connection_attempt_time,
-                                fc::time_point::now() -
-                                fc::seconds(_peer_connection_retry_timeout));
-                        _potential_peer_db.update_entry(updated_peer_record);
+                        fc::time_point_sec retry_time = fc::time_point::now() - fc::seconds(_peer_connection_retry_timeout);
+                        if (itr->last_connection_attempt_time > retry_time) {
+                            potential_peer_record updated_peer_record = *itr;
+                            updated_peer_record.last_connection_attempt_time = retry_time;
+                            _potential_peer_db.update_entry(updated_peer_record);
+                        }
                     }
 
                     trigger_p2p_network_connect_loop();
@@ -4737,7 +4910,7 @@ namespace golos {
                 ilog("node._new_received_sync_items size: ${size}", ("size", _new_received_sync_items.size()));
                 ilog("node._items_to_fetch size: ${size}", ("size", _items_to_fetch.size()));
                 ilog("node._new_inventory size: ${size}", ("size", _new_inventory.size()));
-                ilog("node._message_cache size: ${size}", ("size", _message_cache.size()));
+                ilog("node._message_cache size: ${size} (${bytes} bytes)", ("size", _message_cache.size())("bytes", _message_cache.size_in_bytes()));
                 for (const peer_connection_ptr &peer : _active_connections) {
                     ilog("  peer ${endpoint}", ("endpoint", peer->get_remote_endpoint()));
                     ilog("    peer.ids_of_items_to_get size: ${size}", ("size", peer->ids_of_items_to_get.size()));
@@ -4891,6 +5064,15 @@ namespace golos {
                     peer_details["current_head_block"] = peer->last_block_delegate_has_seen;
                     peer_details["current_head_block_number"] = _delegate->get_block_number(peer->last_block_delegate_has_seen);
                     peer_details["current_head_block_time"] = peer->last_block_time_delegate_has_seen;
+                    peer_details["sync_score"] = peer->sync_score;
+
+                    fc::mutable_variant_object send_queues;
+                    for (size_t i = 0; i < message_priority_count; ++i) {
+                        auto priority = static_cast<message_priority>(i);
+                        send_queues[fc::reflector<message_priority>::to_string(priority)] =
+                                peer->get_outbound_queue_statistics(priority);
+                    }
+                    peer_details["send_queues"] = send_queues;
 
                     this_peer_status.info = peer_details;
                     statuses.push_back(this_peer_status);
@@ -4978,6 +5160,9 @@ namespace golos {
                 if (params.contains("maximum_blocks_per_peer_during_syncing")) {
                     _maximum_blocks_per_peer_during_syncing = params["maximum_blocks_per_peer_during_syncing"].as<uint32_t>();
                 }
+                if (params.contains("message_cache_size_limit_in_bytes")) {
+                    _message_cache.set_max_size_in_bytes(params["message_cache_size_limit_in_bytes"].as<uint64_t>());
+                }
 
                 _desired_number_of_connections = std::min(_desired_number_of_connections, _maximum_number_of_connections);
 
@@ -4998,6 +5183,7 @@ namespace golos {
                 result["maximum_number_of_blocks_to_handle_at_one_time"] = _maximum_number_of_blocks_to_handle_at_one_time;
                 result["maximum_number_of_sync_blocks_to_prefetch"] = _maximum_number_of_sync_blocks_to_prefetch;
                 result["maximum_blocks_per_peer_during_syncing"] = _maximum_blocks_per_peer_during_syncing;
+                result["message_cache_size_limit_in_bytes"] = uint64_t(_message_cache.get_max_size_in_bytes());
                 return result;
             }
 
@@ -5064,6 +5250,7 @@ namespace golos {
                 info["node_public_key"] = _node_public_key;
                 info["node_id"] = _node_id;
                 info["firewalled"] = _is_firewalled;
+                info["message_cache"] = _message_cache.get_statistics();
                 return info;
             }
 
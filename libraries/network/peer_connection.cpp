@@ -25,6 +25,8 @@
 
 #include <fc/thread/thread.hpp>
 
+#include <algorithm>
+
 #ifdef DEFAULT_LOGGER
 # undef DEFAULT_LOGGER
 #endif
@@ -38,6 +40,82 @@
 
 namespace golos {
     namespace network {
+        namespace {
+            template<typename T>
+            T smooth_score_sample(T average, T sample, bool first_sample) {
+                if (first_sample) {
+                    return sample;
+                }
+                return (average * (100 - GRAPHENE_NET_SYNC_PEER_SCORE_SMOOTHING_PERCENT) +
+                        sample * GRAPHENE_NET_SYNC_PEER_SCORE_SMOOTHING_PERCENT) / 100;
+            }
+        }
+
+        void peer_sync_score::on_batch_requested(uint32_t number_of_items) {
+            batch_request_time = fc::time_point::now();
+            batch_size = number_of_items;
+            batch_received = 0;
+        }
+
+        void peer_sync_score::on_block_received() {
+            ++blocks_delivered;
+            if (batch_size == 0) {
+                return;
+            }
+
+            fc::time_point now = fc::time_point::now();
+            bool first_batch = batches_completed == 0;
+            if (batch_received == 0) {
+                round_trip_delay = fc::microseconds(smooth_score_sample(
+                        round_trip_delay.count(), (now - batch_request_time).count(), first_batch));
+            }
+
+            if (++batch_received == batch_size) {
+                int64_t elapsed_us = std::max<int64_t>((now - batch_request_time).count(), 1);
+                double sample = double(batch_size) * 1000000 / elapsed_us;
+                blocks_per_second = smooth_score_sample(blocks_per_second, sample, first_batch);
+                ++batches_completed;
+                batch_size = 0;
+            }
+        }
+
+        void peer_sync_score::on_invalid_item() {
+            ++invalid_items;
+        }
+
+        void peer_sync_score::rotate_out(fc::time_point until) {
+            deprioritized_until = until;
+            ++times_rotated_out;
+            round_trip_delay = fc::microseconds();
+            blocks_per_second = 0;
+            batches_completed = 0;
+        }
+
+        bool peer_sync_score::is_measured() const {
+            return batches_completed >= GRAPHENE_NET_SYNC_PEER_SCORE_MIN_BATCHES;
+        }
+
+        bool peer_sync_score::is_deprioritized() const {
+            return deprioritized_until > fc::time_point::now();
+        }
+
+        double peer_sync_score::rating() const {
+            return blocks_per_second / (1 + invalid_items);
+        }
+
+        void outbound_queue_statistics::on_message_sent(size_t bytes, fc::microseconds queue_delay) {
+            if (messages_sent == 0) {
+                average_queue_delay = queue_delay;
+            } else {
+                average_queue_delay = fc::microseconds(
+                        (average_queue_delay.count() * (100 - GRAPHENE_NET_QUEUE_DELAY_SMOOTHING_PERCENT) +
+                         queue_delay.count() * GRAPHENE_NET_QUEUE_DELAY_SMOOTHING_PERCENT) / 100);
+            }
+            max_queue_delay = std::max(max_queue_delay, queue_delay);
+            ++messages_sent;
+            bytes_sent += bytes;
+        }
+
         message peer_connection::real_queued_message::get_message(peer_connection_delegate *) {
             if (message_send_time_field_offset != (size_t)-1) {
                 // patch the current time into the message.  Since this operates on the packed version of the structure,
@@ -69,6 +147,7 @@ namespace golos {
                 _node(delegate),
                 _message_connection(this),
                 _total_queued_messages_size(0),
+                _block_priority(message_priority::sync_block),
                 direction(peer_connection_direction::unknown),
                 is_firewalled(firewalled_state::unknown),
                 our_state(our_connection_state::disconnected),
@@ -269,9 +348,21 @@ namespace golos {
                     --_send_message_queue_tasks_counter; /* dlog("leaving peer_connection::send_queued_messages_task()"); */ }
             } concurrent_invocation_counter(_send_message_queue_tasks_running);
 #endif
-            while (!_queued_messages.empty()) {
-                _queued_messages.front()->transmission_start_time = fc::time_point::now();
-                message message_to_send = _queued_messages.front()->get_message(_node);
+            while (true) {
+                fc::microseconds throttle_delay;
+                outbound_queue *queue = select_next_outbound_queue(throttle_delay);
+                if (queue == nullptr) {
+                    if (throttle_delay <= fc::microseconds()) {
+                        break;
+                    }
+                    // only rate limited messages are waiting, check again shortly for messages of other classes
+                    fc::usleep(std::min(throttle_delay, fc::milliseconds(GRAPHENE_NET_RATE_LIMITED_QUEUE_POLL_MS)));
+                    continue;
+                }
+
+                queued_message &next_message = *queue->messages.front();
+                next_message.transmission_start_time = fc::time_point::now();
+                message message_to_send = next_message.get_message(_node);
                 try {
                     //dlog("peer_connection::send_queued_messages_task() calling message_oriented_connection::send_message() "
                     //     "to send message of type ${type} for peer ${endpoint}",
@@ -300,17 +391,134 @@ namespace golos {
                 catch (...) {
                     elog("message_oriented_exception::send_message() threw an unhandled exception");
                 }
-                _queued_messages.front()->transmission_finish_time = fc::time_point::now();
-                _total_queued_messages_size -= _queued_messages.front()->get_size_in_queue();
-                _queued_messages.pop();
+                next_message.transmission_finish_time = fc::time_point::now();
+
+                size_t size_in_queue = next_message.get_size_in_queue();
+                _total_queued_messages_size -= size_in_queue;
+                queue->statistics.queued_bytes -= size_in_queue;
+                --queue->statistics.queued_messages;
+                queue->statistics.on_message_sent(message_to_send.data.size(),
+                        next_message.transmission_start_time - next_message.enqueue_time);
+                queue->deficit -= message_to_send.data.size();
+                queue->rate_allowance -= message_to_send.data.size();
+                queue->messages.pop();
+                if (queue->messages.empty()) {
+                    queue->deficit = 0;
+                }
             }
             //dlog("leaving peer_connection::send_queued_messages_task() due to queue exhaustion");
         }
 
-        void peer_connection::send_queueable_message(std::unique_ptr<queued_message> &&message_to_send) {
+        void peer_connection::refill_rate_allowance(
+                outbound_queue &queue, int64_t bytes_per_second, int64_t max_allowance, fc::time_point now) {
+            if (queue.rate_allowance_time == fc::time_point()) {
+                queue.rate_allowance = max_allowance;
+            } else {
+                queue.rate_allowance = std::min<int64_t>(max_allowance,
+                        queue.rate_allowance + (now - queue.rate_allowance_time).count() * bytes_per_second / 1000000);
+            }
+            queue.rate_allowance_time = now;
+        }
+
+        peer_connection::outbound_queue *peer_connection::select_next_outbound_queue(fc::microseconds &throttle_delay) {
+            throttle_delay = fc::microseconds();
+
+            outbound_queue &control_queue = _queued_messages[size_t(message_priority::control)];
+            if (!control_queue.messages.empty()) {
+                return &control_queue;
+            }
+
+            static const int64_t budgets[message_priority_count] = {
+                0,
+                GRAPHENE_NET_NEW_BLOCK_QUEUE_BUDGET_IN_BYTES,
+                GRAPHENE_NET_INVENTORY_QUEUE_BUDGET_IN_BYTES,
+                GRAPHENE_NET_TRANSACTION_QUEUE_BUDGET_IN_BYTES,
+                GRAPHENE_NET_SYNC_BLOCK_QUEUE_BUDGET_IN_BYTES,
+                GRAPHENE_NET_ADDRESS_QUEUE_BUDGET_IN_BYTES
+            };
+
+            // the sync class waits for its rate allowance, the other classes may use the time
+            bool sync_throttled = false;
+            outbound_queue &sync_queue = _queued_messages[size_t(message_priority::sync_block)];
+            if (GRAPHENE_NET_SYNC_BLOCK_BYTES_PER_SECOND && !sync_queue.messages.empty()) {
+                refill_rate_allowance(sync_queue, GRAPHENE_NET_SYNC_BLOCK_BYTES_PER_SECOND,
+                        GRAPHENE_NET_SYNC_BLOCK_QUEUE_BUDGET_IN_BYTES, fc::time_point::now());
+                if (sync_queue.rate_allowance <= 0) {
+                    sync_throttled = true;
+                    throttle_delay = std::max(fc::milliseconds(1), fc::microseconds(
+                            (1 - sync_queue.rate_allowance) * 1000000 / GRAPHENE_NET_SYNC_BLOCK_BYTES_PER_SECOND));
+                }
+            }
+
+            while (true) {
+                bool have_messages = false;
+                for (size_t i = 1; i < message_priority_count; ++i) {
+                    outbound_queue &queue = _queued_messages[i];
+                    if (queue.messages.empty() || (sync_throttled && &queue == &sync_queue)) {
+                        continue;
+                    }
+                    if (queue.deficit > 0) {
+                        return &queue;
+                    }
+                    have_messages = true;
+                }
+                if (!have_messages) {
+                    return nullptr;
+                }
+
+                // every class with waiting messages has spent its budget, start the next round
+                for (size_t i = 1; i < message_priority_count; ++i) {
+                    if (!_queued_messages[i].messages.empty()) {
+                        _queued_messages[i].deficit += budgets[i];
+                    }
+                }
+            }
+        }
+
+        message_priority peer_connection::get_block_priority() {
+            auto wanted = peer_needs_sync_items_from_us ? message_priority::sync_block : message_priority::new_block;
+            // blocks already queued in the other class go first, the peer must get blocks in order
+            if (wanted != _block_priority && _queued_messages[size_t(_block_priority)].messages.empty()) {
+                _block_priority = wanted;
+            }
+            return _block_priority;
+        }
+
+        message_priority peer_connection::get_message_priority(const message &message_to_send) {
+            switch (message_to_send.msg_type) {
+                case block_message_type:
+                    return get_block_priority();
+                case trx_message_type:
+                    return message_priority::transaction;
+                case item_ids_inventory_message_type:
+                case blockchain_item_ids_inventory_message_type:
+                    return message_priority::inventory;
+                case address_message_type:
+                    return message_priority::address_gossip;
+                default:
+                    return message_priority::control;
+            }
+        }
+
+        message_priority peer_connection::get_item_priority(const item_id &item_to_send) {
+            if (item_to_send.item_type == block_message_type) {
+                return get_block_priority();
+            }
+            return message_priority::transaction;
+        }
+
+        const outbound_queue_statistics &peer_connection::get_outbound_queue_statistics(message_priority priority) const {
+            return _queued_messages[size_t(priority)].statistics;
+        }
+
+        void peer_connection::send_queueable_message(std::unique_ptr<queued_message> &&message_to_send, message_priority priority) {
             VERIFY_CORRECT_THREAD();
-            _total_queued_messages_size += message_to_send->get_size_in_queue();
-            _queued_messages.emplace(std::move(message_to_send));
+            outbound_queue &queue = _queued_messages[size_t(priority)];
+            size_t size_in_queue = message_to_send->get_size_in_queue();
+            _total_queued_messages_size += size_in_queue;
+            queue.statistics.queued_bytes += size_in_queue;
+            ++queue.statistics.queued_messages;
+            queue.messages.emplace(std::move(message_to_send));
             if (_total_queued_messages_size >
                 GRAPHENE_NET_MAXIMUM_QUEUED_MESSAGES_IN_BYTES) {
                 elog("send queue exceeded maximum size of ${max} bytes (current size ${current} bytes)",
@@ -342,7 +550,7 @@ namespace golos {
             //dlog("peer_connection::send_message() enqueueing message of type ${type} for peer ${endpoint}",
             //     ("type", message_to_send.msg_type)("endpoint", get_remote_endpoint()));
             std::unique_ptr<queued_message> message_to_enqueue(new real_queued_message(message_to_send, message_send_time_field_offset));
-            send_queueable_message(std::move(message_to_enqueue));
+            send_queueable_message(std::move(message_to_enqueue), get_message_priority(message_to_send));
         }
 
         void peer_connection::send_item(const item_id &item_to_send) {
@@ -350,7 +558,7 @@ namespace golos {
             //dlog("peer_connection::send_item() enqueueing message of type ${type} for peer ${endpoint}",
             //     ("type", item_to_send.item_type)("endpoint", get_remote_endpoint()));
             std::unique_ptr<queued_message> message_to_enqueue(new virtual_queued_message(item_to_send));
-            send_queueable_message(std::move(message_to_enqueue));
+            send_queueable_message(std::move(message_to_enqueue), get_item_priority(item_to_send));
         }
 
         void peer_connection::close_connection() {
@@ -26,11 +26,17 @@
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/mem_fun.hpp>
+#include <boost/multi_index/composite_key.hpp>
 
 #include <fc/io/raw.hpp>
 #include <fc/io/json.hpp>
+#include <fc/filesystem.hpp>
 
 #include <golos/network/peer_database.hpp>
+#include <golos/network/config.hpp>
+
+#include <cstring>
+#include <fstream>
 
 
 namespace golos {
@@ -38,17 +44,39 @@ namespace golos {
         namespace detail {
             using namespace boost::multi_index;
 
+            /**
+             * The peer database is stored as an append-only log of binary records.  The file starts
+             * with a header, followed by entries of the form [uint32 size][packed entry].  Every
+             * change appends one entry, entries are buffered and written in batches; the log is rewritten in compacted form on open, on close,
+             * and whenever it grows much larger than the set of live records.  A truncated entry at
+             * the tail (e.g. after a crash) is ignored.
+             */
+            namespace peer_database_file {
+                constexpr uint32_t magic = 0x42445047; // "GPDB"
+                constexpr uint32_t version = 1;
+
+                enum entry_type : uint8_t {
+                    update_entry = 0,
+                    erase_entry = 1
+                };
+            }
+
             class peer_database_impl {
             public:
-                struct last_seen_time_index {
+                struct connection_priority_index {
                 };
                 struct endpoint_index {
                 };
                 typedef boost::multi_index_container<potential_peer_record,
-                        indexed_by<ordered_non_unique<tag<last_seen_time_index>,
-                                member<potential_peer_record,
-                                        fc::time_point_sec,
-                                        &potential_peer_record::last_seen_time>>,
+                        indexed_by<ordered_non_unique<tag<connection_priority_index>,
+                                composite_key<potential_peer_record,
+                                        member<potential_peer_record,
+                                                fc::time_point_sec,
+                                                &potential_peer_record::last_successful_connection_time>,
+                                        member<potential_peer_record,
+                                                fc::time_point_sec,
+                                                &potential_peer_record::last_seen_time>>,
+                                composite_key_compare<std::greater<fc::time_point_sec>, std::greater<fc::time_point_sec>>>,
                                 hashed_unique<tag<endpoint_index>,
                                         member<potential_peer_record,
                                                 fc::ip::endpoint,
@@ -58,6 +86,24 @@ namespace golos {
             private:
                 potential_peer_set _potential_peer_set;
                 fc::path _peer_database_filename;
+                std::ofstream _log;
+                size_t _log_entry_count = 0;
+                /// entries not written to the log yet
+                std::vector<char> _pending_entries;
+                size_t _pending_entry_count = 0;
+                fc::time_point _last_flush_time;
+
+                void load_log(const fc::path &filename);
+
+                void load_legacy_json(const fc::path &filename);
+
+                void apply_log_entry(fc::datastream<const char *> &ds);
+
+                void append_log_entry(const std::vector<char> &packed_entry);
+
+                void expire_and_prune();
+
+                void compact();
 
             public:
                 void open(const fc::path &databaseFilename);
@@ -70,6 +116,8 @@ namespace golos {
 
                 void update_entry(const potential_peer_record &updatedRecord);
 
+                void flush();
+
                 potential_peer_record lookup_or_create_entry_for_endpoint(const fc::ip::endpoint &endpointToLookup);
 
                 fc::optional<potential_peer_record> lookup_entry_for_endpoint(const fc::ip::endpoint &endpointToLookup);
@@ -83,10 +131,10 @@ namespace golos {
 
             class peer_database_iterator_impl {
             public:
-                typedef peer_database_impl::potential_peer_set::index<peer_database_impl::last_seen_time_index>::type::iterator last_seen_time_index_iterator;
-                last_seen_time_index_iterator _iterator;
+                typedef peer_database_impl::potential_peer_set::index<peer_database_impl::connection_priority_index>::type::iterator connection_priority_index_iterator;
+                connection_priority_index_iterator _iterator;
 
-                peer_database_iterator_impl(const last_seen_time_index_iterator &iterator)
+                peer_database_iterator_impl(const connection_priority_index_iterator &iterator)
                         :
                         _iterator(iterator) {
                 }
@@ -97,64 +145,275 @@ namespace golos {
                     boost::iterator_facade<peer_database_iterator, const potential_peer_record, boost::forward_traversal_tag>(c) {
             }
 
-            void peer_database_impl::open(const fc::path &peer_database_filename) {
-                _peer_database_filename = peer_database_filename;
-                if (fc::exists(_peer_database_filename)) {
+            namespace {
+                potential_peer_record record_to_persist(const potential_peer_record &record) {
+                    // the last error is only useful for diagnostics of the running node and is by far
+                    // the largest part of the record, so it is not persisted
+                    potential_peer_record result = record;
+                    result.last_error.reset();
+                    return result;
+                }
+
+                std::vector<char> pack_update_entry(const potential_peer_record &record) {
+                    std::vector<char> result = fc::raw::pack(uint8_t(peer_database_file::update_entry));
+                    std::vector<char> packed_record = fc::raw::pack(record_to_persist(record));
+                    result.insert(result.end(), packed_record.begin(), packed_record.end());
+                    return result;
+                }
+
+                std::vector<char> pack_erase_entry(const fc::ip::endpoint &endpoint) {
+                    std::vector<char> result = fc::raw::pack(uint8_t(peer_database_file::erase_entry));
+                    std::vector<char> packed_endpoint = fc::raw::pack(endpoint);
+                    result.insert(result.end(), packed_endpoint.begin(), packed_endpoint.end());
+                    return result;
+                }
+
+                void write_log_entry(std::ostream &stream, const std::vector<char> &packed_entry) {
+                    uint32_t entry_size = packed_entry.size();
+                    stream.write(reinterpret_cast<const char *>(&entry_size), sizeof(entry_size));
+                    stream.write(packed_entry.data(), packed_entry.size());
+                }
+
+                void write_log_entry(std::vector<char> &buffer, const std::vector<char> &packed_entry) {
+                    uint32_t entry_size = packed_entry.size();
+                    const char *size_data = reinterpret_cast<const char *>(&entry_size);
+                    buffer.insert(buffer.end(), size_data, size_data + sizeof(entry_size));
+                    buffer.insert(buffer.end(), packed_entry.begin(), packed_entry.end());
+                }
+
+                void write_log_header(std::ostream &stream) {
+                    stream.write(reinterpret_cast<const char *>(&peer_database_file::magic), sizeof(peer_database_file::magic));
+                    stream.write(reinterpret_cast<const char *>(&peer_database_file::version), sizeof(peer_database_file::version));
+                }
+            }
+
+            void peer_database_impl::apply_log_entry(fc::datastream<const char *> &ds) {
+                uint8_t type;
+                fc::raw::unpack(ds, type);
+                if (type == peer_database_file::update_entry) {
+                    potential_peer_record record;
+                    fc::raw::unpack(ds, record);
+                    auto iter = _potential_peer_set.get<endpoint_index>().find(record.endpoint);
+                    if (iter != _potential_peer_set.get<endpoint_index>().end()) {
+                        _potential_peer_set.get<endpoint_index>().replace(iter, record);
+                    } else {
+                        _potential_peer_set.get<endpoint_index>().insert(record);
+                    }
+                } else if (type == peer_database_file::erase_entry) {
+                    fc::ip::endpoint endpoint;
+                    fc::raw::unpack(ds, endpoint);
+                    _potential_peer_set.get<endpoint_index>().erase(endpoint);
+                } else {
+                    FC_THROW("Unknown peer database entry type ${type}", ("type", type));
+                }
+            }
+
+            void peer_database_impl::load_log(const fc::path &filename) {
+                std::ifstream stream(filename.generic_string(), std::ios::in | std::ios::binary);
+                std::vector<char> data((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+                size_t pos = 0;
+                auto read_uint32 = [&](uint32_t &value) {
+                    if (pos + sizeof(value) > data.size()) {
+                        return false;
+                    }
+                    memcpy(&value, data.data() + pos, sizeof(value));
+                    pos += sizeof(value);
+                    return true;
+                };
+
+                uint32_t file_magic = 0;
+                uint32_t file_version = 0;
+                FC_ASSERT(read_uint32(file_magic) && file_magic == peer_database_file::magic, "Not a peer database file");
+                FC_ASSERT(read_uint32(file_version) && file_version == peer_database_file::version,
+                        "Unsupported peer database version ${v}", ("v", file_version));
+
+                uint32_t entry_size = 0;
+                while (read_uint32(entry_size)) {
+                    if (pos + entry_size > data.size()) {
+                        wlog("ignoring truncated entry at the end of peer database ${filename}", ("filename", filename));
+                        break;
+                    }
+                    fc::datastream<const char *> ds(data.data() + pos, entry_size);
+                    apply_log_entry(ds);
+                    pos += entry_size;
+                    ++_log_entry_count;
+                }
+            }
+
+            void peer_database_impl::load_legacy_json(const fc::path &filename) {
+                std::vector<potential_peer_record> peer_records = fc::json::from_file(filename).as<std::vector<potential_peer_record>>();
+                std::copy(peer_records.begin(), peer_records.end(), std::inserter(_potential_peer_set, _potential_peer_set.end()));
+                ilog("imported ${count} peers from legacy peer database ${filename}",
+                        ("count", _potential_peer_set.size())("filename", filename));
+            }
+
+            void peer_database_impl::expire_and_prune() {
+                // forget peers nobody has told us about in a long time
+                fc::time_point_sec expiration_time = fc::time_point::now() -
+                        fc::seconds(GRAPHENE_PEER_DATABASE_EXPIRATION_SEC);
+                auto &by_endpoint = _potential_peer_set.get<endpoint_index>();
+                for (auto iter = by_endpoint.begin(); iter != by_endpoint.end();) {
+                    if (iter->last_seen_time < expiration_time &&
+                        iter->last_successful_connection_time < expiration_time) {
+                        iter = by_endpoint.erase(iter);
+                    } else {
+                        ++iter;
+                    }
+                }
+
+                // prune database to a reasonable size, keeping the peers we connected to most recently
+                if (_potential_peer_set.size() > GRAPHENE_PEER_DATABASE_MAX_SIZE) {
+                    auto &by_priority = _potential_peer_set.get<connection_priority_index>();
+                    auto iter = by_priority.begin();
+                    std::advance(iter, GRAPHENE_PEER_DATABASE_MAX_SIZE);
+                    by_priority.erase(iter, by_priority.end());
+                }
+            }
+
+            void peer_database_impl::compact() {
+                if (_log.is_open()) {
+                    _log.close();
+                }
+                // the compacted log is written from the memory, so it contains the buffered changes
+                _pending_entries.clear();
+                _pending_entry_count = 0;
+                _last_flush_time = fc::time_point::now();
+
+                fc::path peer_database_filename_dir = _peer_database_filename.parent_path();
+                if (!fc::exists(peer_database_filename_dir)) {
+                    fc::create_directories(peer_database_filename_dir);
+                }
+
+                fc::path temp_filename = peer_database_filename_dir /
+                                         (_peer_database_filename.filename().string() + ".tmp");
+                {
+                    std::ofstream stream(temp_filename.generic_string(), std::ios::out | std::ios::binary | std::ios::trunc);
+                    write_log_header(stream);
+                    for (const potential_peer_record &record : _potential_peer_set.get<connection_priority_index>()) {
+                        write_log_entry(stream, pack_update_entry(record));
+                    }
+                    stream.flush();
+                    FC_ASSERT(stream.good(), "Unable to write peer database ${filename}", ("filename", temp_filename));
+                }
+                fc::rename(temp_filename, _peer_database_filename);
+                _log_entry_count = _potential_peer_set.size();
+
+                _log.open(_peer_database_filename.generic_string(), std::ios::out | std::ios::binary | std::ios::app);
+            }
+
+            void peer_database_impl::append_log_entry(const std::vector<char> &packed_entry) {
+                if (!_log.is_open()) {
+                    return;
+                }
+
+                write_log_entry(_pending_entries, packed_entry);
+                ++_pending_entry_count;
+                ++_log_entry_count;
+
+                if (_pending_entry_count >= GRAPHENE_PEER_DATABASE_FLUSH_MAX_ENTRIES ||
+                    fc::time_point::now() - _last_flush_time >= fc::seconds(GRAPHENE_PEER_DATABASE_FLUSH_INTERVAL_SEC)) {
+                    flush();
+                }
+
+                if (_log_entry_count > GRAPHENE_PEER_DATABASE_MAX_SIZE &&
+                    _log_entry_count > _potential_peer_set.size() * 4) {
                     try {
-                        std::vector<potential_peer_record> peer_records = fc::json::from_file(_peer_database_filename).as<std::vector<potential_peer_record>>();
-                        std::copy(peer_records.begin(), peer_records.end(), std::inserter(_potential_peer_set, _potential_peer_set.end()));
-#define MAXIMUM_PEERDB_SIZE 1000
-                        if (_potential_peer_set.size() > MAXIMUM_PEERDB_SIZE) {
-                            // prune database to a reasonable size
-                            auto iter = _potential_peer_set.begin();
-                            std::advance(iter, MAXIMUM_PEERDB_SIZE);
-                            _potential_peer_set.erase(iter, _potential_peer_set.end());
-                        }
+                        compact();
                     }
                     catch (const fc::exception &e) {
-                        elog("error opening peer database file ${peer_database_filename}, starting with a clean database",
-                                ("peer_database_filename", _peer_database_filename));
+                        elog("error compacting peer database ${peer_database_filename}: ${e}",
+                                ("peer_database_filename", _peer_database_filename)("e", e.to_detail_string()));
                     }
                 }
             }
 
-            void peer_database_impl::close() {
-                std::vector<potential_peer_record> peer_records;
-                peer_records.reserve(_potential_peer_set.size());
-                std::copy(_potential_peer_set.begin(), _potential_peer_set.end(), std::back_inserter(peer_records));
+            void peer_database_impl::flush() {
+                if (!_log.is_open() || _pending_entries.empty()) {
+                    return;
+                }
+
+                _log.write(_pending_entries.data(), _pending_entries.size());
+                _log.flush();
+                _pending_entries.clear();
+                _pending_entry_count = 0;
+                _last_flush_time = fc::time_point::now();
+            }
 
+            void peer_database_impl::open(const fc::path &peer_database_filename) {
+                _peer_database_filename = peer_database_filename;
+                _log_entry_count = 0;
+                fc::path legacy_filename = peer_database_filename.parent_path() /
+                                           (peer_database_filename.stem().string() + ".json");
                 try {
-                    fc::path peer_database_filename_dir = _peer_database_filename.parent_path();
-                    if (!fc::exists(peer_database_filename_dir)) {
-                        fc::create_directories(peer_database_filename_dir);
+                    if (fc::exists(_peer_database_filename)) {
+                        load_log(_peer_database_filename);
+                    } else if (fc::exists(legacy_filename)) {
+                        load_legacy_json(legacy_filename);
                     }
-                    fc::json::save_to_file(peer_records, _peer_database_filename);
+                }
+                catch (const fc::exception &e) {
+                    elog("error opening peer database file ${peer_database_filename}, starting with a clean database",
+                            ("peer_database_filename", _peer_database_filename));
+                    _potential_peer_set.clear();
+                }
+
+                expire_and_prune();
+
+                try {
+                    compact();
+                }
+                catch (const fc::exception &e) {
+                    elog("error writing peer database file ${peer_database_filename}: ${e}",
+                            ("peer_database_filename", _peer_database_filename)("e", e.to_detail_string()));
+                }
+            }
+
+            void peer_database_impl::close() {
+                try {
+                    expire_and_prune();
+                    compact();
                 }
                 catch (const fc::exception &e) {
                     elog("error saving peer database to file ${peer_database_filename}",
                             ("peer_database_filename", _peer_database_filename));
                 }
+                if (_log.is_open()) {
+                    _log.close();
+                }
                 _potential_peer_set.clear();
             }
 
             void peer_database_impl::clear() {
                 _potential_peer_set.clear();
+                if (_log.is_open()) {
+                    try {
+                        compact();
+                    }
+                    catch (const fc::exception &e) {
+                        elog("error clearing peer database file ${peer_database_filename}: ${e}",
+                                ("peer_database_filename", _peer_database_filename)("e", e.to_detail_string()));
+                    }
+                }
             }
 
             void peer_database_impl::erase(const fc::ip::endpoint &endpointToErase) {
                 auto iter = _potential_peer_set.get<endpoint_index>().find(endpointToErase);
                 if (iter != _potential_peer_set.get<endpoint_index>().end()) {
                     _potential_peer_set.get<endpoint_index>().erase(iter);
+                    append_log_entry(pack_erase_entry(endpointToErase));
                 }
             }
 
             void peer_database_impl::update_entry(const potential_peer_record &updatedRecord) {
+                const potential_peer_record &record = updatedRecord;
                 auto iter = _potential_peer_set.get<endpoint_index>().find(updatedRecord.endpoint);
                 if (iter != _potential_peer_set.get<endpoint_index>().end()) {
-                    _potential_peer_set.get<endpoint_index>().modify(iter, [&updatedRecord](potential_peer_record &record) { record = updatedRecord; });
+                    _potential_peer_set.get<endpoint_index>().modify(iter, [&record](potential_peer_record &stored_record) { stored_record = record; });
                 } else {
-                    _potential_peer_set.get<endpoint_index>().insert(updatedRecord);
+                    _potential_peer_set.get<endpoint_index>().insert(record);
                 }
+                append_log_entry(pack_update_entry(record));
             }
 
             potential_peer_record peer_database_impl::lookup_or_create_entry_for_endpoint(const fc::ip::endpoint &endpointToLookup) {
@@ -174,11 +433,11 @@ namespace golos {
             }
 
             peer_database::iterator peer_database_impl::begin() const {
-                return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<last_seen_time_index>().begin()));
+                return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<connection_priority_index>().begin()));
             }
 
             peer_database::iterator peer_database_impl::end() const {
-                return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<last_seen_time_index>().end()));
+                return peer_database::iterator(new peer_database_iterator_impl(_potential_peer_set.get<connection_priority_index>().end()));
             }
 
             size_t peer_database_impl::size() const {
@@ -237,6 +496,10 @@ namespace golos {
             my->update_entry(updatedRecord);
         }
 
+        void peer_database::flush() {
+            my->flush();
+        }
+
         potential_peer_record peer_database::lookup_or_create_entry_for_endpoint(const fc::ip::endpoint &endpointToLookup) {
             return my->lookup_or_create_entry_for_endpoint(endpointToLookup);
         }
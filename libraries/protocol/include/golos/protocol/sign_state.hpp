@@ -3,10 +3,21 @@
 #include <golos/protocol/authority.hpp>
 #include <golos/protocol/types.hpp>
 
+#include <deque>
+
 namespace golos { namespace protocol {
 
     using authority_getter = std::function< authority (const account_name_type&) > ;
 
+    /**
+     *  Returns an authority owned by the caller, it should stay valid until the verification ends,
+     *  so authorities are checked without copies.
+     */
+    using authority_view_getter = std::function< const authority* (const account_name_type&) >;
+
+    /** Adapts the getter by value, fetched authorities are kept in the storage */
+    authority_view_getter make_authority_view(const authority_getter& get, std::deque<authority>& storage);
+
     struct sign_state {
         /** returns true if we have a signature for this key or can
          * produce a signature for this key, else returns false.
@@ -30,7 +41,15 @@ namespace golos { namespace protocol {
             const authority_getter& a,
             const flat_set<public_key_type>& keys);
 
-        const authority_getter& get_active;
+        sign_state(
+            const flat_set<public_key_type>& sigs,
+            const authority_view_getter& a,
+            const flat_set<public_key_type>& keys);
+
+        sign_state(const sign_state&) = delete;
+
+        std::deque<authority> fetched_authorities;
+        authority_view_getter get_active;
         const fc::flat_set<public_key_type>& available_keys;
 
         fc::flat_map<public_key_type, bool> provided_signatures;
@@ -78,6 +78,14 @@ namespace golos { namespace protocol {
                     const authority_getter &get_posting,
                     uint32_t max_recursion = STEEMIT_MAX_SIG_CHECK_DEPTH) const;
 
+            /** Authorities are checked in place, the node passes its cached authorities */
+            void verify_authority(
+                    const chain_id_type &chain_id,
+                    const authority_view_getter &get_active,
+                    const authority_view_getter &get_owner,
+                    const authority_view_getter &get_posting,
+                    uint32_t max_recursion = STEEMIT_MAX_SIG_CHECK_DEPTH) const;
+
             set<public_key_type> minimize_required_signatures(
                     const chain_id_type &chain_id,
                     const flat_set<public_key_type> &available_keys,
@@ -109,6 +117,16 @@ namespace golos { namespace protocol {
                 const flat_set<account_name_type> &owner_aprovals = flat_set<account_name_type>(),
                 const flat_set<account_name_type> &posting_approvals = flat_set<account_name_type>());
 
+        void verify_authority(const vector<operation> &ops, const flat_set<public_key_type> &sigs,
+                const authority_view_getter &get_active,
+                const authority_view_getter &get_owner,
+                const authority_view_getter &get_posting,
+                uint32_t max_recursion = STEEMIT_MAX_SIG_CHECK_DEPTH,
+                bool allow_committe = false,
+                const flat_set<account_name_type> &active_aprovals = flat_set<account_name_type>(),
+                const flat_set<account_name_type> &owner_aprovals = flat_set<account_name_type>(),
+                const flat_set<account_name_type> &posting_approvals = flat_set<account_name_type>());
+
 
         struct annotated_signed_transaction : public signed_transaction {
             annotated_signed_transaction() {
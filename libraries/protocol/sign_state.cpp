@@ -3,6 +3,13 @@
 
 namespace golos { namespace protocol {
 
+    authority_view_getter make_authority_view(const authority_getter& get, std::deque<authority>& storage) {
+        return [get, &storage](const account_name_type& name) {
+            storage.push_back(get(name));
+            return &storage.back();
+        };
+    }
+
     bool sign_state::signed_by(const public_key_type& k) {
         auto itr = provided_signatures.find(k);
         if (itr == provided_signatures.end()) {
@@ -22,7 +29,7 @@ namespace golos { namespace protocol {
             itr->second = true;
             return true;
         }
-        return check_authority(get_active(id));
+        return check_authority(*get_active(id));
     }
 
     bool sign_state::check_authority(const authority& auth, uint32_t depth) {
@@ -41,7 +48,7 @@ namespace golos { namespace protocol {
                 if (depth == max_recursion) {
                     continue;
                 }
-                if (check_authority(get_active(a.first), depth + 1)) {
+                if (check_authority(*get_active(a.first), depth + 1)) {
                     approved_by[a.first] = true;
                     total_weight += a.second;
                     if (total_weight >= auth.weight_threshold) {
@@ -94,6 +101,19 @@ namespace golos { namespace protocol {
         const flat_set<public_key_type>& sigs,
         const authority_getter& a,
         const flat_set<public_key_type>& keys
+    ) : get_active(make_authority_view(a, fetched_authorities)),
+        available_keys(keys)
+    {
+        for (const auto& key: sigs) {
+            provided_signatures[key] = false;
+        }
+        approved_by["temp"] = true;
+    }
+
+    sign_state::sign_state(
+        const flat_set<public_key_type>& sigs,
+        const authority_view_getter& a,
+        const flat_set<public_key_type>& keys
     ) : get_active(a),
         available_keys(keys)
     {
@@ -106,9 +106,9 @@ namespace golos {
         void verify_authority(
             const std::vector<operation>& ops,
             const fc::flat_set<public_key_type>& sigs,
-            const authority_getter& get_active,
-            const authority_getter& get_owner,
-            const authority_getter& get_posting,
+            const authority_view_getter& get_active,
+            const authority_view_getter& get_owner,
+            const authority_view_getter& get_posting,
             uint32_t max_recursion_depth,
             bool allow_committe,
             const flat_set<account_name_type>& active_aprovals,
@@ -148,8 +148,8 @@ namespace golos {
 
                 for (const auto& id: required_posting) {
                     if (!s.check_authority(id) &&
-                        !s.check_authority(get_active(id)) &&
-                        !s.check_authority(get_owner(id))
+                        !s.check_authority(*get_active(id)) &&
+                        !s.check_authority(*get_owner(id))
                     ) {
                         missing_accounts.push_back(id);
                     }
@@ -196,7 +196,7 @@ namespace golos {
 
             // fetch all of the top level authorities
             for (const auto& id: required_active) {
-                if (!s.check_authority(id) && !s.check_authority(get_owner(id))) {
+                if (!s.check_authority(id) && !s.check_authority(*get_owner(id))) {
                     missing_accounts.push_back(id);
                 }
             }
@@ -213,7 +213,7 @@ namespace golos {
                 });
 
             for (const auto& id: required_owner) {
-                if (owner_approvals.find(id) == owner_approvals.end() && !s.check_authority(get_owner(id))) {
+                if (owner_approvals.find(id) == owner_approvals.end() && !s.check_authority(*get_owner(id))) {
                     missing_accounts.push_back(id);
                 } else {
                     s.approved_by[id] = true;
@@ -234,6 +234,27 @@ namespace golos {
             assert_unused_approvals(s);
         } FC_CAPTURE_AND_RETHROW((ops)(sigs)) }
 
+        void verify_authority(
+            const std::vector<operation>& ops,
+            const fc::flat_set<public_key_type>& sigs,
+            const authority_getter& get_active,
+            const authority_getter& get_owner,
+            const authority_getter& get_posting,
+            uint32_t max_recursion_depth,
+            bool allow_committe,
+            const flat_set<account_name_type>& active_aprovals,
+            const flat_set<account_name_type>& owner_approvals,
+            const flat_set<account_name_type>& posting_approvals
+        ) {
+            std::deque<authority> fetched;
+            verify_authority(
+                ops, sigs,
+                make_authority_view(get_active, fetched),
+                make_authority_view(get_owner, fetched),
+                make_authority_view(get_posting, fetched),
+                max_recursion_depth, allow_committe, active_aprovals, owner_approvals, posting_approvals);
+        }
+
 
         flat_set<public_key_type> signed_transaction::get_signature_keys(const chain_id_type &chain_id) const {
             try {
@@ -359,5 +380,16 @@ namespace golos {
             } FC_CAPTURE_AND_RETHROW((*this))
         }
 
+        void signed_transaction::verify_authority(
+                const chain_id_type &chain_id,
+                const authority_view_getter &get_active,
+                const authority_view_getter &get_owner,
+                const authority_view_getter &get_posting,
+                uint32_t max_recursion) const {
+            try {
+                golos::protocol::verify_authority(operations, get_signature_keys(chain_id), get_active, get_owner, get_posting, max_recursion);
+            } FC_CAPTURE_AND_RETHROW((*this))
+        }
+
     }
 } // golos::protocol
@@ -109,6 +109,9 @@ FC_REFLECT_ENUM(golos::plugins::account_history::operation_direction, (any)(send
 FC_REFLECT((golos::plugins::account_history::account_history_query),
     (select_ops)(filter_ops)(direction))
 
+FC_REFLECT((golos::plugins::account_history::account_history_object),
+    (id)(account)(block)(sequence)(op_tag)(dir)(op))
+
 CHAINBASE_SET_INDEX_TYPE(
     golos::plugins::account_history::account_history_object,
     golos::plugins::account_history::account_history_index)
@@ -538,21 +538,31 @@ if (options.count(name)) { \
         if (options.count("history-blocks")) {
             uint32_t history_blocks = options.at("history-blocks").as<uint32_t>();
             pimpl->history_blocks = history_blocks;
-            pimpl->db.applied_block.connect([&](const signed_block& block){
+            pimpl->db.applied_block.connect(pimpl->db.with_applied_block_profile(name(), [&](const signed_block& block){
                 pimpl->erase_old_blocks();
-            });
+            }));
         } else {
             pimpl->history_blocks = UINT32_MAX;
         }
         ilog("account_history: history-blocks ${s}", ("s", pimpl->history_blocks));
 
         // this is worked, because the appbase initialize required plugins at first
-        pimpl->db.pre_apply_operation.connect([&](operation_notification& note) {
+        pimpl->db.pre_apply_operation.connect(pimpl->db.with_operation_cost(name(), [&](operation_notification& note) {
             pimpl->on_operation(note);
-        });
+        }));
 
         add_plugin_index<account_history_index>(pimpl->db);
 
+        // the history is built from stored operations only, so it can be reindexed without replaying the state
+        pimpl->db.add_operation_consumer(name(), [&]() {
+            const auto& idx = pimpl->db.get_index<account_history_index>().indices();
+            while (!idx.empty()) {
+                pimpl->db.remove(*idx.begin());
+            }
+        }, [&](const operation_notification& note) {
+            pimpl->on_operation(note);
+        });
+
         using pairstring = std::pair<std::string, std::string>;
         fc::flat_map<std::string, std::string> ranges;
         LOAD_VALUE_SET(options, "track-account-range", ranges, pairstring);
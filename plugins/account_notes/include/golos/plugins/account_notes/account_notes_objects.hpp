@@ -95,6 +95,10 @@ using account_note_stats_index = multi_index_container<
 
 } } } // golos::plugins::account_notes
 
+FC_REFLECT((golos::plugins::account_notes::account_note_object), (id)(account)(key)(value))
+
+FC_REFLECT((golos::plugins::account_notes::account_note_stats_object), (id)(account)(note_count))
+
 CHAINBASE_SET_INDEX_TYPE(
     golos::plugins::account_notes::account_note_object,
     golos::plugins::account_notes::account_note_index)
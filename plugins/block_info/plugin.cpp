@@ -145,9 +145,9 @@ void plugin::plugin_initialize(const boost::program_options::variables_map &opti
 
     my.reset(new plugin_impl);
 
-    my->applied_block_conn_ = db.applied_block.connect([this](const protocol::signed_block &b) {
+    my->applied_block_conn_ = db.applied_block.connect(db.with_applied_block_profile(name(), [this](const protocol::signed_block &b) {
         on_applied_block(b);
-    });
+    }));
 
     JSON_RPC_REGISTER_API ( name() ) ;
 }
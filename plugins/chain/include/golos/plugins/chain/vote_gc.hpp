@@ -0,0 +1,91 @@
+#pragma once
+
+#include <golos/chain/database.hpp>
+#include <golos/chain/comment_object.hpp>
+
+//
+// Plugins should #define their SPACE_ID's so plugins with
+// conflicting SPACE_ID assignments can be compiled into the
+// same binary (by simply re-assigning some of the conflicting #defined
+// SPACE_ID's in a build script).
+//
+// Assignment of SPACE_ID's cannot be done at run-time because
+// various template automagic depends on them being known at compile
+// time.
+//
+
+#ifndef CHAIN_PLUGIN_SPACE_ID
+#define CHAIN_PLUGIN_SPACE_ID 15
+#endif
+
+namespace golos { namespace plugins { namespace chain {
+
+using chainbase::allocator;
+using chainbase::object;
+using chainbase::object_id;
+using golos::chain::by_id;
+using namespace boost::multi_index;
+
+enum chain_plugin_object_types {
+    vote_gc_object_type = (CHAIN_PLUGIN_SPACE_ID << 8)
+};
+
+/**
+ *  Position of the vote cleaner in the by_vote_last_update index. It's kept in the state, so it follows
+ *  popped blocks and survives restarts.
+ */
+class vote_gc_object final : public object<vote_gc_object_type, vote_gc_object> {
+public:
+    template<typename Constructor, typename Allocator>
+    vote_gc_object(Constructor&& c, allocator<Allocator> a) {
+        c(*this);
+    }
+
+    id_type id;
+
+    /// votes updated before it are removed or can't be removed anymore
+    time_point_sec cursor;
+    uint64_t removed_votes = 0;
+};
+
+using vote_gc_id_type = object_id<vote_gc_object>;
+
+using vote_gc_index = multi_index_container<
+    vote_gc_object,
+    indexed_by<
+        ordered_unique<
+            tag<by_id>,
+            member<vote_gc_object, vote_gc_id_type, &vote_gc_object::id>>>,
+    allocator<vote_gc_object>>;
+
+struct vote_gc_options {
+    /// votes of paid out comments are removed when they are older than ttl
+    fc::microseconds ttl = fc::microseconds::maximum();
+    /// remove all votes of paid out comments regardless of their age
+    bool remove_any = false;
+    /// maximum number of checked votes, 0 is unlimited
+    uint32_t max_votes = 0;
+    /// maximum time of the call, 0 is unlimited
+    fc::microseconds max_time;
+};
+
+struct vote_gc_result {
+    uint32_t checked = 0;
+    uint32_t removed = 0;
+    /// the position to continue from
+    time_point_sec cursor;
+};
+
+/**
+ *  Removes votes of paid out comments starting from the cursor, the index is ordered by the vote time.
+ *  It stops at the first vote, which is too young to be removed, or when the budget is exhausted.
+ *  Votes of not paid out comments are skipped only when they are older than any payout window,
+ *  they'll never be marked as paid out, so the cursor doesn't have to return to them.
+ */
+vote_gc_result remove_old_votes(golos::chain::database &db, time_point_sec cursor, const vote_gc_options &opts);
+
+} } } // golos::plugins::chain
+
+FC_REFLECT((golos::plugins::chain::vote_gc_object), (id)(cursor)(removed_votes))
+
+CHAINBASE_SET_INDEX_TYPE(golos::plugins::chain::vote_gc_object, golos::plugins::chain::vote_gc_index)
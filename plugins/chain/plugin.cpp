@@ -1,4 +1,6 @@
 #include <golos/plugins/chain/plugin.hpp>
+#include <golos/plugins/chain/vote_gc.hpp>
+#include <golos/chain/index.hpp>
 #include <golos/chain/database_exceptions.hpp>
 #include <golos/chain/comment_object.hpp>
 #include <golos/protocol/protocol.hpp>
@@ -7,6 +9,8 @@
 #include <fc/io/json.hpp>
 #include <fc/string.hpp>
 
+#include <boost/algorithm/string.hpp>
+
 #include <iostream>
 #include <future>
 
@@ -25,11 +29,22 @@ namespace golos { namespace plugins { namespace chain {
         bool replay_if_corrupted = true;
         bool force_replay = false;
         bool resync = false;
+        bfs::path load_snapshot_dir;
+        bfs::path create_snapshot_dir;
+        uint32_t snapshot_write_threads = 0;
         bool readonly = false;
         bool check_locks = false;
         bool validate_invariants = false;
         uint32_t flush_interval = 0;
+        uint64_t flush_state_rate = 0;
         flat_map<uint32_t, block_id_type> loaded_checkpoints;
+        bool checkpoint_trusted_sync = false;
+        bool undo_profiling = false;
+        bool block_profiler = false;
+        uint32_t block_profiler_window = 1200;
+        uint32_t slow_block_time = 500;
+        bool operation_cost_accounting = false;
+        std::vector<std::string> replay_plugins;
 
         uint32_t allow_future_time = 5;
 
@@ -44,11 +59,20 @@ namespace golos { namespace plugins { namespace chain {
 
         uint32_t clear_votes_before_block = 0;
         uint32_t clear_votes_older_n_blocks = 0xFFFFFFFF;
+        uint32_t clear_votes_per_block = 1000;
+        uint32_t clear_votes_time_per_block = 2000;
         bool enable_plugins_on_push_transaction;
 
         uint32_t block_num_check_free_size = 0;
+        uint32_t shared_memory_growth_horizon = 0;
+        bool preallocate_shared_memory = true;
+        golos::chain::shared_memory_policy shared_memory_policy;
 
         bool skip_virtual_ops = false;
+        uint32_t comment_cashout_threads = 0;
+        bool maintenance_scheduler = true;
+        uint32_t transaction_check_threads = 1;
+        bool state_digest = false;
 
         golos::chain::database db;
 
@@ -77,23 +101,35 @@ namespace golos { namespace plugins { namespace chain {
         void accept_transaction(const protocol::signed_transaction& trx);
         void wipe_db(const bfs::path& data_dir, bool wipe_block_log);
         void replay_db(const bfs::path& data_dir, bool force_replay);
+        void load_snapshot(const bfs::path& data_dir);
 
         void on_block (const protocol::signed_block& b);
     };
 
 
     void plugin::impl::on_block(const protocol::signed_block& b) {
-        auto n = b.block_num();
-        bool del_any = n < clear_votes_before_block;
-        const auto now = db.head_block_time();    // don't make one constant from now and ttl because of overflow
-        const auto ttl = uint64_t(clear_votes_older_n_blocks) * STEEMIT_BLOCK_INTERVAL;
-
-        const auto& idx = db.get_index<golos::chain::comment_vote_index>().indices().get<golos::chain::by_vote_last_update>();
-        auto itr = idx.begin();
-        while (itr != idx.end() && itr->num_changes < 0 && (del_any || now - itr->last_update > fc::seconds(ttl))) {
-            const auto& vote = *itr;
-            ++itr;
-            db.remove(vote);
+        vote_gc_options opts;
+        opts.remove_any = b.block_num() < clear_votes_before_block;
+        if (!opts.remove_any && clear_votes_older_n_blocks == 0xFFFFFFFF) {
+            return;
+        }
+        if (clear_votes_older_n_blocks != 0xFFFFFFFF) {
+            opts.ttl = fc::seconds(int64_t(clear_votes_older_n_blocks) * STEEMIT_BLOCK_INTERVAL);
+        }
+        opts.max_votes = clear_votes_per_block;
+        opts.max_time = fc::microseconds(clear_votes_time_per_block);
+
+        const auto* gc = db.find<vote_gc_object>();
+        if (gc == nullptr) {
+            gc = &db.create<vote_gc_object>([&](vote_gc_object&) {});
+        }
+
+        auto result = remove_old_votes(db, gc->cursor, opts);
+        if (result.cursor != gc->cursor || result.removed) {
+            db.modify(*gc, [&](vote_gc_object& o) {
+                o.cursor = result.cursor;
+                o.removed_votes += result.removed;
+            });
         }
     }
 
@@ -160,6 +196,21 @@ namespace golos { namespace plugins { namespace chain {
         db.reindex(data_dir, shared_memory_dir, from_block_num, shared_memory_size);
     };
 
+    void plugin::impl::load_snapshot(const bfs::path& data_dir) {
+        ilog("Loading state snapshot from ${path}.", ("path", load_snapshot_dir.generic_string()));
+
+        db.wipe(data_dir, shared_memory_dir, false);
+        db.open_from_snapshot(data_dir, shared_memory_dir, load_snapshot_dir, shared_memory_size, chainbase::database::read_write);
+
+        auto head_block_log = db.get_block_log().head();
+        if (head_block_log && head_block_log->block_num() > db.head_block_num()) {
+            auto from_block_num = db.head_block_num() + 1;
+
+            ilog("Replaying blockchain from block num ${from}.", ("from", from_block_num));
+            db.reindex(data_dir, shared_memory_dir, from_block_num, shared_memory_size);
+        }
+    };
+
     void plugin::impl::accept_transaction(const protocol::signed_transaction& trx) {
         uint32_t skip = db.validate_transaction(trx, db.skip_apply_transaction);
 
@@ -212,12 +263,54 @@ namespace golos { namespace plugins { namespace chain {
             ) (
                 "block-num-check-free-size", bpo::value<uint32_t>()->default_value(1000),
                 "Check free space in shared memory each N blocks. Default: 1000 (each 3000 seconds)."
+            ) (
+                "shared-file-growth-horizon", bpo::value<uint32_t>()->default_value(20000),
+                "Keep free space in shared memory for N blocks at the observed growth rate, "
+                "the file is increased at least by this amount. 0 = use only min-free-shared-file-size. Default: 20000"
+            ) (
+                "preallocate-shared-file", bpo::value<bool>()->default_value(true),
+                "Allocate disk space for the next increase of shared memory file in background. Default: true"
+            ) (
+                "shared-file-hugepages", bpo::value<std::string>()->default_value("none"),
+                "Huge pages for shared memory file: none, transparent (madvise, for shared-file-dir on tmpfs) "
+                "or hugetlbfs (shared-file-dir is on a hugetlbfs mount). Default: none"
+            ) (
+                "shared-file-numa-policy", bpo::value<std::string>()->default_value("none"),
+                "NUMA placement of shared memory file: none, interleave[:nodes] or bind:nodes, "
+                "where nodes is a comma separated list. Default: none"
             ) (
                 "checkpoint", bpo::value<std::vector<std::string>>()->composing(),
                 "Pairs of [BLOCK_NUM,BLOCK_ID] that should be enforced as checkpoints."
+            ) (
+                "checkpoint-trusted-sync", bpo::value<bool>()->default_value(false),
+                "Below the last checkpoint, make blocks irreversible when the chain reaches a checkpoint instead of "
+                "by witness confirmations, they are committed and written to the block log up to each matched "
+                "checkpoint at once. Undo history is kept between checkpoints. Default: false"
+            ) (
+                "undo-profiling", bpo::value<bool>()->default_value(false),
+                "Count objects created, modified and removed by each operation type, "
+                "the statistics is returned by get_database_info. Default: false"
+            ) (
+                "block-profiler", bpo::value<bool>()->default_value(false),
+                "Time stages of block application, evaluators and plugin signals, "
+                "the statistics is returned by get_database_info. Default: false"
+            ) (
+                "block-profiler-window", bpo::value<uint32_t>()->default_value(1200),
+                "Number of blocks in a generation of the block profiler histograms. Default: 1200"
+            ) (
+                "slow-block-time", bpo::value<uint32_t>()->default_value(500),
+                "Blocks applied longer than this number of milliseconds are logged with their stages. Default: 500"
+            ) (
+                "operation-cost-accounting", bpo::value<bool>()->default_value(false),
+                "Account time and calls of evaluators and plugin handlers per operation type, "
+                "the statistics is returned by get_operation_costs. Default: false"
             ) (
                 "flush-state-interval", bpo::value<uint32_t>(),
                 "flush shared memory changes to disk every N blocks"
+            ) (
+                "flush-state-rate", bpo::value<std::string>()->default_value("256M"),
+                "rate per second of the background pass syncing shared memory between the flushes, "
+                "the flush waits for a full pass. 0 = synchronous flushes only"
             ) (
                 "read-wait-micro", bpo::value<uint64_t>(),
                 "maximum microseconds for trying to get read lock"
@@ -241,9 +334,34 @@ namespace golos { namespace plugins { namespace chain {
                 "if set, remove votes older than specified number of blocks. "
                 "-1 = do not remove; 0 = remove after cashout; any other value N - remove votes older than N blocks. "
                 "note: votes don't removed before post cashout"
+            ) (
+                "clear-votes-per-block", bpo::value<uint32_t>()->default_value(1000),
+                "maximum number of votes checked for removal in a block, the rest is checked in the next blocks. "
+                "0 = unlimited. Default: 1000"
+            ) (
+                "clear-votes-time-per-block", bpo::value<uint32_t>()->default_value(2000),
+                "maximum microseconds of vote removal in a block, 0 = unlimited. Default: 2000"
             ) (
                 "skip-virtual-ops", bpo::value<bool>()->default_value(false),
                 "virtual operations will not be passed to the plugins, helps to save some memory"
+            ) (
+                "comment-cashout-threads", bpo::value<uint32_t>()->default_value(0),
+                "Number of threads computing curation rewards of comments paid out in a block, "
+                "0 means the number of cores, 1 pays out comments one by one. The threads are taken from a pool "
+                "shared with other parallel stages of blocks. Default: 0"
+            ) (
+                "maintenance-scheduler", bpo::value<bool>()->default_value(true),
+                "Skip per-block maintenance tasks (expired orders, conversions, savings withdraws...), "
+                "which have no objects with due deadlines. Default: true"
+            ) (
+                "transaction-check-threads", bpo::value<uint32_t>()->default_value(1),
+                "Experimental: number of threads checking signatures and authorities of block transactions "
+                "before they are applied, 0 means the number of cores, 1 checks them one by one. The threads are taken "
+                "from a pool shared with other parallel stages of blocks, operations are still applied one by one. Default: 1"
+            ) (
+                "state-digest", bpo::value<bool>()->default_value(false),
+                "Keep digests of the state indexes updated after each block to compare the state with other nodes "
+                "by get_state_digest, it slows down the processing of blocks. Default: false"
             ) (
                 "enable-plugins-on-push-transaction", bpo::value<bool>()->default_value(true),
                 "enable calling of plugins for operations on push_transaction"
@@ -259,6 +377,9 @@ namespace golos { namespace plugins { namespace chain {
             ) (
                 "store-memo-in-savings-withdraws", bpo::value<bool>()->default_value(true),
                 "store memo for all savings withdraws"
+            ) (
+                "snapshot-write-threads", bpo::value<uint32_t>()->default_value(0),
+                "number of threads writing indexes of a state snapshot, 0 = number of cores"
             );
         //  Do not use bool_switch() in cfg!
         cli.add_options()
@@ -271,21 +392,34 @@ namespace golos { namespace plugins { namespace chain {
             ) (
                 "resync-blockchain", bpo::bool_switch()->default_value(false),
                 "clear chain database and block log"
+            ) (
+                "replay-plugins", bpo::value<std::vector<std::string>>()->composing()->multitoken(),
+                "rebuild indexes of the plugins one by one from stored operations without replaying the blockchain "
+                "state, e.g. account_history, requires operation_history without history-whitelist-ops, "
+                "history-blacklist-ops, history-start-block and history-blocks"
             ) (
                 "check-locks", bpo::bool_switch()->default_value(false),
                 "Check correctness of chainbase locking"
             ) (
                 "validate-database-invariants", bpo::bool_switch()->default_value(false),
                 "Validate all supply invariants check out"
+            ) (
+                "create-snapshot", bpo::value<bfs::path>(),
+                "write a state snapshot to the directory after the database is opened"
+            ) (
+                "load-snapshot", bpo::value<bfs::path>(),
+                "clear chain database and load its state from the snapshot directory instead of replaying"
             );
     }
 
     void plugin::plugin_initialize(const bpo::variables_map& options) {
         my.reset(new impl());
 
-        my->db.applied_block.connect([&](const protocol::signed_block& b) {
+        golos::chain::add_plugin_index<vote_gc_index>(my->db);
+
+        my->db.applied_block.connect(my->db.with_applied_block_profile(name(), [&](const protocol::signed_block& b) {
             my->on_block(b);
-        });
+        }));
 
         auto sfd = options.at("shared-file-dir").as<bfs::path>();
         if (sfd.is_relative()) {
@@ -319,23 +453,53 @@ namespace golos { namespace plugins { namespace chain {
         my->min_free_shared_memory_size = fc::parse_size(options.at("min-free-shared-file-size").as<std::string>());
         my->clear_votes_before_block = options.at("clear-votes-before-block").as<uint32_t>();
         my->clear_votes_older_n_blocks = options.at("clear-votes-older-n-blocks").as<uint32_t>();
+        my->clear_votes_per_block = options.at("clear-votes-per-block").as<uint32_t>();
+        my->clear_votes_time_per_block = options.at("clear-votes-time-per-block").as<uint32_t>();
         my->skip_virtual_ops = options.at("skip-virtual-ops").as<bool>();
+        my->comment_cashout_threads = options.at("comment-cashout-threads").as<uint32_t>();
+        my->maintenance_scheduler = options.at("maintenance-scheduler").as<bool>();
+        my->transaction_check_threads = options.at("transaction-check-threads").as<uint32_t>();
+        my->state_digest = options.at("state-digest").as<bool>();
 
         if (options.count("block-num-check-free-size")) {
             my->block_num_check_free_size = options.at("block-num-check-free-size").as<uint32_t>();
         }
+        my->shared_memory_growth_horizon = options.at("shared-file-growth-horizon").as<uint32_t>();
+        my->preallocate_shared_memory = options.at("preallocate-shared-file").as<bool>();
+        my->shared_memory_policy.hugepages = golos::chain::shared_memory_policy::parse_hugepages(
+            options.at("shared-file-hugepages").as<std::string>());
+        my->shared_memory_policy.parse_numa(options.at("shared-file-numa-policy").as<std::string>());
 
         my->replay = options.at("replay-blockchain").as<bool>();
         my->replay_if_corrupted = options.at("replay-if-corrupted").as<bool>();
         my->force_replay = options.at("force-replay-blockchain").as<bool>();
         my->resync = options.at("resync-blockchain").as<bool>();
+        if (options.count("replay-plugins")) {
+            for (const auto& item : options.at("replay-plugins").as<std::vector<std::string>>()) {
+                std::vector<std::string> names;
+                boost::split(names, item, boost::is_any_of(" \t,"));
+                for (const auto& name : names) {
+                    if (!name.empty()) {
+                        my->replay_plugins.push_back(name);
+                    }
+                }
+            }
+        }
         my->check_locks = options.at("check-locks").as<bool>();
         my->validate_invariants = options.at("validate-database-invariants").as<bool>();
+        if (options.count("load-snapshot")) {
+            my->load_snapshot_dir = options.at("load-snapshot").as<bfs::path>();
+        }
+        if (options.count("create-snapshot")) {
+            my->create_snapshot_dir = options.at("create-snapshot").as<bfs::path>();
+        }
+        my->snapshot_write_threads = options.at("snapshot-write-threads").as<uint32_t>();
         if (options.count("flush-state-interval")) {
             my->flush_interval = options.at("flush-state-interval").as<uint32_t>();
         } else {
             my->flush_interval = 10000;
         }
+        my->flush_state_rate = fc::parse_size(options.at("flush-state-rate").as<std::string>());
 
         if (options.count("checkpoint")) {
             auto cps = options.at("checkpoint").as<std::vector<std::string>>();
@@ -345,6 +509,12 @@ namespace golos { namespace plugins { namespace chain {
                 my->loaded_checkpoints[item.first] = item.second;
             }
         }
+        my->checkpoint_trusted_sync = options.at("checkpoint-trusted-sync").as<bool>();
+        my->undo_profiling = options.at("undo-profiling").as<bool>();
+        my->block_profiler = options.at("block-profiler").as<bool>();
+        my->block_profiler_window = options.at("block-profiler-window").as<uint32_t>();
+        my->slow_block_time = options.at("slow-block-time").as<uint32_t>();
+        my->operation_cost_accounting = options.at("operation-cost-accounting").as<bool>();
 
         my->store_account_metadata = golos::chain::database::store_metadata_for_all;
 
@@ -379,7 +549,14 @@ namespace golos { namespace plugins { namespace chain {
         }
 
         my->db.set_flush_interval(my->flush_interval);
+        my->db.set_flush_state_rate(my->flush_state_rate);
         my->db.add_checkpoints(my->loaded_checkpoints);
+        my->db.set_checkpoint_trusted_sync(my->checkpoint_trusted_sync);
+        my->db.set_undo_profiling(my->undo_profiling);
+        if (my->block_profiler) {
+            my->db.get_block_profiler().enable(my->block_profiler_window, fc::milliseconds(my->slow_block_time));
+        }
+        my->db.set_operation_cost_accounting(my->operation_cost_accounting);
         my->db.set_require_locking(my->check_locks);
 
         my->db.set_read_wait_micro(my->read_wait_micro);
@@ -389,6 +566,9 @@ namespace golos { namespace plugins { namespace chain {
 
         my->db.set_inc_shared_memory_size(my->inc_shared_memory_size);
         my->db.set_min_free_shared_memory_size(my->min_free_shared_memory_size);
+        my->db.set_shared_memory_growth_horizon(my->shared_memory_growth_horizon);
+        my->db.set_shared_memory_preallocation(my->preallocate_shared_memory);
+        my->db.set_shared_memory_policy(my->shared_memory_policy);
 
 
         my->db.set_store_account_metadata(my->store_account_metadata);
@@ -397,6 +577,10 @@ namespace golos { namespace plugins { namespace chain {
 
         my->db.set_store_memo_in_savings_withdraws(my->store_memo_in_savings_withdraws);
 
+        my->db.set_comment_cashout_threads(my->comment_cashout_threads);
+        my->db.set_maintenance_scheduler(my->maintenance_scheduler);
+        my->db.set_transaction_check_threads(my->transaction_check_threads);
+        my->db.set_state_digest(my->state_digest);
         if (my->skip_virtual_ops) {
             my->db.set_skip_virtual_ops();
         }
@@ -407,47 +591,59 @@ namespace golos { namespace plugins { namespace chain {
 
         my->db.enable_plugins_on_push_transaction(my->enable_plugins_on_push_transaction);
 
-        try {
-            ilog("Opening shared memory from ${path}", ("path", my->shared_memory_dir.generic_string()));
-            my->db.open(data_dir, my->shared_memory_dir, STEEMIT_INIT_SUPPLY, my->shared_memory_size, chainbase::database::read_write/*, my->validate_invariants*/);
-            auto head_block_log = my->db.get_block_log().head();
-            my->replay |= head_block_log && my->db.revision() != head_block_log->block_num();
+        if (!my->load_snapshot_dir.empty()) {
+            my->load_snapshot(data_dir);
+        } else {
+            try {
+                ilog("Opening shared memory from ${path}", ("path", my->shared_memory_dir.generic_string()));
+                my->db.open(data_dir, my->shared_memory_dir, STEEMIT_INIT_SUPPLY, my->shared_memory_size, chainbase::database::read_write/*, my->validate_invariants*/);
+                auto head_block_log = my->db.get_block_log().head();
+                my->replay |= head_block_log && my->db.revision() != head_block_log->block_num();
 
-            if (my->replay) {
-                my->replay_db(data_dir, my->force_replay);
-            }
-        } catch (const golos::chain::database_revision_exception&) {
-            if (my->replay_if_corrupted) {
-                wlog("Error opening database, attempting to replay blockchain.");
-                my->force_replay |= my->db.revision() >= my->db.head_block_num();
-                try {
+                if (my->replay) {
                     my->replay_db(data_dir, my->force_replay);
-                } catch (const golos::chain::block_log_exception&) {
-                    wlog("Error opening block log. Having to resync from network...");
-                    my->wipe_db(data_dir, true);
                 }
-            } else {
-                wlog("Error opening database, quiting. If should replay, set replay-if-corrupted in config.ini to true.");
-                std::exit(0); // TODO Migrate to appbase::app().quit()
-                return;
-            }
-        } catch (...) {
-            if (my->replay_if_corrupted) {
-                wlog("Error opening database, attempting to replay blockchain.");
-                try {
-                    my->replay_db(data_dir, true);
-                } catch (const golos::chain::block_log_exception&) {
-                    wlog("Error opening block log. Having to resync from network...");
-                    my->wipe_db(data_dir, true);
+            } catch (const golos::chain::database_revision_exception&) {
+                if (my->replay_if_corrupted) {
+                    wlog("Error opening database, attempting to replay blockchain.");
+                    my->force_replay |= my->db.revision() >= my->db.head_block_num();
+                    try {
+                        my->replay_db(data_dir, my->force_replay);
+                    } catch (const golos::chain::block_log_exception&) {
+                        wlog("Error opening block log. Having to resync from network...");
+                        my->wipe_db(data_dir, true);
+                    }
+                } else {
+                    wlog("Error opening database, quiting. If should replay, set replay-if-corrupted in config.ini to true.");
+                    std::exit(0); // TODO Migrate to appbase::app().quit()
+                    return;
+                }
+            } catch (...) {
+                if (my->replay_if_corrupted) {
+                    wlog("Error opening database, attempting to replay blockchain.");
+                    try {
+                        my->replay_db(data_dir, true);
+                    } catch (const golos::chain::block_log_exception&) {
+                        wlog("Error opening block log. Having to resync from network...");
+                        my->wipe_db(data_dir, true);
+                    }
+                } else {
+                    wlog("Error opening database, quiting. If should replay, set replay-if-corrupted in config.ini to true.");
+                    std::exit(0); // TODO Migrate to appbase::app().quit()
+                    return;
                 }
-            } else {
-                wlog("Error opening database, quiting. If should replay, set replay-if-corrupted in config.ini to true.");
-                std::exit(0); // TODO Migrate to appbase::app().quit()
-                return;
             }
         }
 
+        if (!my->replay_plugins.empty() && !my->replay) {
+            my->db.reindex_plugins(my->replay_plugins);
+        }
+
         ilog("Started on blockchain with ${n} blocks", ("n", my->db.head_block_num()));
+
+        if (!my->create_snapshot_dir.empty()) {
+            my->db.write_snapshot(my->create_snapshot_dir, my->snapshot_write_threads);
+        }
         on_sync();
     }
 
@@ -0,0 +1,52 @@
+#include <golos/plugins/chain/vote_gc.hpp>
+
+namespace golos { namespace plugins { namespace chain {
+
+    using golos::chain::comment_vote_index;
+    using golos::chain::by_vote_last_update;
+
+    // a vote can't be younger than the comment, so after this time its comment has passed all payouts
+    static const fc::microseconds payout_horizon = fc::seconds(std::max<int64_t>(
+        STEEMIT_CASHOUT_WINDOW_SECONDS, STEEMIT_MAX_CASHOUT_WINDOW_SECONDS + STEEMIT_SECOND_CASHOUT_WINDOW));
+
+    vote_gc_result remove_old_votes(golos::chain::database &db, time_point_sec cursor, const vote_gc_options &opts) {
+        vote_gc_result result;
+        const auto now = db.head_block_time();
+        const auto start = fc::time_point::now();
+
+        const auto &idx = db.get_index<comment_vote_index, by_vote_last_update>();
+        auto itr = idx.lower_bound(cursor);
+        while (itr != idx.end()) {
+            if (opts.max_votes && result.checked >= opts.max_votes) {
+                break;
+            }
+            // now() isn't cheap, so the time is checked for every 64 votes
+            if (opts.max_time.count() && result.checked && result.checked % 64 == 0 &&
+                fc::time_point::now() - start >= opts.max_time
+            ) {
+                break;
+            }
+
+            const auto &vote = *itr;
+            auto age = now - vote.last_update;
+            if (vote.num_changes < 0) {
+                if (!opts.remove_any && age <= opts.ttl) {
+                    break;
+                }
+            } else if (age <= payout_horizon) {
+                break;
+            }
+
+            ++itr;
+            ++result.checked;
+            if (vote.num_changes < 0) {
+                db.remove(vote);
+                ++result.removed;
+            }
+        }
+
+        result.cursor = itr != idx.end() ? itr->last_update : now;
+        return result;
+    }
+
+} } } // golos::plugins::chain
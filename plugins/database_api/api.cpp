@@ -5,6 +5,7 @@
 #include <golos/protocol/get_config.hpp>
 #include <golos/protocol/exceptions.hpp>
 #include <golos/chain/operation_notification.hpp>
+#include <golos/chain/read_view.hpp>
 #include <golos/api/block_objects.hpp>
 
 #include <fc/smart_ref_impl.hpp>
@@ -67,6 +68,18 @@ enum block_applied_callback_result_type {
     full        = 3         // send signed block + virtual operations
 };
 
+/**
+ * Global objects copied after each block, they are read by the most frequent API calls.
+ * Accounts, comments, history and get_database_info still take the read lock and can delay blocks,
+ * copying such indexes after each block would cost more than the lock.
+ */
+struct globals_view {
+    dynamic_global_property_api_object properties;
+    chain_api_properties chain_properties;
+    hardfork_version current_hardfork;
+    scheduled_hardfork next_hardfork;
+};
+
 
 struct plugin::api_impl final {
 public:
@@ -74,8 +87,19 @@ public:
     ~api_impl();
 
     void startup() {
+        if (use_read_view) {
+            database().with_weak_read_lock([&]() {
+                publish_globals();
+            });
+        }
     }
 
+    uint64_t database_info_sample_size = 100;
+
+    bool use_read_view = true;
+    golos::chain::read_view<globals_view> globals;
+    void publish_globals();
+
     // Subscriptions
     void set_block_applied_callback(block_applied_callback cb);
     void set_pending_tx_callback(pending_tx_callback cb);
@@ -292,17 +316,32 @@ void plugin::api_impl::op_applied_callback(const operation_notification& o) {
 
 DEFINE_API(plugin, get_config) {
     PLUGIN_API_VALIDATE_ARGS();
-    return my->database().with_weak_read_lock([&]() {
-        return my->get_config();
-    });
+    // the config is constant, so it doesn't need the database lock
+    return my->get_config();
 }
 
 fc::variant_object plugin::api_impl::get_config() const {
     return golos::protocol::get_config();
 }
 
+void plugin::api_impl::publish_globals() {
+    const auto& db = database();
+    const auto& hpo = db.get(hardfork_property_object::id_type());
+
+    globals_view view;
+    view.properties = get_dynamic_global_properties();
+    view.chain_properties = chain_api_properties(db.get_witness_schedule_object().median_props, db);
+    view.current_hardfork = hpo.current_hardfork_version;
+    view.next_hardfork.hf_version = hpo.next_hardfork;
+    view.next_hardfork.live_time = hpo.next_hardfork_time;
+    globals.publish(std::move(view));
+}
+
 DEFINE_API(plugin, get_dynamic_global_properties) {
     PLUGIN_API_VALIDATE_ARGS();
+    if (auto view = my->globals.get()) {
+        return view->properties;
+    }
     return my->database().with_weak_read_lock([&]() {
         return my->get_dynamic_global_properties();
     });
@@ -310,6 +349,9 @@ DEFINE_API(plugin, get_dynamic_global_properties) {
 
 DEFINE_API(plugin, get_chain_properties) {
     PLUGIN_API_VALIDATE_ARGS();
+    if (auto view = my->globals.get()) {
+        return view->chain_properties;
+    }
     return my->database().with_weak_read_lock([&]() {
         return chain_api_properties(my->database().get_witness_schedule_object().median_props, my->database());
     });
@@ -321,6 +363,9 @@ dynamic_global_property_api_object plugin::api_impl::get_dynamic_global_properti
 
 DEFINE_API(plugin, get_hardfork_version) {
     PLUGIN_API_VALIDATE_ARGS();
+    if (auto view = my->globals.get()) {
+        return view->current_hardfork;
+    }
     return my->database().with_weak_read_lock([&]() {
         return my->database().get(hardfork_property_object::id_type()).current_hardfork_version;
     });
@@ -328,6 +373,9 @@ DEFINE_API(plugin, get_hardfork_version) {
 
 DEFINE_API(plugin, get_next_scheduled_hardfork) {
     PLUGIN_API_VALIDATE_ARGS();
+    if (auto view = my->globals.get()) {
+        return view->next_hardfork;
+    }
     return my->database().with_weak_read_lock([&]() {
         scheduled_hardfork shf;
         const auto &hpo = my->database().get(hardfork_property_object::id_type());
@@ -810,23 +858,48 @@ DEFINE_API(plugin, get_expiring_vesting_delegations) {
 
 DEFINE_API(plugin, get_database_info) {
     PLUGIN_API_VALIDATE_ARGS();
-    // read lock doesn't seem needed...
-
-    database_info info;
     auto& db = my->database();
+    return db.with_weak_read_lock([&]() {
+        database_info info;
 
-    info.free_size = db.free_memory();
-    info.total_size = db.max_memory();
-    info.reserved_size = db.reserved_memory();
-    info.used_size = info.total_size - info.free_size - info.reserved_size;
+        info.free_size = db.free_memory();
+        info.total_size = db.max_memory();
+        info.reserved_size = db.reserved_memory();
+        info.used_size = info.total_size - info.free_size - info.reserved_size;
 
-    info.index_list.reserve(db.index_list_size());
+        info.index_list.reserve(db.index_list_size());
 
-    for (auto it = db.index_list_begin(), et = db.index_list_end(); et != it; ++it) {
-        info.index_list.push_back({(*it)->name(), (*it)->size()});
-    }
+        for (auto it = db.index_list_begin(), et = db.index_list_end(); et != it; ++it) {
+            info.index_list.push_back({(*it)->name(), (*it)->size()});
+        }
+
+        info.index_memory = db.get_index_memory_statistics(my->database_info_sample_size);
+        info.resize_statistics = db.get_shared_memory_resize_statistics();
+        info.undo_statistics = db.get_undo_statistics();
+        info.block_stages = db.get_block_profiler().get_statistics();
+        info.slow_blocks = db.get_block_profiler().get_slow_blocks();
+        info.maintenance_tasks = db.get_maintenance_statistics();
+        info.authority_cache = db.get_authority_cache_statistics();
+        info.transaction_checks = db.get_transaction_check_statistics();
 
-    return info;
+        return info;
+    });
+}
+
+DEFINE_API(plugin, get_operation_costs) {
+    PLUGIN_API_VALIDATE_ARGS();
+    return my->database().with_weak_read_lock([&]() {
+        return my->database().get_operation_cost_statistics();
+    });
+}
+
+DEFINE_API(plugin, get_state_digest) {
+    PLUGIN_API_VALIDATE_ARGS(
+        (uint32_t, block_num, 0)
+    );
+    return my->database().with_weak_read_lock([&]() {
+        return my->database().get_state_digest(block_num);
+    });
 }
 
 std::vector<proposal_api_object> plugin::api_impl::get_proposed_transactions(
@@ -882,20 +955,50 @@ DEFINE_API(plugin, get_proposed_transactions) {
     });
 }
 
+void plugin::set_program_options(
+    boost::program_options::options_description& cli,
+    boost::program_options::options_description& cfg
+) {
+    cfg.add_options()
+        (
+            "database-info-sample-size", boost::program_options::value<uint64_t>()->default_value(100),
+            "number of objects per index scanned by get_database_info to estimate their dynamic memory, 0 = all objects. "
+            "The scan holds the read lock of the database, so large values delay blocks. Default: 100"
+        )
+        (
+            "api-read-view", boost::program_options::value<bool>()->default_value(true),
+            "serve get_dynamic_global_properties, get_chain_properties, get_hardfork_version and "
+            "get_next_scheduled_hardfork from a copy taken after each block without locking the database, "
+            "other calls still take the read lock. Default: true"
+        );
+}
+
 void plugin::plugin_initialize(const boost::program_options::variables_map& options) {
     ilog("database_api plugin: plugin_initialize() begin");
     my = std::make_unique<api_impl>();
+    my->database_info_sample_size = options.at("database-info-sample-size").as<uint64_t>();
+    my->use_read_view = options.at("api-read-view").as<bool>();
     JSON_RPC_REGISTER_API(plugin_name)
     auto& db = my->database();
-    db.applied_block.connect([&](const signed_block&) {
+    db.applied_block.connect(db.with_applied_block_profile(name(), [&](const signed_block&) {
         my->clear_outdated_callbacks(true);
+        // the write lock is held, so the copy is consistent with the applied block
+        if (my->use_read_view) {
+            my->publish_globals();
+        }
+    }));
+    db.popped_block.connect([&](const signed_block&) {
+        // the view would show the popped block until the next one is applied
+        if (my->use_read_view) {
+            my->publish_globals();
+        }
     });
     db.on_pending_transaction.connect([&](const signed_transaction& tx) {
         my->clear_outdated_callbacks(false);
     });
-    db.pre_apply_operation.connect([&](const operation_notification& o) {
+    db.pre_apply_operation.connect(db.with_operation_cost(name(), [&](const operation_notification& o) {
         my->op_applied_callback(o);
-    });
+    }));
     ilog("database_api plugin: plugin_initialize() end");
 }
 
@@ -15,6 +15,7 @@
 #include <golos/plugins/database_api/api_objects/savings_withdraw_api_object.hpp>
 #include <golos/plugins/database_api/api_objects/proposal_api_object.hpp>
 #include <golos/plugins/chain/plugin.hpp>
+#include <golos/chain/index_memory.hpp>
 
 #include <golos/api/chain_api_properties.hpp>
 
@@ -43,6 +44,18 @@ struct database_info {
     std::size_t used_size;
 
     std::vector<database_index_info> index_list;
+
+    /// estimated memory of each index, dynamic memory is extrapolated from database-info-sample-size objects
+    std::vector<golos::chain::index_memory_info> index_memory;
+    golos::chain::shared_memory_resize_statistics resize_statistics;
+    /// changes of objects per operation type, it's empty unless undo-profiling is enabled
+    std::vector<golos::chain::undo_operation_statistics> undo_statistics;
+    /// timing of block stages, evaluators and signals, it's empty unless block-profiler is enabled
+    std::vector<golos::chain::profiler_stage_statistics> block_stages;
+    std::vector<golos::chain::slow_block_report> slow_blocks;
+    std::vector<golos::chain::maintenance_task_statistics> maintenance_tasks;
+    golos::chain::authority_cache_statistics authority_cache;
+    golos::chain::transaction_check_statistics transaction_checks;
 };
 
 struct scheduled_hardfork {
@@ -127,6 +140,8 @@ DEFINE_API_ARGS(get_potential_signatures,         msg_pack, std::set<public_key_
 DEFINE_API_ARGS(verify_authority,                 msg_pack, bool)
 DEFINE_API_ARGS(verify_account_authority,         msg_pack, bool)
 DEFINE_API_ARGS(get_database_info,                msg_pack, database_info)
+DEFINE_API_ARGS(get_operation_costs,              msg_pack, std::vector<golos::chain::operation_cost_statistics>)
+DEFINE_API_ARGS(get_state_digest,                 msg_pack, golos::chain::state_digest_info)
 DEFINE_API_ARGS(get_proposed_transactions,        msg_pack, std::vector<proposal_api_object>)
 
 
@@ -151,7 +166,7 @@ public:
         (chain::plugin)
     )
 
-    void set_program_options(boost::program_options::options_description& cli, boost::program_options::options_description& cfg) override{}
+    void set_program_options(boost::program_options::options_description& cli, boost::program_options::options_description& cfg) override;
     void plugin_initialize(const boost::program_options::variables_map& options) override;
     void plugin_startup() override;
     void plugin_shutdown() override{}
@@ -317,6 +332,18 @@ public:
 
         (get_database_info)
 
+        /**
+        * @return time and calls of the evaluators and plugin handlers per operation type,
+        *   it's empty unless operation-cost-accounting is enabled
+        */
+        (get_operation_costs)
+
+        /**
+        * @return digests of the state indexes after one of the last blocks, 0 is the head block,
+        *   it requires state-digest enabled
+        */
+        (get_state_digest)
+
         (get_proposed_transactions)
     )
 
@@ -345,4 +372,4 @@ FC_REFLECT((golos::plugins::database_api::get_tags_used_by_author), (tags))
 FC_REFLECT((golos::plugins::database_api::signed_block_api_object), (block_id)(signing_key)(transaction_ids))
 
 FC_REFLECT((golos::plugins::database_api::database_index_info), (name)(record_count))
-FC_REFLECT((golos::plugins::database_api::database_info), (total_size)(free_size)(reserved_size)(used_size)(index_list))
+FC_REFLECT((golos::plugins::database_api::database_info), (total_size)(free_size)(reserved_size)(used_size)(index_list)(index_memory)(resize_statistics)(undo_statistics)(block_stages)(slow_blocks)(maintenance_tasks)(authority_cache)(transaction_checks))
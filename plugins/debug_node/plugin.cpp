@@ -130,9 +130,9 @@ void plugin::plugin_initialize( const boost::program_options::variables_map& opt
     }
 
     // connect needed signals
-    my->applied_block_connection = my->database().applied_block.connect( [this](const golos::chain::signed_block& b){
+    my->applied_block_connection = my->database().applied_block.connect( my->database().with_applied_block_profile(name(), [this](const golos::chain::signed_block& b){
         my->on_applied_block(b);
-    });
+    }));
 
     JSON_RPC_REGISTER_API ( name() );
 }
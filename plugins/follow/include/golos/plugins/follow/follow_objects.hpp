@@ -267,7 +267,8 @@ FC_REFLECT((golos::plugins::follow::feed_object),
            (id)(account)(first_reblogged_by)(first_reblogged_on)(reblogged_by)(comment)(reblogs)(account_feed_id))
 CHAINBASE_SET_INDEX_TYPE(golos::plugins::follow::feed_object, golos::plugins::follow::feed_index)
 
-FC_REFLECT((golos::plugins::follow::blog_object), (id)(account)(comment)(reblogged_on)(blog_feed_id))
+FC_REFLECT((golos::plugins::follow::blog_object),
+           (id)(account)(comment)(reblogged_on)(blog_feed_id)(reblog_title)(reblog_body)(reblog_json_metadata))
 CHAINBASE_SET_INDEX_TYPE(golos::plugins::follow::blog_object, golos::plugins::follow::blog_index)
 
 FC_REFLECT((golos::plugins::follow::reputation_object), (id)(account)(reputation))
@@ -127,8 +127,10 @@ namespace golos {
             struct post_operation_visitor {
                 plugin& _plugin;
                 database& db;
+                const operation_notification& note;
 
-                post_operation_visitor(plugin& plugin, database& db) : _plugin(plugin), db(db) {
+                post_operation_visitor(plugin& plugin, database& db, const operation_notification& note)
+                        : _plugin(plugin), db(db), note(note) {
                 }
 
                 typedef void result_type;
@@ -239,14 +241,18 @@ namespace golos {
 
                 void operator()(const vote_operation& op) const {
                     try {
-                        const auto& comment = db.get_comment(op.author, op.permlink);
+                        // the evaluator has found them, they are null only if the notification is made without it
+                        const auto& comment = note.comment ? *note.comment : db.get_comment(op.author, op.permlink);
 
                         if (db.calculate_discussion_payout_time(comment) == fc::time_point_sec::maximum()) {
                             return;
                         }
 
-                        const auto& cv_idx = db.get_index<comment_vote_index>().indices().get<by_comment_voter>();
-                        auto cv = cv_idx.find(boost::make_tuple(comment.id, db.get_account(op.voter).id));
+                        const comment_vote_object* cv = note.vote;
+                        if (cv == nullptr) {
+                            const auto& cv_idx = db.get_index<comment_vote_index>().indices().get<by_comment_voter>();
+                            cv = &*cv_idx.find(boost::make_tuple(comment.id, db.get_account(op.voter).id));
+                        }
 
                         const auto& rep_idx = db.get_index<reputation_index>().indices().get<by_account>();
                         auto voter_rep = rep_idx.find(op.voter);
@@ -338,7 +344,7 @@ namespace golos {
 
                 void post_operation(const operation_notification& op_obj, plugin& self) {
                     try {
-                        op_obj.op.visit(post_operation_visitor(self, database()));
+                        op_obj.op.visit(post_operation_visitor(self, database(), op_obj));
                     } catch (fc::assert_exception) {
                         if (database().is_producing()) {
                             throw;
@@ -417,12 +423,12 @@ namespace golos {
                     auto& db = pimpl->database();
                     pimpl->plugin_initialize(*this);
 
-                    db.pre_apply_operation.connect([&](operation_notification& o) {
+                    db.pre_apply_operation.connect(db.with_operation_cost(name(), [&](operation_notification& o) {
                         pimpl->pre_operation(o, *this);
-                    });
-                    db.post_apply_operation.connect([&](const operation_notification& o) {
+                    }));
+                    db.post_apply_operation.connect(db.with_operation_cost(name(), [&](const operation_notification& o) {
                         pimpl->post_operation(o, *this);
-                    });
+                    }));
                     golos::chain::add_plugin_index<follow_index>(db);
                     golos::chain::add_plugin_index<feed_index>(db);
                     golos::chain::add_plugin_index<blog_index>(db);
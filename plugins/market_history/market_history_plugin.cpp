@@ -398,7 +398,7 @@ namespace golos {
                     golos::chain::database& db = _my->database();
 
                     db.post_apply_operation.connect(
-                            [&](const golos::chain::operation_notification &o) { _my->update_market_histories(o); });
+                            db.with_operation_cost(name(), [&](const golos::chain::operation_notification &o) { _my->update_market_histories(o); }));
                     golos::chain::add_plugin_index<bucket_index>(db);
                     golos::chain::add_plugin_index<order_history_index>(db);
 
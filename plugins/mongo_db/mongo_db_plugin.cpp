@@ -109,13 +109,13 @@ namespace mongo_db {
                 // Set applied block listener
                 auto &db = pimpl_->database();
 
-                db.applied_block.connect([&](const signed_block &b) {
+                db.applied_block.connect(db.with_applied_block_profile(name(), [&](const signed_block &b) {
                     pimpl_->on_block(b);
-                });
+                }));
 
-                db.post_apply_operation.connect([&](const operation_notification &o) {
+                db.post_apply_operation.connect(db.with_operation_cost(name(), [&](const operation_notification &o) {
                     pimpl_->on_operation(o);
-                });
+                }));
 
             } else {
                 ilog("Mongo plugin configured, but no mongodb-uri specified. Plugin disabled.");
@@ -86,6 +86,9 @@ namespace golos { namespace plugins { namespace operation_history {
 
 } } } // golos::plugins::operation_history
 
+FC_REFLECT((golos::plugins::operation_history::operation_object),
+    (id)(trx_id)(block)(trx_in_block)(op_in_trx)(virtual_op)(timestamp)(serialized_op))
+
 CHAINBASE_SET_INDEX_TYPE(
     golos::plugins::operation_history::operation_object,
     golos::plugins::operation_history::operation_index)
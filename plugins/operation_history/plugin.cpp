@@ -242,9 +242,9 @@ namespace golos { namespace plugins { namespace operation_history {
 
         pimpl = std::make_unique<plugin_impl>();
 
-        pimpl->database.pre_apply_operation.connect([&](golos::chain::operation_notification& note){
+        pimpl->database.pre_apply_operation.connect(pimpl->database.with_operation_cost(name(), [&](golos::chain::operation_notification& note){
             pimpl->on_operation(note);
-        });
+        }));
 
         golos::chain::add_plugin_index<operation_index>(pimpl->database);
 
@@ -292,14 +292,38 @@ namespace golos { namespace plugins { namespace operation_history {
         if (options.count("history-blocks")) {
             uint32_t history_blocks = options.at("history-blocks").as<uint32_t>();
             pimpl->history_blocks = history_blocks;
-            pimpl->database.applied_block.connect([&](const signed_block& block){
+            pimpl->database.applied_block.connect(pimpl->database.with_applied_block_profile(name(), [&](const signed_block& block){
                 pimpl->erase_old_blocks();
-            });
+            }));
         } else {
             pimpl->history_blocks = UINT32_MAX;
         }
         ilog("operation_history: history-blocks ${s}", ("s", pimpl->history_blocks));
 
+        // other plugins can be rebuilt only from the complete stream of operations
+        if (!pimpl->filter_content && pimpl->history_blocks == UINT32_MAX) {
+            pimpl->database.set_operation_source([&](uint32_t from_block, const golos::chain::database::operation_filter& handler) {
+                const auto& idx = pimpl->database.get_index<operation_index>().indices().get<by_location>();
+                for (auto itr = idx.lower_bound(from_block); itr != idx.end(); ++itr) {
+                    const auto& obj = *itr;
+                    auto op = fc::raw::unpack<protocol::operation>(obj.serialized_op);
+                    golos::chain::operation_notification note(op);
+                    note.stored_in_db = true;
+                    note.db_id = obj.id._id;
+                    note.trx_id = obj.trx_id;
+                    note.block = obj.block;
+                    note.trx_in_block = obj.trx_in_block;
+                    note.op_in_trx = obj.op_in_trx;
+                    note.virtual_op = obj.virtual_op;
+                    if (!handler(note)) {
+                        break;
+                    }
+                }
+            });
+        } else {
+            ilog("operation_history: operations are filtered or trimmed, plugins can't be reindexed from them");
+        }
+
         JSON_RPC_REGISTER_API(name());
         ilog("operation_history plugin: plugin_initialize() end");
     }
@@ -0,0 +1,135 @@
+#include <golos/plugins/p2p/block_prevalidator.hpp>
+
+#include <golos/chain/shared_db_merkle.hpp>
+#include <golos/chain/witness_objects.hpp>
+
+namespace golos {
+    namespace plugins {
+        namespace p2p {
+
+            using golos::chain::database;
+            using golos::protocol::signed_block;
+            using golos::protocol::block_id_type;
+            using golos::protocol::account_name_type;
+            using golos::protocol::public_key_type;
+
+            struct block_prevalidator::head_state {
+                uint32_t head_block_num = 0;
+                block_id_type head_block_id;
+                fc::time_point_sec head_block_time;
+                uint32_t maximum_block_size = 0;
+                bool check_block_size = false;
+                uint64_t current_aslot = 0;
+                std::vector<account_name_type> shuffled_witnesses;
+                fc::flat_map<account_name_type, public_key_type> signing_keys;
+            };
+
+            block_prevalidator::block_prevalidator(database &db)
+                    : _db(db) {
+            }
+
+            block_prevalidator::~block_prevalidator() {
+            }
+
+            void block_prevalidator::update_head_state() {
+                auto head = std::make_shared<head_state>();
+
+                const auto &dgp = _db.get_dynamic_global_properties();
+                head->head_block_num = dgp.head_block_number;
+                head->head_block_id = dgp.head_block_id;
+                head->head_block_time = dgp.time;
+                head->maximum_block_size = dgp.maximum_block_size;
+                head->check_block_size = _db.has_hardfork(STEEMIT_HARDFORK_0_12);
+                head->current_aslot = dgp.current_aslot;
+
+                const auto &wso = _db.get_witness_schedule_object();
+                head->shuffled_witnesses.reserve(wso.num_scheduled_witnesses);
+                for (uint32_t i = 0; i < wso.num_scheduled_witnesses; ++i) {
+                    const auto &name = wso.current_shuffled_witnesses[i];
+                    head->shuffled_witnesses.push_back(name);
+                    const auto *witness = _db.find_witness(name);
+                    if (witness != nullptr) {
+                        head->signing_keys[name] = witness->signing_key;
+                    }
+                }
+
+                std::lock_guard<std::mutex> lock(_head_mutex);
+                _head = std::move(head);
+            }
+
+            std::shared_ptr<const block_prevalidator::head_state> block_prevalidator::get_head_state() const {
+                std::lock_guard<std::mutex> lock(_head_mutex);
+                return _head;
+            }
+
+            uint32_t block_prevalidator::validate(const signed_block &block) const {
+                uint32_t skip = database::skip_merkle_check;
+
+                check_merkle_root(block);
+
+                auto head = get_head_state();
+                // the snapshot only describes the state this block applies to if the block extends our head;
+                //   blocks on other forks are left for the database to check
+                if (head && head->head_block_num > 0 && block.previous == head->head_block_id) {
+                    if (head->check_block_size) {
+                        auto block_size = fc::raw::pack_size(block);
+                        FC_ASSERT(
+                            block_size <= head->maximum_block_size,
+                            "Block Size is too Big",
+                            ("next_block_num", block.block_num())
+                            ("block_size", block_size)
+                            ("max", head->maximum_block_size));
+                    }
+                    skip |= database::skip_block_size_check;
+
+                    check_witness(block, *head);
+                    // the signing key is taken from the state of the parent block, the database would check
+                    //   the signature against the same key
+                    skip |= database::skip_witness_signature;
+                }
+
+                return skip;
+            }
+
+            void block_prevalidator::check_merkle_root(const signed_block &block) const {
+                auto merkle_root = block.calculate_merkle_root();
+                if (block.transaction_merkle_root == merkle_root) {
+                    return;
+                }
+
+                const auto &merkle_map = golos::chain::get_shared_db_merkle();
+                auto itr = merkle_map.find(block.block_num());
+                FC_ASSERT(
+                    itr != merkle_map.end() && itr->second == merkle_root,
+                    "Merkle check failed",
+                    ("next_block.transaction_merkle_root", block.transaction_merkle_root)
+                    ("calc", merkle_root)
+                    ("id", block.id()));
+            }
+
+            void block_prevalidator::check_witness(const signed_block &block, const head_state &head) const {
+                FC_ASSERT(head.head_block_time < block.timestamp, "",
+                    ("head_block_time", head.head_block_time)("next", block.timestamp)("blocknum", block.block_num()));
+
+                // same as database::get_slot_at_time() and database::get_scheduled_witness()
+                int64_t head_block_abs_slot = head.head_block_time.sec_since_epoch() / STEEMIT_BLOCK_INTERVAL;
+                fc::time_point_sec first_slot_time(head_block_abs_slot * STEEMIT_BLOCK_INTERVAL + STEEMIT_BLOCK_INTERVAL);
+                FC_ASSERT(block.timestamp >= first_slot_time, "Block produced before the next slot",
+                    ("timestamp", block.timestamp)("first_slot_time", first_slot_time));
+                uint32_t slot_num = (block.timestamp - first_slot_time).to_seconds() / STEEMIT_BLOCK_INTERVAL + 1;
+
+                FC_ASSERT(!head.shuffled_witnesses.empty());
+                const auto &scheduled_witness =
+                    head.shuffled_witnesses[(head.current_aslot + slot_num) % head.shuffled_witnesses.size()];
+                FC_ASSERT(block.witness == scheduled_witness, "Witness produced block at wrong time",
+                    ("block witness", block.witness)("scheduled", scheduled_witness)("slot_num", slot_num));
+
+                auto key_itr = head.signing_keys.find(block.witness);
+                FC_ASSERT(key_itr != head.signing_keys.end(), "Unknown witness ${w}", ("w", block.witness));
+                FC_ASSERT(block.validate_signee(key_itr->second), "Block is not signed by the witness signing key",
+                    ("witness", block.witness)("signing_key", key_itr->second));
+            }
+
+        }
+    }
+} // golos::plugins::p2p
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <golos/chain/database.hpp>
+#include <golos/protocol/block.hpp>
+
+#include <memory>
+#include <mutex>
+
+namespace golos {
+    namespace plugins {
+        namespace p2p {
+
+            /**
+             *  Checks blocks received from the network before they are queued for the chain database:
+             *  the merkle root, the block size and the witness signature against the scheduled witness.
+             *  Signatures of transactions are left to the database, which checks them only when they aren't skipped.
+             *
+             *  The checks use a snapshot of the head state which is refreshed on each applied block,
+             *  so invalid blocks are rejected without taking any database lock.
+             */
+            class block_prevalidator final {
+            public:
+                block_prevalidator(golos::chain::database &db);
+
+                ~block_prevalidator();
+
+                /** Refreshes the head snapshot, must be called with the database locked */
+                void update_head_state();
+
+                /**
+                 *  Throws if the block is invalid.
+                 *  @return skip flags for the checks which shouldn't be repeated by the database
+                 */
+                uint32_t validate(const protocol::signed_block &block) const;
+
+            private:
+                struct head_state;
+
+                void check_merkle_root(const protocol::signed_block &block) const;
+
+                void check_witness(const protocol::signed_block &block, const head_state &head) const;
+
+                std::shared_ptr<const head_state> get_head_state() const;
+
+                golos::chain::database &_db;
+
+                mutable std::mutex _head_mutex;
+                std::shared_ptr<const head_state> _head;
+            };
+
+        }
+    }
+} // golos::plugins::p2p
@@ -1,4 +1,5 @@
 #include <golos/plugins/p2p/p2p_plugin.hpp>
+#include <golos/plugins/p2p/block_prevalidator.hpp>
 
 #include <golos/network/node.hpp>
 #include <golos/network/exceptions.hpp>
@@ -90,8 +91,10 @@ namespace golos {
                     uint32_t max_connections = 0;
                     bool force_validate = false;
                     bool block_producer = false;
+                    bool prevalidation = true;
 
                     std::unique_ptr<golos::network::node> node;
+                    std::unique_ptr<block_prevalidator> prevalidator;
 
                     chain::plugin &chain;
 
@@ -129,13 +132,21 @@ namespace golos {
                                                                                                              head_block_num));
 
                         try {
+                            uint32_t skip = (block_producer | force_validate)
+                                            ? database::skip_nothing
+                                            : database::skip_transaction_signatures;
+
+                            // sync blocks are checked by the database in order, but new blocks can come from anyone,
+                            //   so reject invalid ones before they are queued for the database lock
+                            if (!sync_mode && prevalidator) {
+                                skip |= prevalidator->validate(blk_msg.block);
+                            }
+
                             // TODO: in the case where this block is valid but on a fork that's too old for us to switch to,
                             // you can help the network code out by throwing a block_older_than_undo_history exception.
                             // when the network code sees that, it will stop trying to push blocks from that chain, but
                             // leave that peer connected so that they can get sync blocks from us
-                            bool result = chain.accept_block(blk_msg.block, sync_mode, (block_producer | force_validate)
-                                                                                       ? database::skip_nothing
-                                                                                       : database::skip_transaction_signatures);
+                            bool result = chain.accept_block(blk_msg.block, sync_mode, skip);
 
                             if (!sync_mode) {
                                 fc::microseconds latency = fc::time_point::now() - blk_msg.block.timestamp;
@@ -443,7 +454,10 @@ namespace golos {
                     ("seed-node", boost::program_options::value<vector<string>>()->composing(),
                         "The IP address and port of a remote peer to sync with. Deprecated in favor of p2p-seed-node.")
                     ("p2p-seed-node", boost::program_options::value<vector<string>>()->composing(),
-                        "The IP address and port of a remote peer to sync with.");
+                        "The IP address and port of a remote peer to sync with.")
+                    ("p2p-block-prevalidation", boost::program_options::value<bool>()->default_value(true),
+                        "Check the merkle root, size and witness signature of new blocks before they are pushed "
+                        "to the chain database.");
                 cli.add_options()
                     ("force-validate", boost::program_options::bool_switch()->default_value(false),
                         "Force validation of all transactions. Deprecated in favor of p2p-force-validate")
@@ -496,9 +510,24 @@ namespace golos {
                     wlog("Option force-validate is deprecated in favor of p2p-force-validate");
                     my->force_validate = true;
                 }
+
+                my->prevalidation = options.at("p2p-block-prevalidation").as<bool>();
+                if (my->prevalidation) {
+                    auto &db = my->chain.db();
+                    my->prevalidator.reset(new block_prevalidator(db));
+                    db.applied_block.connect(db.with_applied_block_profile(name(), [this](const signed_block &) {
+                        my->prevalidator->update_head_state();
+                    }));
+                }
             }
 
             void p2p_plugin::plugin_startup() {
+                if (my->prevalidator) {
+                    my->chain.db().with_weak_read_lock([&]() {
+                        my->prevalidator->update_head_state();
+                    });
+                }
+
                 my->p2p_thread.async([this] {
                     my->node.reset(new golos::network::node(my->user_agent));
                     my->node->load_configuration(app().data_dir() / "p2p");
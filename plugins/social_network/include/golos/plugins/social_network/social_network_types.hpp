@@ -134,6 +134,16 @@ namespace golos { namespace plugins { namespace social_network {
         allocator<comment_reward_object>>;
 } } }
 
+FC_REFLECT((golos::plugins::social_network::comment_content_object),
+    (id)(comment)(title)(body)(json_metadata)(block_number))
+
+FC_REFLECT((golos::plugins::social_network::comment_last_update_object),
+    (id)(comment)(parent_author)(author)(last_update)(active)(block_number))
+
+FC_REFLECT((golos::plugins::social_network::comment_reward_object),
+    (id)(comment)(total_payout_value)(author_rewards)(author_gbg_payout_value)(author_golos_payout_value)
+    (author_gests_payout_value)(beneficiary_payout_value)(beneficiary_gests_payout_value)
+    (curator_payout_value)(curator_gests_payout_value))
 
 CHAINBASE_SET_INDEX_TYPE(
     golos::plugins::social_network::comment_content_object,
@@ -596,17 +596,17 @@ namespace golos { namespace plugins { namespace social_network {
             add_plugin_index<comment_reward_index>(db);
         }
 
-        db.pre_apply_operation.connect([&](const operation_notification &o) {
+        db.pre_apply_operation.connect(db.with_operation_cost(name(), [&](const operation_notification &o) {
             pimpl->pre_operation(o);
-        });
+        }));
 
-        db.post_apply_operation.connect([&](const operation_notification &o) {
+        db.post_apply_operation.connect(db.with_operation_cost(name(), [&](const operation_notification &o) {
             pimpl->post_operation(o);
-        });
+        }));
 
-        db.applied_block.connect([&](const signed_block &b) {
+        db.applied_block.connect(db.with_applied_block_profile(name(), [&](const signed_block &b) {
             pimpl->on_block(b);
-        });
+        }));
 
         if (options.count("comment-title-depth")) {
             params.comment_title_depth = options.at("comment-title-depth").as<uint32_t>();
@@ -59,9 +59,10 @@ public:
 struct operation_process {
     database &_db;
     std::shared_ptr<statistics_sender> stat_sender;
+    const operation_notification &_note;
 
-    operation_process(database &db, std::shared_ptr<statistics_sender> stat_sender) :
-        _db(db), stat_sender(stat_sender) {
+    operation_process(database &db, std::shared_ptr<statistics_sender> stat_sender, const operation_notification &note) :
+        _db(db), stat_sender(stat_sender), _note(note) {
     }
 
     typedef void result_type;
@@ -119,10 +120,13 @@ struct operation_process {
     }
 
     void operator()(const vote_operation &op) const {
-        const auto &cv_idx = _db.get_index<comment_vote_index>().indices().get<by_comment_voter>();
-        auto &comment = _db.get_comment(op.author, op.permlink);
-        auto &voter = _db.get_account(op.voter);
-        auto itr = cv_idx.find(boost::make_tuple(comment.id, voter.id));
+        // the evaluator has found them, they are null only if the notification is made without it
+        auto &comment = _note.comment ? *_note.comment : _db.get_comment(op.author, op.permlink);
+        const comment_vote_object *itr = _note.vote;
+        if (itr == nullptr) {
+            const auto &cv_idx = _db.get_index<comment_vote_index>().indices().get<by_comment_voter>();
+            itr = &*cv_idx.find(boost::make_tuple(comment.id, _db.get_account(op.voter).id));
+        }
 
         if (itr->num_changes) {
             if (comment.parent_author.size()) {
@@ -278,7 +282,7 @@ void plugin::plugin_impl::post_operation(const operation_notification &o) {
         if (!is_virtual_operation(o.op)) {
             stat_sender->current_bucket.operations++;
         }
-        o.op.visit( operation_process( database(), stat_sender ) );
+        o.op.visit( operation_process( database(), stat_sender, o ) );
     } FC_CAPTURE_AND_RETHROW()
 }
 
@@ -308,17 +312,17 @@ void plugin::plugin_initialize(const boost::program_options::variables_map& opti
         uint32_t statsd_default_port = options["statsd-default-port"].as<uint32_t>();
         _my->stat_sender = std::shared_ptr<statistics_sender>(new statistics_sender(statsd_default_port) );
 
-        db.applied_block.connect([&](const signed_block &b) {
+        db.applied_block.connect(db.with_applied_block_profile(name(), [&](const signed_block &b) {
             _my->on_block(b);
-        });
+        }));
 
-        db.pre_apply_operation.connect([&](operation_notification &o) {
+        db.pre_apply_operation.connect(db.with_operation_cost(name(), [&](operation_notification &o) {
             _my->pre_operation(o);
-        });
+        }));
 
-        db.post_apply_operation.connect([&](const operation_notification &o) {
+        db.post_apply_operation.connect(db.with_operation_cost(name(), [&](const operation_notification &o) {
             _my->post_operation(o);
-        });
+        }));
 
         if (options.count("statsd-endpoints")) {
             for (auto it : options["statsd-endpoints"].as<std::vector<std::string>>()) {
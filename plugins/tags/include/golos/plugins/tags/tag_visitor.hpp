@@ -3,6 +3,7 @@
 #include "tags_object.hpp"
 #include <golos/chain/comment_object.hpp>
 #include <golos/chain/account_object.hpp>
+#include <golos/chain/operation_notification.hpp>
 #include <boost/algorithm/string.hpp>
 
 
@@ -14,12 +15,16 @@ namespace golos { namespace plugins { namespace tags {
     struct comment_date { time_point_sec active; time_point_sec last_update; };
 
     struct operation_visitor {
-        operation_visitor(database& db, std::size_t tags_number, std::size_t tag_max_length);
+        operation_visitor(
+            database& db, std::size_t tags_number, std::size_t tag_max_length,
+            const golos::chain::operation_notification* note = nullptr);
         using result_type = void;
 
         database& db_;
         std::size_t tags_number_;
         std::size_t tag_max_length_;
+        /// objects found by the evaluator
+        const golos::chain::operation_notification* note_;
 
         void remove_stats(const tag_object& tag) const;
 
@@ -63,6 +68,7 @@ namespace golos { namespace plugins { namespace tags {
         /** finds tags that have been added or removed or updated */
         void create_update_tags(const account_name_type& author, const std::string& permlink) const;
         void update_tags(const account_name_type& author, const std::string& permlink) const;
+        void update_tags(const comment_object& comment) const;
         void remove_tags(const account_name_type& author, const std::string& permlink) const;
 
         void operator()(const comment_operation& op) const;
@@ -35,7 +35,7 @@ namespace golos { namespace plugins { namespace tags {
         void on_operation(const operation_notification& note) {
             try {
                 /// plugins shouldn't ever throw
-                note.op.visit(tags::operation_visitor(database_, tags_number, tag_max_length));
+                note.op.visit(tags::operation_visitor(database_, tags_number, tag_max_length, &note));
             } catch (const fc::exception& e) {
                 edump((e.to_detail_string()));
             } catch (...) {
@@ -201,9 +201,9 @@ namespace golos { namespace plugins { namespace tags {
     void tags_plugin::plugin_initialize(const boost::program_options::variables_map& options) {
         pimpl = std::make_unique<impl>();
         auto& db = pimpl->database();
-        db.post_apply_operation.connect([&](const operation_notification& note) {
+        db.post_apply_operation.connect(db.with_operation_cost(name(), [&](const operation_notification& note) {
             pimpl->on_operation(note);
-        });
+        }));
         add_plugin_index<tags::tag_index>(db);
         add_plugin_index<tags::tag_stats_index>(db);
         add_plugin_index<tags::author_tag_stats_index>(db);
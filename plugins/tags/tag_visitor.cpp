@@ -54,10 +54,13 @@ namespace golos { namespace plugins { namespace tags {
         return get_metadata(golos::plugins::social_network::get_json_metadata(db, c), tags_number, tag_max_length);
     }
 
-    operation_visitor::operation_visitor(database& db, std::size_t tags_number, std::size_t tag_max_length)
-        : db_(db),
-          tags_number_(tags_number),
-          tag_max_length_(tag_max_length) {
+    operation_visitor::operation_visitor(
+        database& db, std::size_t tags_number, std::size_t tag_max_length,
+        const golos::chain::operation_notification* note
+    ) : db_(db),
+        tags_number_(tags_number),
+        tag_max_length_(tag_max_length),
+        note_(note) {
     }
 
     void operation_visitor::remove_stats(const tag_object& tag) const {
@@ -293,7 +296,10 @@ namespace golos { namespace plugins { namespace tags {
     } FC_CAPTURE_LOG_AND_RETHROW(()) }
 
     void operation_visitor::update_tags(const account_name_type& author, const std::string& permlink) const {
-        const auto& comment = db_.get_comment(author, permlink);
+        update_tags(db_.get_comment(author, permlink));
+    }
+
+    void operation_visitor::update_tags(const comment_object& comment) const {
         auto hot = calculate_hot(comment.net_rshares, comment.created);
         auto trending = calculate_trending(comment.net_rshares, comment.created);
         const auto& comment_idx = db_.get_index<tag_index>().indices().get<by_comment>();
@@ -417,7 +423,11 @@ namespace golos { namespace plugins { namespace tags {
 
     void operation_visitor::operator()(const vote_operation& op) const {
         // only update existing tags
-        update_tags(op.author, op.permlink);
+        if (note_ != nullptr && note_->comment != nullptr) {
+            update_tags(*note_->comment);
+        } else {
+            update_tags(op.author, op.permlink);
+        }
     }
 
     void operation_visitor::operator()(const comment_payout_update_operation& op) const {
@@ -0,0 +1,86 @@
+/**
+ *  Removes votes of paid out comments from the state of a stopped node at once, so the node doesn't have
+ *  to remove them block by block after clear-votes-older-n-blocks or clear-votes-before-block is enabled.
+ *  The node should be stopped, the shared memory file is opened for writing. Its size isn't reduced,
+ *  the freed memory is reused by new objects.
+ */
+#include <golos/chain/database.hpp>
+#include <golos/chain/index.hpp>
+#include <golos/plugins/chain/vote_gc.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <iostream>
+
+namespace bpo = boost::program_options;
+
+using namespace golos::chain;
+using golos::plugins::chain::vote_gc_object;
+using golos::plugins::chain::vote_gc_index;
+using golos::plugins::chain::vote_gc_options;
+using golos::plugins::chain::remove_old_votes;
+
+int main(int argc, char **argv) {
+    try {
+        bpo::options_description opts("Options");
+        opts.add_options()
+            ("help,h", "print this help message")
+            ("data-dir,d", bpo::value<std::string>()->default_value("blockchain"),
+                "directory with block_log")
+            ("shared-file-dir,s", bpo::value<std::string>(),
+                "directory with shared_memory.bin, the data directory by default")
+            ("clear-votes-older-n-blocks,n", bpo::value<uint32_t>()->default_value(0),
+                "remove votes of paid out comments older than specified number of blocks, 0 = remove all of them");
+
+        bpo::variables_map options;
+        bpo::store(bpo::parse_command_line(argc, argv, opts), options);
+
+        if (options.count("help")) {
+            std::cout << opts << std::endl;
+            return 0;
+        }
+
+        fc::path data_dir(options.at("data-dir").as<std::string>());
+        fc::path shared_file_dir = options.count("shared-file-dir")
+            ? fc::path(options.at("shared-file-dir").as<std::string>())
+            : data_dir;
+
+        vote_gc_options gc;
+        gc.ttl = fc::seconds(int64_t(options.at("clear-votes-older-n-blocks").as<uint32_t>()) * STEEMIT_BLOCK_INTERVAL);
+
+        database db;
+        add_plugin_index<vote_gc_index>(db);
+        db.open(data_dir, shared_file_dir, STEEMIT_INIT_SUPPLY, 0, chainbase::database::read_write);
+
+        db.with_strong_write_lock([&]() {
+            auto votes = db.get_index<comment_vote_index>().indices().size();
+            auto start = fc::time_point::now();
+            auto result = remove_old_votes(db, fc::time_point_sec::min(), gc);
+
+            // the node continues from the end of the removed votes
+            const auto *cursor = db.find<vote_gc_object>();
+            if (cursor == nullptr) {
+                cursor = &db.create<vote_gc_object>([&](vote_gc_object &) {});
+            }
+            db.modify(*cursor, [&](vote_gc_object &o) {
+                o.cursor = result.cursor;
+                o.removed_votes += result.removed;
+            });
+
+            std::cout << "head block: " << db.head_block_num()
+                      << ", votes: " << votes
+                      << ", checked: " << result.checked
+                      << ", removed: " << result.removed
+                      << ", elapsed: " << (fc::time_point::now() - start).count() / 1000 << " ms" << std::endl;
+        });
+
+        db.close();
+    } catch (const fc::exception &e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
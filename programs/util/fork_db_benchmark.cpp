@@ -0,0 +1,270 @@
+/**
+ *  Benchmark of the fork database on simulated chains: a linear chain, a chain with orphaned blocks
+ *  at the head height and chains switching to short and long forks, e.g.:
+ *
+ *    fork_db_benchmark --blocks 200000 --transactions 100 --window 21
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+
+#include <boost/program_options.hpp>
+
+#include <fc/io/json.hpp>
+#include <fc/variant_object.hpp>
+
+#include <golos/chain/fork_database.hpp>
+#include <golos/protocol/operations.hpp>
+
+namespace bpo = boost::program_options;
+
+using golos::chain::fork_database;
+using golos::chain::item_ptr;
+using golos::protocol::signed_block;
+using golos::protocol::block_id_type;
+
+struct scenario {
+    std::string name;
+    /// a fork is created every interval blocks, 0 means no forks
+    uint32_t interval = 0;
+    /// the fork starts from the ancestor of the head at this depth
+    uint32_t depth = 0;
+    /// number of blocks pushed to the fork, the node switches to it when it gets longer than the main branch
+    uint32_t length = 0;
+};
+
+struct operation_result {
+    std::string name;
+    uint64_t count = 0;
+    double total_msec = 0;
+    double avg_usec = 0;
+    double p50_usec = 0;
+    double p99_usec = 0;
+    double max_usec = 0;
+};
+
+struct scenario_result {
+    std::string name;
+    uint64_t switches = 0;
+    uint64_t blocks_in_database = 0;
+    std::vector<operation_result> operations;
+};
+
+FC_REFLECT((operation_result), (name)(count)(total_msec)(avg_usec)(p50_usec)(p99_usec)(max_usec))
+FC_REFLECT((scenario_result), (name)(switches)(blocks_in_database)(operations))
+
+class recorder {
+public:
+    template<typename Operation>
+    auto measure(const std::string &name, Operation &&op) -> decltype(op()) {
+        struct sample {
+            std::vector<double> &samples;
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+            ~sample() {
+                samples.push_back(std::chrono::duration<double, std::micro>(
+                    std::chrono::steady_clock::now() - start).count());
+            }
+        } s{_samples[name]};
+        return op();
+    }
+
+    std::vector<operation_result> results() {
+        std::vector<operation_result> result;
+        for (auto &s: _samples) {
+            auto &samples = s.second;
+            if (samples.empty()) {
+                continue;
+            }
+            std::sort(samples.begin(), samples.end());
+
+            operation_result r;
+            r.name = s.first;
+            r.count = samples.size();
+            for (auto v: samples) {
+                r.total_msec += v / 1000;
+            }
+            r.avg_usec = r.total_msec * 1000 / r.count;
+            r.p50_usec = samples[samples.size() / 2];
+            r.p99_usec = samples[samples.size() * 99 / 100];
+            r.max_usec = samples.back();
+            result.push_back(r);
+        }
+        return result;
+    }
+
+private:
+    std::map<std::string, std::vector<double>> _samples;
+};
+
+class block_generator {
+public:
+    block_generator(uint32_t transactions, uint32_t memo_size)
+            : _transactions(transactions), _memo(memo_size, 'x') {
+    }
+
+    signed_block make_block(const block_id_type &previous, const std::string &witness) {
+        signed_block b;
+        b.previous = previous;
+        b.timestamp = fc::time_point_sec(1500000000 + b.block_num() * STEEMIT_BLOCK_INTERVAL);
+        b.witness = witness;
+
+        for (uint32_t i = 0; i < _transactions; ++i) {
+            golos::protocol::transfer_operation op;
+            op.from = "alice";
+            op.to = "bob";
+            op.amount = golos::protocol::asset(++_nonce, STEEM_SYMBOL);
+            op.memo = _memo;
+
+            golos::protocol::signed_transaction trx;
+            trx.ref_block_num = uint16_t(b.block_num());
+            trx.expiration = b.timestamp + STEEMIT_MAX_TIME_UNTIL_EXPIRATION;
+            trx.operations.push_back(op);
+            trx.signatures.push_back(golos::protocol::signature_type());
+            b.transactions.push_back(trx);
+        }
+        return b;
+    }
+
+private:
+    uint32_t _transactions;
+    std::string _memo;
+    int64_t _nonce = 0;
+};
+
+scenario_result run(const scenario &s, uint32_t blocks, uint32_t window, block_generator &generator) {
+    recorder rec;
+    fork_database fork_db;
+    std::mt19937 rng(42);
+    scenario_result result;
+    result.name = s.name;
+
+    fork_db.start_block(generator.make_block(block_id_type(), "initminer"));
+
+    for (uint32_t i = 1; i <= blocks; ++i) {
+        auto head = fork_db.head();
+        auto b = generator.make_block(head->id, "witness" + std::to_string(i % STEEMIT_MAX_WITNESSES));
+        head = rec.measure("push_block", [&]() { return fork_db.push_block(b); });
+
+        if (s.interval && i % s.interval == 0 && head->num > s.depth) {
+            auto main_head = head;
+            auto fork_head = fork_db.walk_main_branch_to_num(head->num - s.depth);
+            for (uint32_t k = 0; k < s.length; ++k) {
+                auto fb = generator.make_block(fork_head->id, "fork" + std::to_string(k));
+                rec.measure("push_block", [&]() { return fork_db.push_block(fb); });
+                fork_head = fork_db.fetch_block(fb.id());
+            }
+
+            if (fork_db.head() != main_head) {
+                // the same steps as database::_push_block does on switching forks
+                auto branches = rec.measure("fetch_branch_from", [&]() {
+                    return fork_db.fetch_branch_from(fork_db.head()->id, main_head->id);
+                });
+                for (size_t k = 0; k < branches.second.size(); ++k) {
+                    rec.measure("pop_block", [&]() { fork_db.pop_block(); return 0; });
+                }
+                fork_db.set_head(branches.first.front());
+                for (auto itr = branches.first.rbegin(); itr != branches.first.rend(); ++itr) {
+                    rec.measure("unpack", [&]() { return (*itr)->data().transactions.size(); });
+                }
+                ++result.switches;
+            }
+        }
+
+        // the last irreversible block goes to the block log, the window is trimmed
+        auto lib_num = fork_db.head()->num > window ? fork_db.head()->num - window : 0;
+        if (lib_num) {
+            rec.measure("fetch_on_main_branch", [&]() {
+                return fork_db.fetch_block_on_main_branch_by_number(lib_num);
+            });
+        }
+        rec.measure("set_max_size", [&]() { fork_db.set_max_size(window + 1); return 0; });
+
+        // API calls ask for recent blocks
+        auto num = fork_db.head()->num - rng() % std::min(window, fork_db.head()->num);
+        rec.measure("fetch_by_number", [&]() { return fork_db.fetch_block_by_number(num); });
+    }
+
+    result.blocks_in_database = fork_db.size();
+    result.operations = rec.results();
+    return result;
+}
+
+int main(int argc, char **argv, char **envp) {
+    try {
+        bpo::options_description opts("Options");
+        opts.add_options()
+            ("help,h", "print this help message")
+            ("blocks,b", bpo::value<uint32_t>()->default_value(100000), "number of blocks in each scenario")
+            ("transactions,t", bpo::value<uint32_t>()->default_value(50), "number of transactions in a block")
+            ("memo-size", bpo::value<uint32_t>()->default_value(64), "size of the memo of transfers")
+            ("window,w", bpo::value<uint32_t>()->default_value(21), "distance from the head to the last irreversible block")
+            ("json,j", bpo::bool_switch()->default_value(false), "print results as json");
+
+        bpo::variables_map options;
+        bpo::store(bpo::parse_command_line(argc, argv, opts), options);
+
+        if (options.count("help")) {
+            std::cout << opts << std::endl;
+            return 0;
+        }
+
+        auto blocks = options.at("blocks").as<uint32_t>();
+        auto window = options.at("window").as<uint32_t>();
+        FC_ASSERT(window > 0, "Window should be positive");
+
+        block_generator generator(options.at("transactions").as<uint32_t>(), options.at("memo-size").as<uint32_t>());
+
+        std::vector<scenario> scenarios = {
+            {"linear", 0, 0, 0},
+            {"orphans", 10, 1, 1},
+            {"short-switch", 50, 2, 3},
+            {"long-switch", 500, std::min<uint32_t>(window, 20), std::min<uint32_t>(window, 20) + 1}
+        };
+
+        std::vector<scenario_result> results;
+        for (const auto &s: scenarios) {
+            results.push_back(run(s, blocks, window, generator));
+        }
+
+        if (options.at("json").as<bool>()) {
+            std::cout << fc::json::to_pretty_string(fc::mutable_variant_object()
+                ("blocks", blocks)("window", window)("results", results)) << std::endl;
+            return 0;
+        }
+
+        std::cout << std::fixed << std::setprecision(3);
+        for (const auto &r: results) {
+            std::cout << r.name << ": " << r.switches << " switches, "
+                      << r.blocks_in_database << " blocks in the fork database\n";
+            std::cout << std::left << std::setw(22) << "operation"
+                      << std::right << std::setw(12) << "count"
+                      << std::setw(12) << "total msec"
+                      << std::setw(12) << "avg usec"
+                      << std::setw(12) << "p50 usec"
+                      << std::setw(12) << "p99 usec"
+                      << std::setw(12) << "max usec" << "\n";
+            for (const auto &op: r.operations) {
+                std::cout << std::left << std::setw(22) << op.name
+                          << std::right << std::setw(12) << op.count
+                          << std::setw(12) << op.total_msec
+                          << std::setw(12) << op.avg_usec
+                          << std::setw(12) << op.p50_usec
+                          << std::setw(12) << op.p99_usec
+                          << std::setw(12) << op.max_usec << "\n";
+            }
+            std::cout << "\n";
+        }
+    } catch (const fc::exception &e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
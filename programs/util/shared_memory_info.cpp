@@ -0,0 +1,146 @@
+/**
+ *  Reports memory used by each index of a closed shared_memory.bin.
+ *  The node should be stopped, the file is opened read-only.
+ */
+
+#include <golos/chain/database.hpp>
+#include <golos/chain/index.hpp>
+
+#include <golos/plugins/account_by_key/account_by_key_objects.hpp>
+#include <golos/plugins/account_history/history_object.hpp>
+#include <golos/plugins/account_notes/account_notes_objects.hpp>
+#include <golos/plugins/follow/follow_objects.hpp>
+#include <golos/plugins/market_history/market_history_objects.hpp>
+#include <golos/plugins/operation_history/history_object.hpp>
+#include <golos/plugins/private_message/private_message_objects.hpp>
+#include <golos/plugins/social_network/social_network.hpp>
+#include <golos/plugins/tags/tags_object.hpp>
+
+#include <fc/io/json.hpp>
+
+#include <boost/core/demangle.hpp>
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <typeinfo>
+
+namespace bpo = boost::program_options;
+
+using namespace golos::chain;
+using namespace golos::plugins;
+
+/** Plugin indexes exist only if the plugin was enabled on the node, missing ones are reported and skipped */
+template<typename MultiIndexType>
+void add_plugin_index_if_exists(database &db) {
+    try {
+        db.add_index<MultiIndexType>();
+        db.add_index_memory_profiler(std::make_shared<index_memory_profiler<MultiIndexType>>());
+    } catch (const fc::exception &e) {
+        std::cerr << "skipped index " << boost::core::demangle(typeid(MultiIndexType).name())
+                  << ": " << e.to_string() << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "skipped index " << boost::core::demangle(typeid(MultiIndexType).name())
+                  << ": " << e.what() << std::endl;
+    }
+}
+
+void add_plugin_indexes(database &db) {
+    add_plugin_index_if_exists<account_by_key::key_lookup_index>(db);
+    add_plugin_index_if_exists<account_history::account_history_index>(db);
+    add_plugin_index_if_exists<account_notes::account_note_index>(db);
+    add_plugin_index_if_exists<account_notes::account_note_stats_index>(db);
+    add_plugin_index_if_exists<follow::follow_index>(db);
+    add_plugin_index_if_exists<follow::feed_index>(db);
+    add_plugin_index_if_exists<follow::blog_index>(db);
+    add_plugin_index_if_exists<follow::reputation_index>(db);
+    add_plugin_index_if_exists<follow::follow_count_index>(db);
+    add_plugin_index_if_exists<follow::blog_author_stats_index>(db);
+    add_plugin_index_if_exists<market_history::bucket_index>(db);
+    add_plugin_index_if_exists<market_history::order_history_index>(db);
+    add_plugin_index_if_exists<operation_history::operation_index>(db);
+    add_plugin_index_if_exists<private_message::message_index>(db);
+    add_plugin_index_if_exists<private_message::settings_index>(db);
+    add_plugin_index_if_exists<private_message::contact_index>(db);
+    add_plugin_index_if_exists<private_message::contact_size_index>(db);
+    add_plugin_index_if_exists<social_network::comment_content_index>(db);
+    add_plugin_index_if_exists<social_network::comment_last_update_index>(db);
+    add_plugin_index_if_exists<social_network::comment_reward_index>(db);
+    add_plugin_index_if_exists<tags::tag_index>(db);
+    add_plugin_index_if_exists<tags::tag_stats_index>(db);
+    add_plugin_index_if_exists<tags::author_tag_stats_index>(db);
+    add_plugin_index_if_exists<tags::language_index>(db);
+}
+
+std::string to_mb(uint64_t size) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << double(size) / (1024 * 1024) << "M";
+    return out.str();
+}
+
+int main(int argc, char **argv) {
+    try {
+        bpo::options_description opts("Options");
+        opts.add_options()
+            ("help,h", "print this help message")
+            ("shared-file-dir,d", bpo::value<std::string>()->default_value("blockchain"),
+                "directory with shared_memory.bin")
+            ("sample-size,s", bpo::value<uint64_t>()->default_value(0),
+                "number of objects per index scanned to estimate dynamic memory, 0 = all objects")
+            ("json,j", bpo::bool_switch()->default_value(false), "print result as json");
+
+        bpo::variables_map options;
+        bpo::store(bpo::parse_command_line(argc, argv, opts), options);
+
+        if (options.count("help")) {
+            std::cout << opts << std::endl;
+            return 0;
+        }
+
+        fc::path shared_file_dir(options.at("shared-file-dir").as<std::string>());
+
+        database db;
+        db.open(shared_file_dir, shared_file_dir, STEEMIT_INIT_SUPPLY, 0, chainbase::database::read_only);
+        add_plugin_indexes(db);
+
+        auto stats = db.get_index_memory_statistics(options.at("sample-size").as<uint64_t>());
+        std::sort(stats.begin(), stats.end(), [](const index_memory_info &a, const index_memory_info &b) {
+            return a.node_size + a.dynamic_size > b.node_size + b.dynamic_size;
+        });
+
+        if (options.at("json").as<bool>()) {
+            std::cout << fc::json::to_pretty_string(stats) << std::endl;
+            return 0;
+        }
+
+        std::cout << "head block: " << db.head_block_num()
+                  << ", total: " << to_mb(db.max_memory())
+                  << ", free: " << to_mb(db.free_memory()) << "\n\n";
+
+        std::cout << std::left << std::setw(64) << "index"
+                  << std::right << std::setw(14) << "objects"
+                  << std::setw(10) << "object"
+                  << std::setw(12) << "nodes"
+                  << std::setw(12) << "dynamic"
+                  << std::setw(12) << "total" << "\n";
+
+        for (const auto &s: stats) {
+            std::cout << std::left << std::setw(64) << s.name
+                      << std::right << std::setw(14) << s.object_count
+                      << std::setw(10) << s.object_size
+                      << std::setw(12) << to_mb(s.node_size)
+                      << std::setw(12) << to_mb(s.dynamic_size)
+                      << std::setw(12) << to_mb(s.node_size + s.dynamic_size) << "\n";
+        }
+    } catch (const fc::exception &e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
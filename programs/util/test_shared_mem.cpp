@@ -1,18 +1,28 @@
-
+/**
+ *  Benchmark of multi_index containers in a memory mapped file, the way chainbase keeps the state.
+ *  It measures insertion, modification (the work of block application) and lookups (the work of API calls)
+ *  with the huge pages and NUMA policies supported by the node, e.g.:
+ *
+ *    test_shared_mem --dir /dev/shm/bench --objects 5000000 --hugepages transparent
+ *    test_shared_mem --dir /mnt/huge --size 4G --hugepages hugetlbfs --numa bind:0
+ */
+
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
+#include <random>
 
-#include <boost/algorithm/string.hpp>
+#include <boost/program_options.hpp>
 
 #include <fc/io/json.hpp>
-
-#include <graphene/utilities/key_conversion.hpp>
-
-#include <golos/protocol/types.hpp>
-#include <golos/protocol/authority.hpp>
+#include <fc/string.hpp>
+#include <fc/time.hpp>
+#include <fc/variant_object.hpp>
 
 #include <golos/chain/shared_authority.hpp>
+#include <golos/chain/shared_memory_policy.hpp>
 
-#include <boost/interprocess/sync/named_mutex.hpp>
+#include <boost/interprocess/managed_mapped_file.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index/member.hpp>
@@ -20,64 +30,24 @@
 
 using boost::multi_index_container;
 using namespace boost::multi_index;
-namespace bip=boost::interprocess;
-
-/* shared_string is a string type placeable in shared memory,
- *  * courtesy of Boost.Interprocess.
- *   */
+namespace bip = boost::interprocess;
+namespace bpo = boost::program_options;
 
 typedef bip::basic_string<
         char, std::char_traits<char>,
         bip::allocator<char, bip::managed_mapped_file::segment_manager>
 > shared_string;
 
-
-typedef bip::allocator<shared_string, bip::managed_mapped_file::segment_manager> basic_string_allocator;
-
-namespace fc {
-    void to_variant(const shared_string &s, fc::variant &vo) {
-        vo = std::string(s.c_str());
-    }
-
-    void from_variant(const fc::variant &var, shared_string &vo) {
-        vo = var.as_string().c_str();
-    }
-
-    /*
-    template<typename... T >
-    void to_variant( const bip::deque< T... >& t, fc::variant& v ) {
-      std::vector<variant> vars(t.size());
-      for( size_t i = 0; i < t.size(); ++i ) {
-         vars[i] = t[i];
-      }
-      v = std::move(vars);
-    }
-
-    template<typename T, typename... A>
-    void from_variant( const fc::variant& v, bip::deque< T, A... >& d ) {
-      const variants& vars = v.get_array();
-      d.clear();
-      d.resize( vars.size() );
-      for( uint32_t i = 0; i < vars.size(); ++i ) {
-         from_variant( vars[i], d[i] );
-      }
-    }
-    */
-}
-
-
 /* Book record. All its members can be placed in shared memory,
- *  * hence the structure itself can too.
- *   */
-
+ * hence the structure itself can too.
+ */
 struct book {
     typedef bip::allocator<book, bip::managed_mapped_file::segment_manager> allocator_type;
 
     template<typename Constructor, typename Allocator>
     book(Constructor &&c, const Allocator &al)
-            :name(al), author(al), pages(0), prize(0),
-             auth(bip::allocator<golos::chain::shared_authority, bip::managed_mapped_file::segment_manager>(al.get_segment_manager())),
-             deq(basic_string_allocator(al.get_segment_manager())) {
+            : name(al), author(al), pages(0), prize(0),
+              auth(bip::allocator<golos::chain::shared_authority, bip::managed_mapped_file::segment_manager>(al.get_segment_manager())) {
         c(*this);
     }
 
@@ -86,83 +56,189 @@ struct book {
     int32_t pages;
     int32_t prize;
     golos::chain::shared_authority auth;
-    bip::deque<shared_string, basic_string_allocator> deq;
-
-    book(const shared_string::allocator_type &al) :
-            name(al), author(al), pages(0), prize(0),
-            auth(bip::allocator<golos::chain::shared_authority, bip::managed_mapped_file::segment_manager>(al.get_segment_manager())),
-            deq(basic_string_allocator(al.get_segment_manager())) {
-    }
-
 };
 
+struct by_author;
+struct by_name;
+struct by_prize;
+
 typedef multi_index_container<
         book,
         indexed_by<
-                ordered_non_unique<BOOST_MULTI_INDEX_MEMBER(book, shared_string, author)>,
-                ordered_non_unique<BOOST_MULTI_INDEX_MEMBER(book, shared_string, name)>,
-                ordered_non_unique<BOOST_MULTI_INDEX_MEMBER(book, int32_t, prize)>
+                ordered_non_unique<tag<by_author>, BOOST_MULTI_INDEX_MEMBER(book, shared_string, author)>,
+                ordered_unique<tag<by_name>, BOOST_MULTI_INDEX_MEMBER(book, shared_string, name)>,
+                ordered_non_unique<tag<by_prize>, BOOST_MULTI_INDEX_MEMBER(book, int32_t, prize)>
         >,
         bip::allocator<book, bip::managed_mapped_file::segment_manager>
 > book_container;
 
-
-FC_REFLECT((book), (name)(author)(pages)(prize)(deq)(auth))
-
-struct astr {
-    fc::fixed_string<> str;
-    fc::fixed_string<> str1;
-    fc::fixed_string<> str2;
+struct benchmark_result {
+    std::string name;
+    uint64_t operations = 0;
+    double seconds = 0;
+    double ops_per_second = 0;
+    /// latency of a batch of operations divided by its size
+    double p50_usec = 0;
+    double p99_usec = 0;
+    double max_usec = 0;
 };
-FC_REFLECT((astr), (str)(str1)(str2));
-struct bstr {
-    std::string str;
-    std::string str1;
-    std::string str2;
-};
-FC_REFLECT((bstr), (str)(str1)(str2));
 
-int main(int argc, char **argv, char **envp) {
-    try {
+FC_REFLECT((benchmark_result), (name)(operations)(seconds)(ops_per_second)(p50_usec)(p99_usec)(max_usec))
 
-        bip::managed_mapped_file seg(bip::open_or_create, "./book_container.db",
-                1024 * 100);
-        bip::named_mutex mutex(bip::open_or_create, "./book_container.db");
-
-        /*
-        book b( book::allocator_type( seg.get_segment_manager() ) );
-        b.name = "test name";
-        b.author = "test author";
-        b.deq.push_back( shared_string( "hello world", basic_string_allocator( seg.get_segment_manager() )  ) );
-        idump((b));
-        */
-        book_container *pbc = seg.find_or_construct<book_container>("book container")(book_container::ctor_args_list(),
-                book_container::allocator_type(seg.get_segment_manager()));
-
-        for (const auto &item : *pbc) {
-            idump((item));
-        }
+std::string book_name(uint64_t n) {
+    // names are spread over the key space like account names and permlinks
+    return "book-" + std::to_string((n * 2654435761u) % 1000000007u) + "-" + std::to_string(n);
+}
 
-        //b.pages = pbc->size();
-        //b.auth = golos::chain::authority( 1, "dan", pbc->size() );
-        pbc->emplace([&](book &b) {
-            b.name = "emplace name";
-            b.pages = pbc->size();
-        }, book::allocator_type(seg.get_segment_manager()));
+template<typename Operation>
+benchmark_result run(const std::string &name, uint64_t operations, Operation &&op) {
+    constexpr uint64_t batch = 1000;
+    std::vector<double> latencies;
+    latencies.reserve(operations / batch + 1);
+
+    auto start = fc::time_point::now();
+    for (uint64_t i = 0; i < operations; i += batch) {
+        auto batch_start = fc::time_point::now();
+        auto end = std::min(operations, i + batch);
+        for (uint64_t j = i; j < end; ++j) {
+            op(j);
+        }
+        latencies.push_back(double((fc::time_point::now() - batch_start).count()) / (end - i));
+    }
 
-        bip::deque < book,
-                book::allocator_type > *deq =
-                        seg.find_or_construct < bip::deque < book,
-                book::allocator_type > >
-                ("book deque")(book_container::allocator_type(seg.get_segment_manager()));
-        idump((deq->size()));
+    benchmark_result result;
+    result.name = name;
+    result.operations = operations;
+    result.seconds = double((fc::time_point::now() - start).count()) / 1000000.0;
+    result.ops_per_second = result.seconds > 0 ? operations / result.seconds : 0;
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        result.p50_usec = latencies[latencies.size() / 2];
+        result.p99_usec = latencies[latencies.size() * 99 / 100];
+        result.max_usec = latencies.back();
+    }
+    return result;
+}
 
-        // book c( b ); //book::allocator_type( seg.get_segment_manager() ) );
-        // deq->push_back( b );
+int main(int argc, char **argv, char **envp) {
+    try {
+        bpo::options_description opts("Options");
+        opts.add_options()
+            ("help,h", "print this help message")
+            ("dir,d", bpo::value<std::string>()->default_value("."), "directory of the mapped file")
+            ("size,s", bpo::value<std::string>()->default_value("2G"), "size of the mapped file")
+            ("objects,n", bpo::value<uint64_t>()->default_value(1000000), "number of objects to insert")
+            ("operations,o", bpo::value<uint64_t>()->default_value(1000000), "number of modifications and lookups")
+            ("hugepages", bpo::value<std::string>()->default_value("none"), "none, transparent or hugetlbfs")
+            ("numa", bpo::value<std::string>()->default_value("none"), "none, interleave[:nodes] or bind:nodes")
+            ("json,j", bpo::bool_switch()->default_value(false), "print results as json");
+
+        bpo::variables_map options;
+        bpo::store(bpo::parse_command_line(argc, argv, opts), options);
+
+        if (options.count("help")) {
+            std::cout << opts << std::endl;
+            return 0;
+        }
 
+        fc::path dir(options.at("dir").as<std::string>());
+        uint64_t size = fc::parse_size(options.at("size").as<std::string>());
+        uint64_t objects = options.at("objects").as<uint64_t>();
+        uint64_t operations = options.at("operations").as<uint64_t>();
+        FC_ASSERT(objects > 0, "At least one object is required");
+
+        golos::chain::shared_memory_policy policy;
+        policy.hugepages = golos::chain::shared_memory_policy::parse_hugepages(options.at("hugepages").as<std::string>());
+        policy.parse_numa(options.at("numa").as<std::string>());
+
+        fc::create_directories(dir);
+        auto file = dir / "test_shared_mem.bin";
+        fc::remove_all(file);
+
+        policy.check_shared_memory_dir(dir, size);
+
+        bip::managed_mapped_file seg(bip::create_only, file.string().c_str(), size);
+        policy.apply_to_mapping(seg.get_address());
+
+        auto *books = seg.construct<book_container>("book container")(
+            book_container::ctor_args_list(), book_container::allocator_type(seg.get_segment_manager()));
+
+        std::mt19937_64 rng(42);
+        std::vector<benchmark_result> results;
+
+        results.push_back(run("insert", objects, [&](uint64_t n) {
+            books->emplace([&](book &b) {
+                auto name = book_name(n);
+                b.name.assign(name.begin(), name.end());
+                auto author = "author-" + std::to_string(rng() % (objects / 10 + 1));
+                b.author.assign(author.begin(), author.end());
+                b.pages = n;
+                b.prize = rng() % 100000;
+            }, book::allocator_type(seg.get_segment_manager()));
+        }));
+
+        shared_string key(shared_string::allocator_type(seg.get_segment_manager()));
+        auto find_random = [&]() {
+            auto name = book_name(rng() % objects);
+            key.assign(name.begin(), name.end());
+            return books->get<by_name>().find(key);
+        };
+
+        // block application finds objects by a key and updates an indexed field
+        results.push_back(run("modify", operations, [&](uint64_t) {
+            auto itr = find_random();
+            books->get<by_name>().modify(itr, [&](book &b) {
+                b.prize = rng() % 100000;
+            });
+        }));
+
+        uint64_t checksum = 0;
+        results.push_back(run("find", operations, [&](uint64_t) {
+            checksum += find_random()->pages;
+        }));
+
+        // API calls usually read a page of objects from a position in the index
+        results.push_back(run("range-20", operations / 10, [&](uint64_t) {
+            auto &idx = books->get<by_prize>();
+            auto itr = idx.lower_bound(int32_t(rng() % 100000));
+            for (int i = 0; i < 20 && itr != idx.end(); ++i, ++itr) {
+                checksum += itr->pages;
+            }
+        }));
+
+        if (options.at("json").as<bool>()) {
+            std::cout << fc::json::to_pretty_string(fc::mutable_variant_object()
+                ("policy", policy)("objects", objects)("free_memory", seg.get_free_memory())("results", results))
+                << std::endl;
+        } else {
+            std::cout << "objects: " << objects << ", free memory: " << seg.get_free_memory() / (1024 * 1024)
+                      << "M, policy: " << fc::json::to_string(policy) << ", checksum: " << checksum << "\n\n";
+            std::cout << std::left << std::setw(12) << "operation"
+                      << std::right << std::setw(12) << "count"
+                      << std::setw(12) << "seconds"
+                      << std::setw(14) << "ops/sec"
+                      << std::setw(12) << "p50 usec"
+                      << std::setw(12) << "p99 usec"
+                      << std::setw(12) << "max usec" << "\n";
+            std::cout << std::fixed << std::setprecision(3);
+            for (const auto &r: results) {
+                std::cout << std::left << std::setw(12) << r.name
+                          << std::right << std::setw(12) << r.operations
+                          << std::setw(12) << r.seconds
+                          << std::setw(14) << std::setprecision(0) << r.ops_per_second << std::setprecision(3)
+                          << std::setw(12) << r.p50_usec
+                          << std::setw(12) << r.p99_usec
+                          << std::setw(12) << r.max_usec << "\n";
+            }
+        }
 
+        seg.destroy_ptr(books);
+    } catch (const fc::exception &e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
     } catch (const std::exception &e) {
-        edump((std::string(e.what())));
+        std::cerr << e.what() << std::endl;
+        return 1;
     }
     return 0;
 }
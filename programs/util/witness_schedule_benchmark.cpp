@@ -0,0 +1,269 @@
+/**
+ *  Benchmark of witness schedule rounds on a chain with many registered witnesses. Every block changes votes
+ *  of random witnesses, every STEEMIT_MAX_WITNESSES block shuffles a new round, e.g.:
+ *
+ *    witness_schedule_benchmark --witnesses 1000 10000 50000 --rounds 200 --vote-changes 100
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+
+#include <boost/program_options.hpp>
+
+#include <fc/filesystem.hpp>
+#include <fc/io/json.hpp>
+#include <fc/string.hpp>
+#include <fc/variant_object.hpp>
+
+#include <golos/chain/account_object.hpp>
+#include <golos/chain/database.hpp>
+#include <golos/chain/witness_objects.hpp>
+
+namespace bpo = boost::program_options;
+
+using golos::chain::database;
+using golos::chain::account_object;
+using golos::chain::witness_object;
+using golos::chain::dynamic_global_property_object;
+using golos::protocol::asset;
+
+struct operation_result {
+    std::string name;
+    uint64_t count = 0;
+    double total_msec = 0;
+    double avg_usec = 0;
+    double p50_usec = 0;
+    double p99_usec = 0;
+    double max_usec = 0;
+};
+
+struct witnesses_result {
+    uint32_t witnesses = 0;
+    uint32_t rounds = 0;
+    std::vector<operation_result> operations;
+    /// the update_witness_schedule stage of the block profiler, rounds and ordinary blocks together
+    std::vector<golos::chain::profiler_stage_statistics> stages;
+};
+
+FC_REFLECT((operation_result), (name)(count)(total_msec)(avg_usec)(p50_usec)(p99_usec)(max_usec))
+FC_REFLECT((witnesses_result), (witnesses)(rounds)(operations)(stages))
+
+class recorder {
+public:
+    template<typename Operation>
+    void measure(const std::string &name, Operation &&op) {
+        auto start = std::chrono::steady_clock::now();
+        op();
+        _samples[name].push_back(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::vector<operation_result> results() {
+        std::vector<operation_result> result;
+        for (auto &s: _samples) {
+            auto &samples = s.second;
+            if (samples.empty()) {
+                continue;
+            }
+            std::sort(samples.begin(), samples.end());
+
+            operation_result r;
+            r.name = s.first;
+            r.count = samples.size();
+            for (auto v: samples) {
+                r.total_msec += v / 1000;
+            }
+            r.avg_usec = r.total_msec * 1000 / r.count;
+            r.p50_usec = samples[samples.size() / 2];
+            r.p99_usec = samples[samples.size() * 99 / 100];
+            r.max_usec = samples.back();
+            result.push_back(r);
+        }
+        return result;
+    }
+
+private:
+    std::map<std::string, std::vector<double>> _samples;
+};
+
+struct benchmark_options {
+    uint32_t rounds = 0;
+    uint32_t vote_changes = 0;
+    /// percent of witnesses without a signing key, they are skipped by the schedule
+    uint32_t disabled = 0;
+    uint64_t shared_file_size = 0;
+};
+
+witnesses_result run(uint32_t witnesses, const benchmark_options &opts) {
+    static constexpr int64_t max_votes = 1000000000;
+    static const uint32_t skip =
+        database::skip_witness_signature | database::skip_transaction_signatures |
+        database::skip_authority_check | database::skip_tapos_check |
+        database::skip_undo_history_check | database::skip_block_size_check;
+
+    recorder rec;
+    std::mt19937 rng(42);
+    witnesses_result result;
+    result.witnesses = witnesses;
+
+    fc::temp_directory dir(fc::temp_directory_path());
+    database db;
+    db.open(dir.path(), dir.path(), STEEMIT_INIT_SUPPLY, opts.shared_file_size, chainbase::database::read_write);
+
+    auto key = fc::ecc::private_key::regenerate(fc::sha256::hash(std::string("witness_schedule_benchmark")));
+    auto generate_block = [&]() {
+        db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), key, skip);
+    };
+
+    generate_block();
+    db.set_hardfork(STEEMIT_NUM_HARDFORKS);
+    generate_block();
+
+    // votes are checked against the total vesting shares
+    std::vector<golos::chain::witness_id_type> ids;
+    db.with_strong_write_lock([&]() {
+        db.clear_pending();
+        db.modify(db.get_dynamic_global_properties(), [&](dynamic_global_property_object &p) {
+            p.total_vesting_shares += asset(max_votes * witnesses, VESTS_SYMBOL);
+            p.total_vesting_fund_steem += asset(max_votes / 1000 * witnesses, STEEM_SYMBOL);
+        });
+
+        for (uint32_t i = 0; i < witnesses; ++i) {
+            auto name = "witness" + std::to_string(i);
+            db.create<account_object>([&](account_object &a) {
+                a.name = name;
+                a.created = db.head_block_time();
+            });
+            const auto &w = db.create<witness_object>([&](witness_object &w) {
+                w.owner = name;
+                w.created = db.head_block_time();
+                if (rng() % 100 >= opts.disabled) {
+                    w.signing_key = key.get_public_key();
+                }
+            });
+            db.adjust_witness_vote(w, rng() % max_votes + 1);
+            ids.push_back(w.id);
+        }
+    });
+
+    auto &profiler = db.get_block_profiler();
+    profiler.enable(opts.rounds * STEEMIT_MAX_WITNESSES + 1, fc::seconds(3600));
+
+    while (result.rounds < opts.rounds) {
+        rec.measure("vote_changes", [&]() {
+            db.with_strong_write_lock([&]() {
+                db.clear_pending();
+                for (uint32_t i = 0; i < opts.vote_changes; ++i) {
+                    const auto &w = db.get(ids[rng() % ids.size()]);
+                    int64_t delta = int64_t(rng() % max_votes) - max_votes / 2;
+                    if (w.votes.value + delta < 0 || w.votes.value + delta > max_votes) {
+                        delta = -delta;
+                    }
+                    db.adjust_witness_vote(w, delta);
+                }
+            });
+        });
+
+        if ((db.head_block_num() + 1) % STEEMIT_MAX_WITNESSES == 0) {
+            rec.measure("round_block", generate_block);
+            ++result.rounds;
+        } else {
+            rec.measure("block", generate_block);
+        }
+    }
+
+    for (const auto &s: profiler.get_statistics()) {
+        if (s.name == "stage:update_witness_schedule") {
+            result.stages.push_back(s);
+        }
+    }
+    result.operations = rec.results();
+
+    db.close();
+    return result;
+}
+
+int main(int argc, char **argv, char **envp) {
+    try {
+        bpo::options_description opts("Options");
+        opts.add_options()
+            ("help,h", "print this help message")
+            ("witnesses,w", bpo::value<std::vector<uint32_t>>()->multitoken()->default_value(std::vector<uint32_t>{1000, 10000, 50000}, "1000 10000 50000"),
+                "numbers of registered witnesses, the benchmark is run on a new chain for each number")
+            ("rounds,r", bpo::value<uint32_t>()->default_value(200), "number of schedule rounds")
+            ("vote-changes,v", bpo::value<uint32_t>()->default_value(100), "number of witness vote changes in a block")
+            ("disabled,d", bpo::value<uint32_t>()->default_value(10), "percent of witnesses without a signing key")
+            ("shared-file-size", bpo::value<std::string>()->default_value("4G"), "size of the shared memory file")
+            ("json,j", bpo::bool_switch()->default_value(false), "print results as json");
+
+        bpo::variables_map options;
+        bpo::store(bpo::parse_command_line(argc, argv, opts), options);
+
+        if (options.count("help")) {
+            std::cout << opts << std::endl;
+            return 0;
+        }
+
+        benchmark_options bench;
+        bench.rounds = options.at("rounds").as<uint32_t>();
+        bench.vote_changes = options.at("vote-changes").as<uint32_t>();
+        bench.disabled = options.at("disabled").as<uint32_t>();
+        bench.shared_file_size = fc::parse_size(options.at("shared-file-size").as<std::string>());
+        FC_ASSERT(bench.rounds > 0, "Rounds should be positive");
+        FC_ASSERT(bench.disabled < 100, "Some witnesses should have signing keys");
+
+        std::vector<witnesses_result> results;
+        for (auto w: options.at("witnesses").as<std::vector<uint32_t>>()) {
+            results.push_back(run(w, bench));
+        }
+
+        if (options.at("json").as<bool>()) {
+            std::cout << fc::json::to_pretty_string(fc::mutable_variant_object()
+                ("rounds", bench.rounds)("vote_changes", bench.vote_changes)("disabled", bench.disabled)
+                ("results", results)) << std::endl;
+            return 0;
+        }
+
+        std::cout << std::fixed << std::setprecision(3);
+        for (const auto &r: results) {
+            std::cout << r.witnesses << " witnesses, " << r.rounds << " rounds\n";
+            std::cout << std::left << std::setw(32) << "operation"
+                      << std::right << std::setw(12) << "count"
+                      << std::setw(12) << "total msec"
+                      << std::setw(12) << "avg usec"
+                      << std::setw(12) << "p50 usec"
+                      << std::setw(12) << "p99 usec"
+                      << std::setw(12) << "max usec" << "\n";
+            for (const auto &op: r.operations) {
+                std::cout << std::left << std::setw(32) << op.name
+                          << std::right << std::setw(12) << op.count
+                          << std::setw(12) << op.total_msec
+                          << std::setw(12) << op.avg_usec
+                          << std::setw(12) << op.p50_usec
+                          << std::setw(12) << op.p99_usec
+                          << std::setw(12) << op.max_usec << "\n";
+            }
+            for (const auto &s: r.stages) {
+                std::cout << std::left << std::setw(32) << s.name
+                          << std::right << std::setw(12) << s.count
+                          << std::setw(12) << double(s.total.count()) / 1000
+                          << std::setw(12) << double(s.total.count()) / s.count
+                          << std::setw(12) << s.p50.count()
+                          << std::setw(12) << s.p99.count()
+                          << std::setw(12) << s.max.count() << "\n";
+            }
+            std::cout << "\n";
+        }
+    } catch (const fc::exception &e) {
+        std::cerr << e.to_detail_string() << std::endl;
+        return 1;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -64,6 +64,37 @@ BOOST_AUTO_TEST_CASE(account_history_blocks) {
 }
 
 
+BOOST_AUTO_TEST_CASE(account_history_reindex) {
+    BOOST_TEST_MESSAGE("Testing: account_history_reindex");
+    initialize();
+    add_operations();
+
+    account_name_set names = {"alice", "bob", "sam", "dave", "cyberfounder"};
+    auto history = check(names);
+    BOOST_REQUIRE(!history.empty());
+    auto history_size = db->get_index<account_history_index>().indices().size();
+
+    // the history is rebuilt from operation_history without replaying the state
+    db->reindex_plugins({"account_history"});
+    BOOST_CHECK_EQUAL(db->get_index<account_history_index>().indices().size(), history_size);
+    BOOST_CHECK(check(names) == history);
+
+    STEEMIT_CHECK_THROW(db->reindex_plugins({"follow"}), fc::exception);
+}
+
+BOOST_AUTO_TEST_CASE(account_history_reindex_of_trimmed_operations) {
+    BOOST_TEST_MESSAGE("Testing: account_history_reindex_of_trimmed_operations");
+    initialize({{"history-blocks", "3"}});
+    add_operations();
+
+    // the trimmed operations would rebuild an incomplete history, so the history is kept
+    auto history_size = db->get_index<account_history_index>().indices().size();
+    BOOST_REQUIRE_GT(history_size, 0u);
+    STEEMIT_CHECK_THROW(db->reindex_plugins({"account_history"}), fc::exception);
+    BOOST_CHECK_EQUAL(db->get_index<account_history_index>().indices().size(), history_size);
+}
+
+
 ///////////////////////////////////////////////////////////////
 // filtering
 ///////////////////////////////////////////////////////////////
@@ -7,6 +7,7 @@
 #include <golos/chain/comment_object.hpp>
 #include <golos/chain/account_object.hpp>
 #include <golos/plugins/chain/plugin.hpp>
+#include <golos/plugins/chain/vote_gc.hpp>
 
 using golos::protocol::comment_operation;
 using golos::protocol::vote_operation;
@@ -284,6 +285,47 @@ BOOST_AUTO_TEST_CASE(clear_votes_older_n_smaller_cashout) {
     BOOST_CHECK_EQUAL(0, count_stored_votes());
 }
 
+BOOST_AUTO_TEST_CASE(clear_votes_per_block) {
+    BOOST_TEST_MESSAGE("Testing: clear_votes_per_block");
+    initialize({
+        {"clear-votes-older-n-blocks", "0"},
+        {"clear-votes-per-block", "4"},
+    });
+
+    generate_voters(10);
+    post();
+    BOOST_TEST_MESSAGE("--- vote 9 times and go to 1 block before cashout");
+    vote_sequence("alice", "post", 5);
+    auto interval = cashout_blocks / 5;
+    vote_sequence("alice", "post", 4, interval);
+    generate_blocks(interval - 1);
+    BOOST_CHECK_EQUAL(9, count_stored_votes());
+
+    BOOST_TEST_MESSAGE("--- go to cashout block and check 4 votes removed");
+    generate_blocks(1);
+    {
+        const auto& post = db->get_comment("alice", std::string("post"));
+        BOOST_CHECK_EQUAL(post.mode, golos::chain::archived);
+    }
+    BOOST_CHECK_EQUAL(5, count_stored_votes());
+
+    BOOST_TEST_MESSAGE("--- check the rest of votes removed in the next blocks");
+    generate_blocks(1);
+    BOOST_CHECK_EQUAL(1, count_stored_votes());
+    generate_blocks(1);
+    BOOST_CHECK_EQUAL(0, count_stored_votes());
+
+    const auto* gc = db->find<vote_gc_object>();
+    BOOST_REQUIRE(gc != nullptr);
+    BOOST_CHECK_EQUAL(9, gc->removed_votes);
+    BOOST_CHECK(gc->cursor == db->head_block_time());
+
+    BOOST_TEST_MESSAGE("--- check the cursor is restored with the votes when the block is popped");
+    db->pop_block();
+    BOOST_CHECK_EQUAL(1, count_stored_votes());
+    BOOST_CHECK_EQUAL(8, db->get<vote_gc_object>().removed_votes);
+}
+
 BOOST_AUTO_TEST_SUITE_END() // clear_votes
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,70 @@
+#include <boost/test/unit_test.hpp>
+
+#include "database_fixture.hpp"
+
+#include <golos/plugins/database_api/plugin.hpp>
+
+using golos::chain::database_fixture;
+using golos::plugins::json_rpc::msg_pack;
+
+using database_api_plugin = golos::plugins::database_api::plugin;
+
+
+struct database_api_fixture : public database_fixture {
+    void initialize(const plugin_options& opts = {}) {
+        database_fixture::initialize<database_api_plugin>(opts);
+        api = find_plugin<database_api_plugin>();
+        open_database();
+        startup();
+    }
+
+    void check_head() {
+        msg_pack mp;
+        mp.args = std::vector<fc::variant>();
+        auto props = api->get_dynamic_global_properties(mp);
+        BOOST_CHECK_EQUAL(props.head_block_number, db->head_block_num());
+        BOOST_CHECK_EQUAL(props.head_block_id.str(), db->head_block_id().str());
+        BOOST_CHECK_EQUAL(props.time.sec_since_epoch(), db->head_block_time().sec_since_epoch());
+    }
+
+    database_api_plugin* api = nullptr;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE(database_api_plugin_tests, database_api_fixture)
+
+BOOST_AUTO_TEST_CASE(read_view_follows_head) {
+    BOOST_TEST_MESSAGE("Testing: read_view_follows_head");
+    initialize();
+    check_head();
+
+    BOOST_TEST_MESSAGE("--- after applied blocks");
+    generate_block();
+    check_head();
+    generate_blocks(3);
+    check_head();
+
+    BOOST_TEST_MESSAGE("--- after the popped block");
+    auto num = db->head_block_num();
+    db->pop_block();
+    BOOST_CHECK_EQUAL(db->head_block_num(), num - 1);
+    check_head();
+
+    BOOST_TEST_MESSAGE("--- after the block applied on the popped one");
+    generate_block();
+    check_head();
+}
+
+BOOST_AUTO_TEST_CASE(read_view_disabled) {
+    BOOST_TEST_MESSAGE("Testing: read_view_disabled");
+    initialize({{"api-read-view", "false"}});
+    check_head();
+
+    generate_block();
+    check_head();
+
+    db->pop_block();
+    check_head();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -26,11 +26,18 @@
 #include <boost/test/unit_test_monitor.hpp>
 
 #include <golos/chain/database.hpp>
+#include <golos/chain/index_memory.hpp>
+#include <golos/chain/operation_notification.hpp>
+#include <golos/chain/read_view.hpp>
+#include <golos/chain/worker_pool.hpp>
 
 #include <fc/crypto/digest.hpp>
 #include "database_fixture.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <random>
+#include <thread>
 
 using namespace golos;
 using namespace golos::chain;
@@ -313,4 +320,337 @@ BOOST_FIXTURE_TEST_SUITE(basic_tests, clean_database_fixture)
         BOOST_CHECK(block.calculate_merkle_root() == c(dO));
     }
 
+    BOOST_AUTO_TEST_CASE(index_memory_statistics) {
+        ACTORS((alice)(bob))
+        generate_block();
+
+        auto stats = db->get_index_memory_statistics();
+        BOOST_REQUIRE(!stats.empty());
+
+        auto account_stats = std::find_if(stats.begin(), stats.end(), [](const index_memory_info &s) {
+            return s.name == "golos::chain::account_object";
+        });
+        BOOST_REQUIRE(account_stats != stats.end());
+        BOOST_CHECK_EQUAL(account_stats->object_count, db->get_index<account_index>().indices().size());
+        BOOST_CHECK_EQUAL(account_stats->scanned_count, account_stats->object_count);
+        BOOST_CHECK_GT(account_stats->node_size, account_stats->object_count * sizeof(account_object));
+
+        // accounts own their json metadata in the shared memory, metadata of the same length
+        //   makes each object own the same dynamic memory, so the extrapolation is exact
+        const std::string metadata(256, 'x');
+        std::vector<account_metadata_id_type> metadata_ids;
+        for (const auto &m: db->get_index<account_metadata_index>().indices()) {
+            metadata_ids.push_back(m.id);
+        }
+        BOOST_REQUIRE_GT(metadata_ids.size(), 1u);
+        for (auto id: metadata_ids) {
+            db->modify(db->get(id), [&](account_metadata_object &m) {
+                from_string(m.json_metadata, metadata);
+            });
+        }
+
+        // 0 scans all objects as database-info-sample-size = 0
+        stats = db->get_index_memory_statistics(0);
+        auto metadata_stats = std::find_if(stats.begin(), stats.end(), [](const index_memory_info &s) {
+            return s.name == "golos::chain::account_metadata_object";
+        });
+        BOOST_REQUIRE(metadata_stats != stats.end());
+        BOOST_CHECK_EQUAL(metadata_stats->object_count, metadata_ids.size());
+        BOOST_CHECK_EQUAL(metadata_stats->scanned_count, metadata_ids.size());
+        BOOST_CHECK_GT(metadata_stats->dynamic_size, 0u);
+        BOOST_CHECK_GE(metadata_stats->dynamic_size, metadata_ids.size() * metadata.size());
+
+        auto sampled = db->get_index_memory_statistics(1);
+        BOOST_REQUIRE_EQUAL(sampled.size(), stats.size());
+        for (size_t i = 0; i < stats.size(); ++i) {
+            BOOST_CHECK_EQUAL(sampled[i].object_count, stats[i].object_count);
+            BOOST_CHECK_LE(sampled[i].scanned_count, 1u);
+        }
+
+        auto sampled_metadata = sampled.begin() + (metadata_stats - stats.begin());
+        BOOST_CHECK_EQUAL(sampled_metadata->name, metadata_stats->name);
+        BOOST_CHECK_EQUAL(sampled_metadata->dynamic_size, metadata_stats->dynamic_size);
+    }
+
+    BOOST_AUTO_TEST_CASE(undo_statistics) {
+        ACTORS((alice)(bob))
+        generate_block();
+        BOOST_CHECK(db->get_undo_statistics().empty());
+
+        db->set_undo_profiling(true);
+        fund("alice", 10000);
+        transfer("alice", "bob", 1000);
+        transfer("bob", "alice", 500);
+        generate_block();
+
+        auto stats = db->get_undo_statistics();
+        auto transfer_stats = std::find_if(stats.begin(), stats.end(), [](const undo_operation_statistics &s) {
+            return s.operation == "transfer_operation";
+        });
+        BOOST_REQUIRE(transfer_stats != stats.end());
+        // the transfers are applied to the pending state and once again in the block
+        BOOST_CHECK_GE(transfer_stats->count, 2u);
+        BOOST_CHECK_GE(transfer_stats->modified, transfer_stats->count * 2);
+        BOOST_CHECK_GT(transfer_stats->copied_size, 0u);
+
+        auto block_stats = std::find_if(stats.begin(), stats.end(), [](const undo_operation_statistics &s) {
+            return s.operation == "block";
+        });
+        BOOST_REQUIRE(block_stats != stats.end());
+        BOOST_CHECK_GT(block_stats->modified, 0u);
+
+        // an object is copied to the undo state only on its first change in a session
+        db->reset_undo_statistics();
+        {
+            auto session = db->start_undo_session();
+            const auto &alice_object = db->get_account("alice");
+            auto expected_size = sizeof(account_object) + dynamic_size(alice_object);
+            db->modify(alice_object, [](account_object &) {});
+            db->modify(alice_object, [](account_object &) {});
+
+            stats = db->get_undo_statistics();
+            BOOST_REQUIRE_EQUAL(stats.size(), 1u);
+            BOOST_CHECK_EQUAL(stats[0].operation, "block");
+            BOOST_CHECK_EQUAL(stats[0].modified, 2u);
+            BOOST_CHECK_EQUAL(stats[0].copied, 1u);
+            BOOST_CHECK_EQUAL(stats[0].copied_size, expected_size);
+
+            // the next session copies it again
+            auto nested_session = db->start_undo_session();
+            db->modify(alice_object, [](account_object &) {});
+            BOOST_CHECK_EQUAL(db->get_undo_statistics()[0].copied, 2u);
+            BOOST_CHECK_EQUAL(db->get_undo_statistics()[0].copied_size, expected_size * 2);
+        }
+
+        db->set_undo_profiling(false);
+        db->reset_undo_statistics();
+        BOOST_CHECK(db->get_undo_statistics().empty());
+    }
+
+
+    BOOST_AUTO_TEST_CASE(read_view_consistency) {
+        struct head_view {
+            uint32_t num = 0;
+            block_id_type id;
+            uint32_t properties_num = 0;
+        };
+
+        read_view<head_view> view;
+        BOOST_CHECK(!view.get());
+
+        boost::signals2::scoped_connection connection = db->applied_block.connect([&](const signed_block &b) {
+            head_view v;
+            v.num = b.block_num();
+            v.id = b.id();
+            v.properties_num = db->get_dynamic_global_properties().head_block_number;
+            view.publish(v);
+        });
+
+        // the reader doesn't lock the database and always sees the state of one block
+        std::atomic<bool> done(false);
+        std::atomic<uint32_t> inconsistent(0);
+        std::thread reader([&]() {
+            while (!done) {
+                auto v = view.get();
+                if (v && (v->num != v->properties_num || block_header::num_from_id(v->id) != v->num)) {
+                    ++inconsistent;
+                }
+            }
+        });
+
+        generate_blocks(20);
+        done = true;
+        reader.join();
+
+        BOOST_CHECK_EQUAL(inconsistent.load(), 0u);
+        BOOST_REQUIRE(view.get());
+        BOOST_CHECK_EQUAL(view.get()->num, db->head_block_num());
+        BOOST_CHECK(view.get()->id == db->head_block_id());
+
+        view.reset();
+        BOOST_CHECK(!view.get());
+    }
+
+
+    BOOST_AUTO_TEST_CASE(block_profiler_statistics) {
+        ACTORS((alice)(bob))
+        generate_block();
+
+        auto &profiler = db->get_block_profiler();
+        BOOST_CHECK(profiler.get_statistics().empty());
+
+        // every block is slow with the zero threshold
+        profiler.enable(2, fc::microseconds(0));
+        generate_blocks(4);
+        fund("alice", 10000);
+        transfer("alice", "bob", 1000);
+        generate_block();
+
+        auto stats = profiler.get_statistics();
+        auto find_stage = [&](const std::string &name) {
+            return std::find_if(stats.begin(), stats.end(), [&](const profiler_stage_statistics &s) {
+                return s.name == name;
+            });
+        };
+
+        auto transfer_stats = find_stage("evaluator:transfer_operation");
+        BOOST_REQUIRE(transfer_stats != stats.end());
+        BOOST_CHECK_LE(transfer_stats->p50, transfer_stats->p99);
+        BOOST_CHECK_LE(transfer_stats->p99, transfer_stats->max);
+
+        // the histograms keep the last two generations of two blocks
+        auto funds_stats = find_stage("stage:process_funds");
+        BOOST_REQUIRE(funds_stats != stats.end());
+        BOOST_CHECK_LE(funds_stats->count, 4u);
+        BOOST_CHECK_GE(funds_stats->count, 3u);
+        BOOST_CHECK(find_stage("signal:applied_block") != stats.end());
+        BOOST_CHECK(find_stage("signal:account_history") != stats.end());
+        // handlers of applied_block are timed per plugin
+        BOOST_CHECK(find_stage("signal:applied_block:chain") != stats.end());
+        BOOST_CHECK(find_stage("signal:applied_block:social_network") != stats.end());
+
+        // the virtual supply is updated twice per block, the stages are distinct
+        BOOST_CHECK(find_stage("stage:update_virtual_supply_after_feed") != stats.end());
+        BOOST_CHECK(find_stage("stage:update_virtual_supply_after_rewards") != stats.end());
+
+        auto slow_blocks = profiler.get_slow_blocks();
+        BOOST_REQUIRE_EQUAL(slow_blocks.size(), 5u);
+        BOOST_CHECK_EQUAL(slow_blocks.back().block_num, db->head_block_num());
+        const auto &block_stages = slow_blocks.back().stages;
+        BOOST_CHECK(std::find_if(block_stages.begin(), block_stages.end(), [](const slow_block_stage &s) {
+            return s.name == "stage:update_witness_schedule";
+        }) != block_stages.end());
+        BOOST_CHECK(std::is_sorted(block_stages.begin(), block_stages.end(), [](const auto &a, const auto &b) {
+            return a.time > b.time;
+        }));
+
+        profiler.disable();
+        profiler.reset();
+        generate_block();
+        BOOST_CHECK(profiler.get_statistics().empty());
+        BOOST_CHECK(profiler.get_slow_blocks().empty());
+    }
+
+
+    BOOST_AUTO_TEST_CASE(worker_pool_jobs) {
+        worker_pool pool;
+        BOOST_CHECK_EQUAL(pool.size(), 0u);
+
+        std::vector<std::atomic<uint32_t>> calls(1000);
+        for (auto &c: calls) {
+            c = 0;
+        }
+        pool.run(calls.size(), 4, [&](size_t i) {
+            ++calls[i];
+        });
+        BOOST_CHECK(std::all_of(calls.begin(), calls.end(), [](const auto &c) {
+            return c == 1;
+        }));
+        // the caller is the fourth thread
+        BOOST_CHECK_EQUAL(pool.size(), 3u);
+
+        // threads are reused by the next jobs
+        std::atomic<size_t> sum(0);
+        pool.run(100, 2, [&](size_t i) {
+            sum += i;
+        });
+        BOOST_CHECK_EQUAL(sum.load(), 4950u);
+        BOOST_CHECK_EQUAL(pool.size(), 3u);
+
+        BOOST_CHECK_THROW(pool.run(100, 4, [&](size_t i) {
+            if (i == 50) {
+                FC_THROW("task failed");
+            }
+        }), fc::exception);
+
+        pool.run(0, 4, [&](size_t) {
+            BOOST_FAIL("empty job");
+        });
+    }
+
+    BOOST_AUTO_TEST_CASE(operation_cost_statistics) {
+        ACTORS((alice)(bob))
+        generate_block();
+
+        uint32_t handled = 0;
+        boost::signals2::scoped_connection connection = db->post_apply_operation.connect(
+            db->with_operation_cost("test_consumer", [&](const operation_notification &note) {
+                ++handled;
+            }));
+
+        transfer(STEEMIT_INIT_MINER_NAME, "alice", 1000);
+        BOOST_CHECK(db->get_operation_cost_statistics().empty());
+
+        db->set_operation_cost_accounting(true);
+        transfer(STEEMIT_INIT_MINER_NAME, "alice", 1000);
+        transfer("alice", "bob", 500);
+
+        auto stats = db->get_operation_cost_statistics();
+        auto find_cost = [&](const std::string &consumer) {
+            return std::find_if(stats.begin(), stats.end(), [&](const operation_cost_statistics &s) {
+                return s.operation == "transfer_operation" && s.consumer == consumer;
+            });
+        };
+
+        auto evaluator_cost = find_cost("evaluator");
+        auto consumer_cost = find_cost("test_consumer");
+        BOOST_REQUIRE(evaluator_cost != stats.end());
+        BOOST_REQUIRE(consumer_cost != stats.end());
+        BOOST_CHECK_EQUAL(evaluator_cost->count, 2u);
+        BOOST_CHECK_EQUAL(consumer_cost->count, 2u);
+        BOOST_CHECK_EQUAL(handled, 3u);
+        BOOST_CHECK_LE(evaluator_cost->share + consumer_cost->share, STEEMIT_100_PERCENT);
+
+        db->set_operation_cost_accounting(false);
+        db->reset_operation_cost_statistics();
+        BOOST_CHECK(db->get_operation_cost_statistics().empty());
+    }
+
+    BOOST_AUTO_TEST_CASE(operation_cost_of_nested_virtual_operations) {
+        ACTORS((alice)(bob))
+        fund("alice", ASSET("10.000 GOLOS"));
+        fund("bob", ASSET("10.000 GBG"));
+        generate_block();
+
+        // the order is filled by the evaluator of bob's order, the handler of fill_order runs inside it
+        const auto handler_time = fc::milliseconds(50);
+        boost::signals2::scoped_connection connection = db->pre_apply_operation.connect(
+            db->with_operation_cost("test_consumer", [&](const operation_notification &note) {
+                if (note.op.which() == operation::tag<fill_order_operation>::value) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(handler_time.count()));
+                }
+            }));
+        db->set_operation_cost_accounting(true);
+
+        signed_transaction tx;
+        limit_order_create_operation op;
+        op.owner = "alice";
+        op.orderid = 1;
+        op.amount_to_sell = ASSET("1.000 GOLOS");
+        op.min_to_receive = ASSET("1.000 GBG");
+        push_tx_with_ops(tx, alice_private_key, op);
+
+        op.owner = "bob";
+        op.amount_to_sell = ASSET("1.000 GBG");
+        op.min_to_receive = ASSET("1.000 GOLOS");
+        push_tx_with_ops(tx, bob_private_key, op);
+
+        auto stats = db->get_operation_cost_statistics();
+        auto find_cost = [&](const std::string &operation, const std::string &consumer) {
+            return std::find_if(stats.begin(), stats.end(), [&](const operation_cost_statistics &s) {
+                return s.operation == operation && s.consumer == consumer;
+            });
+        };
+
+        auto evaluator_cost = find_cost("limit_order_create_operation", "evaluator");
+        auto fill_cost = find_cost("fill_order_operation", "test_consumer");
+        BOOST_REQUIRE(evaluator_cost != stats.end());
+        BOOST_REQUIRE(fill_cost != stats.end());
+        BOOST_CHECK_EQUAL(fill_cost->count, 1u);
+        BOOST_CHECK_GE(fill_cost->time.count(), handler_time.count());
+        BOOST_CHECK_LT(evaluator_cost->time.count(), handler_time.count());
+
+        db->set_operation_cost_accounting(false);
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -108,6 +108,81 @@ BOOST_AUTO_TEST_SUITE(block_tests)
         }
     }
 
+    BOOST_AUTO_TEST_CASE(state_snapshot) {
+        try {
+            fc::temp_directory data_dir(golos::utilities::temp_directory_path());
+            fc::temp_directory snapshot_dir(golos::utilities::temp_directory_path());
+            fc::temp_directory restored_dir(golos::utilities::temp_directory_path());
+            auto init_account_priv_key = STEEMIT_INIT_PRIVATE_KEY;
+
+            uint32_t head_block_num = 0;
+            block_id_type head_block_id;
+            size_t witness_count = 0;
+            {
+                database db;
+                db._log_hardforks = false;
+                db.open(data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+                while (db.get_dynamic_global_properties().last_irreversible_block_num < 50) {
+                    db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+                }
+                db.close();
+
+                // after reopening the state is at the head of the block log
+                db.open(data_dir.path(), data_dir.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+
+                // removed objects leave gaps in ids, the ids aren't handed out again after the snapshot
+                auto decline = [&](int64_t account) -> const decline_voting_rights_request_object & {
+                    return db.create<decline_voting_rights_request_object>([&](decline_voting_rights_request_object &o) {
+                        o.account = account_id_type(account);
+                        o.effective_date = time_point_sec::maximum();
+                    });
+                };
+                for (int64_t i = 1; i <= 3; ++i) {
+                    decline(i);
+                }
+                db.remove(db.get(decline_voting_rights_request_id_type(0)));
+                db.remove(db.get(decline_voting_rights_request_id_type(1)));
+
+                db.write_snapshot(snapshot_dir.path(), 2);
+                head_block_num = db.head_block_num();
+                head_block_id = db.head_block_id();
+                witness_count = db.get_index<witness_index>().indices().size();
+                db.close();
+            }
+
+            fc::copy(data_dir.path() / "block_log", restored_dir.path() / "block_log");
+            fc::copy(data_dir.path() / "block_log.index", restored_dir.path() / "block_log.index");
+            {
+                database db;
+                db._log_hardforks = false;
+                db.open_from_snapshot(restored_dir.path(), restored_dir.path(), snapshot_dir.path(), TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+                BOOST_CHECK_EQUAL(db.head_block_num(), head_block_num);
+                BOOST_CHECK(db.head_block_id() == head_block_id);
+                BOOST_CHECK_EQUAL(db.get_index<witness_index>().indices().size(), witness_count);
+                BOOST_CHECK(db.find_account(STEEMIT_INIT_MINER_NAME) != nullptr);
+
+                const auto &declines = db.get_index<decline_voting_rights_request_index>().indices();
+                BOOST_REQUIRE_EQUAL(declines.size(), 1u);
+                BOOST_CHECK_EQUAL(declines.begin()->id._id, 2);
+                const auto &created = db.create<decline_voting_rights_request_object>([&](decline_voting_rights_request_object &o) {
+                    o.account = account_id_type(4);
+                    o.effective_date = time_point_sec::maximum();
+                });
+                BOOST_CHECK_EQUAL(created.id._id, 3);
+                BOOST_CHECK_EQUAL(declines.size(), 2u);
+                db.remove(created);
+
+                // the restored state keeps producing blocks
+                auto b = db.generate_block(db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing);
+                BOOST_CHECK_EQUAL(b.block_num(), head_block_num + 1);
+                db.close();
+            }
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
     BOOST_AUTO_TEST_CASE(undo_block) {
         try {
             fc::temp_directory data_dir(golos::utilities::temp_directory_path());
@@ -217,6 +292,133 @@ BOOST_AUTO_TEST_SUITE(block_tests)
         }
     }
 
+    BOOST_AUTO_TEST_CASE(fork_database_items) {
+        try {
+            auto make_block = [](const block_id_type &previous, const std::string &witness) {
+                signed_block b;
+                b.previous = previous;
+                b.timestamp = fc::time_point_sec(1500000000 + b.block_num() * STEEMIT_BLOCK_INTERVAL);
+                b.witness = witness;
+                return b;
+            };
+
+            fork_database fork_db;
+            auto genesis = make_block(block_id_type(), "alice");
+            fork_db.start_block(genesis);
+
+            auto b2 = make_block(genesis.id(), "alice");
+            auto b3 = make_block(b2.id(), "alice");
+            auto b3_fork = make_block(b2.id(), "bob");
+            fork_db.push_block(b2);
+            fork_db.push_block(b3);
+            BOOST_CHECK(fork_db.push_block(b3_fork)->id == b3.id());
+
+            BOOST_CHECK_EQUAL(fork_db.fetch_block_by_number(3).size(), 2);
+            BOOST_CHECK_EQUAL(fork_db.fetch_block_by_number(4).size(), 0);
+            BOOST_CHECK(fork_db.fetch_block_on_main_branch_by_number(3)->id == b3.id());
+
+            // the block is unpacked from the packed form on demand
+            auto item = fork_db.fetch_block(b3_fork.id());
+            BOOST_CHECK_EQUAL(item->data().witness, "bob");
+            BOOST_CHECK(item->data().id() == b3_fork.id());
+
+            auto b4 = make_block(b3_fork.id(), "bob");
+            fork_db.push_block(b4);
+            auto branches = fork_db.fetch_branch_from(b4.id(), b3.id());
+            BOOST_CHECK_EQUAL(branches.first.size(), 2);
+            BOOST_CHECK_EQUAL(branches.second.size(), 1);
+            BOOST_CHECK(branches.first.back()->previous_id() == b2.id());
+
+            fork_db.remove(b3.id());
+            BOOST_CHECK(!fork_db.is_known_block(b3.id()));
+            BOOST_CHECK_EQUAL(fork_db.fetch_block_by_number(3).size(), 1);
+
+            fork_db.set_max_size(1);
+            BOOST_CHECK(!fork_db.is_known_block(genesis.id()));
+            BOOST_CHECK(!fork_db.is_known_block(b2.id()));
+            BOOST_CHECK(fork_db.is_known_block(b3_fork.id()));
+            BOOST_CHECK_EQUAL(fork_db.fetch_block_by_number(2).size(), 0);
+            BOOST_CHECK_EQUAL(fork_db.size(), 2);
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(checkpoint_trusted_sync) {
+        try {
+            fc::temp_directory data_dir1(golos::utilities::temp_directory_path());
+            fc::temp_directory data_dir2(golos::utilities::temp_directory_path());
+
+            database db1;
+            db1._log_hardforks = false;
+            db1.open(data_dir1.path(), data_dir1.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+            database db2;
+            db2._log_hardforks = false;
+            db2.open(data_dir2.path(), data_dir2.path(), INITIAL_TEST_SUPPLY, TEST_SHARED_MEM_SIZE, chainbase::database::read_write);
+
+            auto init_account_priv_key = STEEMIT_INIT_PRIVATE_KEY;
+            std::vector<signed_block> blocks;
+            for (uint32_t i = 0; i < 30; ++i) {
+                blocks.push_back(db1.generate_block(db1.get_slot_time(1), db1.get_scheduled_witness(1), init_account_priv_key, database::skip_nothing));
+            }
+
+            db2.add_checkpoints({{10, blocks[9].id()}, {20, blocks[19].id()}});
+            db2.set_checkpoint_trusted_sync(true);
+
+            auto check_irreversible = [&](uint32_t num) {
+                BOOST_CHECK_EQUAL(db2.get_dynamic_global_properties().last_irreversible_block_num, num);
+                if (num) {
+                    BOOST_REQUIRE(db2.get_block_log().head());
+                    BOOST_CHECK_EQUAL(db2.get_block_log().head()->block_num(), num);
+                } else {
+                    BOOST_CHECK(!db2.get_block_log().head());
+                }
+            };
+
+            // a block which doesn't match the checkpoint is rejected
+            auto bad_block = blocks[19];
+            bad_block.timestamp += STEEMIT_BLOCK_INTERVAL;
+            for (uint32_t i = 0; i < 19; ++i) {
+                if (i == 12) {
+                    // a forged block is rejected at once instead of waiting for the checkpoint
+                    auto badly_signed_block = blocks[i];
+                    badly_signed_block.sign(fc::ecc::private_key::regenerate(fc::sha256::hash(std::string("bad"))));
+                    STEEMIT_CHECK_THROW(PUSH_BLOCK(db2, badly_signed_block), fc::exception);
+                    BOOST_CHECK_EQUAL(db2.head_block_num(), i);
+                }
+                PUSH_BLOCK(db2, blocks[i]);
+                // blocks are final only up to the reached checkpoint
+                check_irreversible(i + 1 < 10 ? 0 : 10);
+            }
+
+            // blocks after the reached checkpoint can still be undone
+            db2.pop_block();
+            BOOST_CHECK_EQUAL(db2.head_block_num(), 18);
+            PUSH_BLOCK(db2, blocks[18]);
+            BOOST_CHECK_EQUAL(db2.head_block_num(), 19);
+            check_irreversible(10);
+
+            STEEMIT_CHECK_THROW(PUSH_BLOCK(db2, bad_block), fc::exception);
+            BOOST_CHECK_EQUAL(db2.head_block_num(), 19);
+            check_irreversible(10);
+
+            PUSH_BLOCK(db2, blocks[19]);
+            check_irreversible(20);
+
+            for (uint32_t i = 20; i < 30; ++i) {
+                PUSH_BLOCK(db2, blocks[i]);
+            }
+            BOOST_CHECK(db2.head_block_id() == db1.head_block_id());
+            BOOST_CHECK_GE(db2.get_dynamic_global_properties().last_irreversible_block_num, 20);
+            BOOST_CHECK_GE(db2.get_block_log().head()->block_num(), 20);
+            BOOST_CHECK(db2.fetch_block_by_number(25)->id() == blocks[24].id());
+        } catch (fc::exception &e) {
+            edump((e.to_detail_string()));
+            throw;
+        }
+    }
+
     BOOST_AUTO_TEST_CASE(switch_forks_undo_create) {
         try {
             fc::temp_directory dir1(golos::utilities::temp_directory_path()),
@@ -749,5 +951,183 @@ BOOST_AUTO_TEST_SUITE(block_tests)
         FC_LOG_AND_RETHROW()
     }
 
+    BOOST_FIXTURE_TEST_CASE(authority_cache, clean_database_fixture) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: cached authorities follow modifications and popped blocks");
+            ACTORS((alice))
+            generate_block();
+
+            private_key_type new_key = generate_private_key("new_key");
+
+            auto push = [&](const private_key_type &key, const std::string &metadata) {
+                account_update_operation op;
+                op.account = "alice";
+                op.json_metadata = metadata;
+
+                signed_transaction tx;
+                tx.operations.push_back(op);
+                tx.set_expiration(db->head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+                tx.sign(key, db->get_chain_id());
+                db->push_transaction(tx, 0);
+            };
+
+            push(alice_private_key, "{\"n\":1}");
+            auto stat = db->get_authority_cache_statistics();
+            push(alice_private_key, "{\"n\":2}");
+            BOOST_CHECK_GT(db->get_authority_cache_statistics().hits, stat.hits);
+            BOOST_CHECK_EQUAL(db->get_authority_cache_statistics().misses, stat.misses);
+
+            BOOST_TEST_MESSAGE("--- the modified authority replaces the cached one");
+            auto revision = db->get_authority("alice").revision;
+            account_update_operation op;
+            op.account = "alice";
+            op.active = authority(1, new_key.get_public_key(), 1);
+            op.json_metadata = "{\"n\":3}";
+
+            signed_transaction tx;
+            tx.operations.push_back(op);
+            tx.set_expiration(db->head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+            tx.sign(alice_private_key, db->get_chain_id());
+            db->push_transaction(tx, 0);
+            BOOST_CHECK_EQUAL(db->get_authority("alice").revision, revision + 1);
+
+            push(new_key, "{\"n\":4}");
+            generate_block();
+
+            BOOST_TEST_MESSAGE("--- the popped block restores the old authority");
+            db->pop_block();
+            db->clear_pending();
+            BOOST_CHECK_EQUAL(db->get_authority("alice").revision, revision);
+            GOLOS_CHECK_ERROR_PROPS(push(new_key, "{\"n\":5}"),
+                CHECK_ERROR(tx_missing_active_auth, 0));
+            BOOST_CHECK_NO_THROW(push(alice_private_key, "{\"n\":6}"));
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_FIXTURE_TEST_CASE(transaction_check_threads, clean_database_fixture) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: transactions checked by several threads are applied like serial ones");
+            ACTORS((alice)(bob))
+            generate_block();
+
+            private_key_type new_key = generate_private_key("new_key");
+            private_key_type other_key = generate_private_key("other_key");
+
+            auto make_tx = [&](
+                const std::string &account, const private_key_type &key, const std::string &metadata,
+                const fc::optional<private_key_type> &update = fc::optional<private_key_type>()
+            ) {
+                account_update_operation op;
+                op.account = account;
+                op.json_metadata = metadata;
+                if (update) {
+                    op.owner = authority(1, update->get_public_key(), 1);
+                    op.active = authority(1, update->get_public_key(), 1);
+                }
+
+                signed_transaction tx;
+                tx.operations.push_back(op);
+                tx.set_expiration(db->head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+                tx.sign(key, db->get_chain_id());
+                return tx;
+            };
+
+            auto state = [&]() {
+                std::vector<std::string> result;
+                for (const auto &a: db->get_index<account_index>().indices()) {
+                    result.push_back(fc::json::to_string(a));
+                }
+                for (const auto &a: db->get_index<account_authority_index>().indices()) {
+                    result.push_back(fc::json::to_string(a));
+                }
+                result.push_back(fc::json::to_string(db->get_dynamic_global_properties()));
+                return result;
+            };
+
+            auto generate = [&](uint32_t skip) {
+                return db->generate_block(db->get_slot_time(1), db->get_scheduled_witness(1), init_account_priv_key, skip);
+            };
+
+            BOOST_TEST_MESSAGE("--- the transaction signed by the new key is checked again after the update");
+            db->push_transaction(make_tx("bob", bob_private_key, "{\"n\":1}"), 0);
+            db->push_transaction(make_tx("alice", alice_private_key, "{\"n\":2}", new_key), 0);
+            db->push_transaction(make_tx("alice", new_key, "{\"n\":3}"), 0);
+            auto block = generate(0);
+            BOOST_REQUIRE_EQUAL(block.transactions.size(), 3);
+            auto serial_state = state();
+
+            db->pop_block();
+            db->clear_pending();
+            db->set_transaction_check_threads(4);
+            auto stat = db->get_transaction_check_statistics();
+            BOOST_CHECK(db->push_block(block) == false);
+            BOOST_CHECK(state() == serial_state);
+            BOOST_CHECK_EQUAL(db->get_transaction_check_statistics().checked, stat.checked + 3);
+            BOOST_CHECK_EQUAL(db->get_transaction_check_statistics().passed, stat.passed + 2);
+            BOOST_CHECK_EQUAL(db->get_transaction_check_statistics().failed, stat.failed + 1);
+
+            BOOST_TEST_MESSAGE("--- the transaction signed by the replaced key conflicts with the update");
+            db->set_transaction_check_threads(1);
+            db->push_transaction(make_tx("bob", bob_private_key, "{\"n\":4}"), 0);
+            db->push_transaction(make_tx("alice", new_key, "{\"n\":5}", other_key), 0);
+            db->push_transaction(make_tx("alice", new_key, "{\"n\":6}"), database::skip_authority_check);
+            block = generate(database::skip_authority_check);
+            BOOST_REQUIRE_EQUAL(block.transactions.size(), 3);
+
+            db->pop_block();
+            db->clear_pending();
+            auto head = db->head_block_num();
+            BOOST_CHECK_THROW(db->push_block(block), fc::exception);
+            BOOST_CHECK_EQUAL(db->head_block_num(), head);
+
+            db->set_transaction_check_threads(4);
+            stat = db->get_transaction_check_statistics();
+            BOOST_CHECK_THROW(db->push_block(block), fc::exception);
+            BOOST_CHECK_EQUAL(db->head_block_num(), head);
+            BOOST_CHECK_EQUAL(db->get_transaction_check_statistics().conflicts, stat.conflicts + 1);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_FIXTURE_TEST_CASE(state_digest, database_fixture) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: the kept state digest equals the digest computed from all objects");
+            initialize();
+            db->set_state_digest(true);
+            open_database();
+            startup();
+
+            ACTORS((alice)(bob))
+            generate_block();
+
+            auto check_digest = [&]() {
+                auto kept = db->get_state_digest();
+                auto computed = db->compute_state_digest();
+                BOOST_CHECK_EQUAL(kept.block_num, db->head_block_num());
+                BOOST_CHECK_EQUAL(kept.digest, computed.digest);
+                BOOST_REQUIRE_EQUAL(kept.indexes.size(), computed.indexes.size());
+                for (size_t i = 0; i < kept.indexes.size(); ++i) {
+                    BOOST_CHECK_MESSAGE(kept.indexes[i].digest == computed.indexes[i].digest, kept.indexes[i].name);
+                }
+                return kept;
+            };
+
+            auto before = check_digest();
+            transfer(STEEMIT_INIT_MINER_NAME, "alice", 1000);
+            generate_block();
+            auto after = check_digest();
+            BOOST_CHECK_NE(after.digest, before.digest);
+            BOOST_CHECK_EQUAL(db->get_state_digest(before.block_num).digest, before.digest);
+
+            BOOST_TEST_MESSAGE("--- the popped block restores the digest");
+            db->pop_block();
+            db->clear_pending();
+            BOOST_CHECK_EQUAL(check_digest().digest, before.digest);
+            BOOST_CHECK_THROW(db->get_state_digest(after.block_num), fc::exception);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
 #endif
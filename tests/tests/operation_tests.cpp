@@ -7,6 +7,7 @@
 
 #include <golos/chain/database.hpp>
 #include <golos/chain/hardfork.hpp>
+#include <golos/chain/operation_notification.hpp>
 #include <golos/chain/steem_objects.hpp>
 
 #include <golos/api/account_api_object.hpp>
@@ -24,6 +25,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <algorithm>
+#include <tuple>
 
 using namespace golos;
 using namespace golos::api;
@@ -1191,6 +1193,75 @@ BOOST_FIXTURE_TEST_SUITE(operation_tests, clean_database_fixture)
         FC_LOG_AND_RETHROW()
     }
 
+    BOOST_AUTO_TEST_CASE(vote_notification_objects) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: vote evaluator stores found objects in the operation notification");
+
+            ACTORS((alice)(bob))
+            generate_block();
+
+            vest("alice", ASSET("10.000 GOLOS"));
+            vest("bob", ASSET("10.000 GOLOS"));
+            generate_block();
+
+            using found_objects = std::tuple<const comment_object*, const account_object*, const comment_vote_object*>;
+            std::vector<found_objects> pre_found;
+            std::vector<found_objects> post_found;
+            boost::signals2::scoped_connection pre_connection = db->pre_apply_operation.connect(
+                [&](const operation_notification& note) {
+                    if (note.op.which() == operation::tag<vote_operation>::value) {
+                        pre_found.emplace_back(note.comment, note.account, note.vote);
+                    }
+                });
+            boost::signals2::scoped_connection post_connection = db->post_apply_operation.connect(
+                [&](const operation_notification& note) {
+                    if (note.op.which() == operation::tag<vote_operation>::value) {
+                        post_found.emplace_back(note.comment, note.account, note.vote);
+                    }
+                });
+
+            signed_transaction tx;
+            comment_operation comment_op;
+            comment_op.author = "alice";
+            comment_op.permlink = "foo";
+            comment_op.parent_permlink = "test";
+            comment_op.title = "bar";
+            comment_op.body = "foo bar";
+            push_tx_with_ops(tx, alice_private_key, comment_op);
+
+            vote_operation op;
+            op.voter = "bob";
+            op.author = "alice";
+            op.permlink = "foo";
+            op.weight = STEEMIT_100_PERCENT;
+            push_tx_with_ops(tx, bob_private_key, op);
+
+            const auto& comment = db->get_comment("alice", string("foo"));
+            const auto& vote_idx = db->get_index<comment_vote_index>().indices().get<by_comment_voter>();
+            const auto* vote = &*vote_idx.find(std::make_tuple(comment.id, bob.id));
+
+            BOOST_REQUIRE_EQUAL(pre_found.size(), 1);
+            BOOST_REQUIRE_EQUAL(post_found.size(), 1);
+            BOOST_CHECK(pre_found[0] == found_objects(nullptr, nullptr, nullptr));
+            BOOST_CHECK(post_found[0] == found_objects(&comment, &bob, vote));
+
+            BOOST_TEST_MESSAGE("--- changed vote");
+            generate_blocks(db->head_block_time() + STEEMIT_MIN_VOTE_INTERVAL_SEC);
+            pre_found.clear();
+            post_found.clear();
+
+            op.weight = 50 * STEEMIT_1_PERCENT;
+            push_tx_with_ops(tx, bob_private_key, op);
+
+            // objects of the pending transactions are created again in the block
+            const auto& block_comment = db->get_comment("alice", string("foo"));
+            vote = &*vote_idx.find(std::make_tuple(block_comment.id, bob.id));
+            BOOST_REQUIRE_EQUAL(post_found.size(), 1);
+            BOOST_CHECK(post_found[0] == found_objects(&block_comment, &bob, vote));
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
     BOOST_AUTO_TEST_CASE(transfer_validate) {
         try {
             BOOST_TEST_MESSAGE("Testing: transfer_validate");
@@ -6,6 +6,7 @@
 #include <golos/chain/block_summary_object.hpp>
 #include <golos/chain/database.hpp>
 #include <golos/chain/hardfork.hpp>
+#include <golos/chain/operation_notification.hpp>
 #include <golos/chain/steem_objects.hpp>
 #include <golos/plugins/account_history/history_object.hpp>
 #include <golos/plugins/debug_node/plugin.hpp>
@@ -803,6 +804,150 @@ BOOST_FIXTURE_TEST_SUITE(operation_time_tests, clean_database_fixture)
         FC_LOG_AND_RETHROW()
     }
 
+    BOOST_AUTO_TEST_CASE(comment_cashout_batch) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: batched cashout pays the same rewards as one-by-one cashout");
+            ACTORS((alice)(bob)(sam)(dave))
+            generate_block();
+
+            std::vector<std::pair<std::string, fc::ecc::private_key>> actors = {
+                {"alice", alice_private_key}, {"bob", bob_private_key}, {"sam", sam_private_key}, {"dave", dave_private_key}};
+
+            for (const auto &a: actors) {
+                fund(a.first, 10000);
+                vest(a.first, 10000);
+            }
+            set_price_feed(price(ASSET("1.000 GOLOS"), ASSET("1.000 GBG")));
+
+            // every actor posts and the others vote for the post, so all posts are paid out in the same block
+            signed_transaction tx;
+            for (const auto &author: actors) {
+                comment_operation comment;
+                comment.author = author.first;
+                comment.permlink = "test";
+                comment.parent_permlink = "test";
+                comment.title = "test";
+                comment.body = "foobar";
+                tx.operations.push_back(comment);
+
+                for (const auto &voter: actors) {
+                    if (voter.first == author.first) {
+                        continue;
+                    }
+                    vote_operation vote;
+                    vote.voter = voter.first;
+                    vote.author = author.first;
+                    vote.permlink = "test";
+                    vote.weight = STEEMIT_100_PERCENT / (1 + (voter.first.size() % 3));
+                    tx.operations.push_back(vote);
+                }
+            }
+            tx.set_expiration(db->head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+            for (const auto &a: actors) {
+                tx.sign(a.second, db->get_chain_id());
+            }
+            db->push_transaction(tx, 0);
+            generate_block();
+
+            generate_blocks(db->get_comment("alice", string("test")).cashout_time - STEEMIT_BLOCK_INTERVAL);
+            BOOST_REQUIRE(db->get_comment("dave", string("test")).cashout_time ==
+                db->get_comment("alice", string("test")).cashout_time);
+
+            std::vector<std::string> virtual_ops;
+            boost::signals2::scoped_connection connection = db->post_apply_operation.connect(
+                [&](const operation_notification &note) {
+                    if (is_virtual_operation(note.op)) {
+                        virtual_ops.push_back(fc::json::to_string(note.op));
+                    }
+                });
+
+            auto state = [&]() {
+                std::vector<std::string> result;
+                for (const auto &a: actors) {
+                    result.push_back(fc::json::to_string(db->get_account(a.first)));
+                }
+                for (const auto &c: db->get_index<comment_index>().indices()) {
+                    result.push_back(fc::json::to_string(c));
+                }
+                for (const auto &v: db->get_index<comment_vote_index>().indices()) {
+                    result.push_back(fc::json::to_string(v));
+                }
+                result.push_back(fc::json::to_string(db->get_dynamic_global_properties()));
+                return result;
+            };
+
+            db->set_comment_cashout_threads(1);
+            generate_block();
+            auto serial_state = state();
+            auto serial_ops = virtual_ops;
+            BOOST_REQUIRE(std::count_if(serial_ops.begin(), serial_ops.end(), [](const std::string &op) {
+                return op.find("curation_reward") != std::string::npos;
+            }) >= 4);
+
+            db->pop_block();
+            virtual_ops.clear();
+
+            db->set_comment_cashout_threads(4);
+            generate_block();
+            BOOST_CHECK(state() == serial_state);
+            BOOST_CHECK(virtual_ops == serial_ops);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
+    BOOST_AUTO_TEST_CASE(maintenance_scheduler) {
+        try {
+            BOOST_TEST_MESSAGE("Testing: maintenance tasks are skipped until their deadlines");
+            ACTORS((alice))
+            fund("alice", 10000);
+            generate_block();
+
+            auto orders_task = [&]() {
+                for (const auto &t: db->get_maintenance_statistics()) {
+                    if (t.name == "clear_expired_orders") {
+                        return t;
+                    }
+                }
+                BOOST_FAIL("clear_expired_orders task is not registered");
+                return maintenance_task_statistics();
+            };
+
+            auto expiration = db->head_block_time() + fc::seconds(60);
+
+            limit_order_create_operation op;
+            op.owner = "alice";
+            op.orderid = 1;
+            op.amount_to_sell = ASSET("1.000 GOLOS");
+            op.min_to_receive = ASSET("1.000 GBG");
+            op.expiration = expiration;
+
+            signed_transaction tx;
+            tx.operations.push_back(op);
+            tx.set_expiration(db->head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+            tx.sign(alice_private_key, db->get_chain_id());
+            db->push_transaction(tx, 0);
+            generate_block();
+
+            BOOST_CHECK(orders_task().deadline == expiration);
+            auto skips = orders_task().skips;
+
+            generate_blocks(expiration);
+            BOOST_CHECK(db->find_limit_order("alice", 1) != nullptr);
+            BOOST_CHECK_GT(orders_task().skips, skips);
+
+            generate_block();
+            BOOST_CHECK(db->find_limit_order("alice", 1) == nullptr);
+            BOOST_CHECK(orders_task().deadline == fc::time_point_sec::maximum());
+
+            BOOST_TEST_MESSAGE("--- the restored order is expired again after the block is popped");
+            db->pop_block();
+            BOOST_REQUIRE(db->find_limit_order("alice", 1) != nullptr);
+            generate_block();
+            BOOST_CHECK(db->find_limit_order("alice", 1) == nullptr);
+        }
+        FC_LOG_AND_RETHROW()
+    }
+
     BOOST_AUTO_TEST_CASE(vesting_withdrawals) {
         try {
             ACTORS((alice))
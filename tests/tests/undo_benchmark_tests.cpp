@@ -0,0 +1,142 @@
+#ifdef STEEMIT_BUILD_TESTNET
+
+#include <boost/test/unit_test.hpp>
+
+#include <golos/chain/database.hpp>
+#include <golos/chain/steem_objects.hpp>
+
+#include "database_fixture.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace golos;
+using namespace golos::chain;
+using namespace golos::protocol;
+using std::string;
+
+/**
+ *  Apply time and undo state volume of comment- and vote-heavy blocks. Transactions are pushed one by one, each
+ *  in its own undo session, then the block is generated and pushed, which applies them twice more. It's the
+ *  baseline for changes of the undo mechanism. Results are printed with --log_level=message.
+ */
+BOOST_FIXTURE_TEST_SUITE(undo_benchmark, clean_database_fixture)
+
+// These tests are too slow without optimizations. Disable them when we build in debug
+#ifndef DEBUG
+    BOOST_AUTO_TEST_CASE(undo_volume_of_comment_and_vote_blocks) {
+        try {
+            const uint32_t accounts = 100;
+            const uint32_t rounds = 3;
+            const uint32_t skip = database::skip_transaction_signatures | database::skip_authority_check;
+
+            resize_shared_mem(1024 * 1024 * 64);
+
+            std::vector<string> names;
+            for (uint32_t i = 0; i < accounts; ++i) {
+                names.push_back("author" + std::to_string(i));
+                account_create(names.back(), generate_private_key(names.back()).get_public_key());
+                vest(names.back(), ASSET("10.000 GOLOS"));
+                if (i % 50 == 49) {
+                    generate_block();
+                }
+            }
+            generate_block();
+
+            db->set_undo_profiling(true);
+            db->reset_undo_statistics();
+
+            double push_seconds = 0;
+            double block_seconds = 0;
+            uint32_t ops = 0;
+
+            auto push_block_of = [&](const std::vector<signed_transaction>& txs) {
+                auto start = std::chrono::steady_clock::now();
+                for (const auto& tx: txs) {
+                    db->push_transaction(tx, skip);
+                }
+                auto pushed = std::chrono::steady_clock::now();
+                generate_block();
+                auto end = std::chrono::steady_clock::now();
+
+                push_seconds += std::chrono::duration<double>(pushed - start).count();
+                block_seconds += std::chrono::duration<double>(end - pushed).count();
+                ops += txs.size();
+            };
+
+            auto report = [&](const string& name, const string& operation) {
+                auto stats = db->get_undo_statistics();
+                for (const auto& s: stats) {
+                    if (s.operation != operation && s.operation != "block") {
+                        continue;
+                    }
+                    BOOST_TEST_MESSAGE(name << ": " << s.operation << " x " << s.count
+                        << ", modified " << s.modified << ", removed " << s.removed
+                        << ", undo copies " << s.copied << " (" << s.copied_size << " bytes)");
+                    if (s.operation == operation) {
+                        BOOST_CHECK_GT(s.copied, 0u);
+                    }
+                }
+                BOOST_TEST_MESSAGE(name << ": " << ops << " ops, "
+                    << uint64_t(ops / push_seconds) << " ops/s pushed, "
+                    << uint64_t(ops / block_seconds) << " ops/s in blocks");
+                push_seconds = 0;
+                block_seconds = 0;
+                ops = 0;
+                db->reset_undo_statistics();
+            };
+
+            BOOST_TEST_MESSAGE("--- comment blocks");
+            for (uint32_t r = 0; r < rounds; ++r) {
+                std::vector<signed_transaction> txs;
+                for (const auto& author: names) {
+                    comment_operation op;
+                    op.author = author;
+                    op.permlink = "post" + std::to_string(r);
+                    op.parent_permlink = "test";
+                    op.title = "title";
+                    op.body = string(1024, 'a' + r);
+
+                    signed_transaction tx;
+                    tx.operations.push_back(op);
+                    tx.set_expiration(db->head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+                    txs.push_back(tx);
+                }
+                push_block_of(txs);
+                generate_blocks(db->head_block_time() + STEEMIT_MIN_ROOT_COMMENT_INTERVAL + STEEMIT_BLOCK_INTERVAL);
+            }
+            report("comment blocks", "comment_operation");
+
+            const auto& mprops = db->get_witness_schedule_object().median_props;
+            const auto vote_interval = mprops.votes_window / mprops.votes_per_window + STEEMIT_BLOCK_INTERVAL;
+
+            BOOST_TEST_MESSAGE("--- vote blocks");
+            for (uint32_t r = 0; r < rounds; ++r) {
+                std::vector<signed_transaction> txs;
+                for (const auto& voter: names) {
+                    vote_operation op;
+                    op.voter = voter;
+                    op.author = names[r];
+                    op.permlink = "post0";
+                    op.weight = STEEMIT_100_PERCENT;
+
+                    signed_transaction tx;
+                    tx.operations.push_back(op);
+                    tx.set_expiration(db->head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+                    txs.push_back(tx);
+                }
+                push_block_of(txs);
+                generate_blocks(db->head_block_time() + vote_interval);
+            }
+            report("vote blocks", "vote_operation");
+
+            db->set_undo_profiling(false);
+            validate_database();
+        }
+        FC_LOG_AND_RETHROW()
+    }
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif
@@ -0,0 +1,129 @@
+#ifdef STEEMIT_BUILD_TESTNET
+
+#include <boost/test/unit_test.hpp>
+
+#include <golos/chain/database.hpp>
+#include <golos/chain/steem_objects.hpp>
+
+#include "database_fixture.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace golos;
+using namespace golos::chain;
+using namespace golos::protocol;
+using std::string;
+
+/**
+ *  Throughput of vote_operation with the plugins of the test fixture. Signatures aren't checked, so the evaluator
+ *  and handlers of notifications are measured. Results are printed with --log_level=message.
+ */
+BOOST_FIXTURE_TEST_SUITE(vote_benchmark, clean_database_fixture)
+
+// These tests are too slow without optimizations. Disable them when we build in debug
+#ifndef DEBUG
+    BOOST_AUTO_TEST_CASE(vote_throughput) {
+        try {
+            const uint32_t voters = 100;
+            const uint32_t comments = 10;
+            const uint32_t skip = database::skip_transaction_signatures | database::skip_authority_check;
+
+            resize_shared_mem(1024 * 1024 * 64);
+
+            std::vector<string> names;
+            for (uint32_t i = 0; i < voters; ++i) {
+                names.push_back("voter" + std::to_string(i));
+                account_create(names.back(), generate_private_key(names.back()).get_public_key());
+                vest(names.back(), ASSET("10.000 GOLOS"));
+                if (i % 50 == 49) {
+                    generate_block();
+                }
+            }
+            generate_block();
+
+            // each comment has its own author, so root post intervals don't matter
+            for (uint32_t i = 0; i < comments; ++i) {
+                comment_operation op;
+                op.author = names[i];
+                op.permlink = "post";
+                op.parent_permlink = "test";
+                op.title = "title";
+                op.body = "body";
+
+                signed_transaction tx;
+                tx.operations.push_back(op);
+                tx.set_expiration(db->head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+                db->push_transaction(tx, skip);
+            }
+            generate_block();
+
+            const auto& mprops = db->get_witness_schedule_object().median_props;
+            const auto vote_interval = mprops.votes_window / mprops.votes_per_window + STEEMIT_BLOCK_INTERVAL;
+
+            double push_seconds = 0;
+            double block_seconds = 0;
+            uint32_t votes = 0;
+
+            auto vote_round = [&](const string& author, int16_t weight) {
+                std::vector<signed_transaction> txs;
+                for (const auto& voter: names) {
+                    vote_operation op;
+                    op.voter = voter;
+                    op.author = author;
+                    op.permlink = "post";
+                    op.weight = weight;
+
+                    signed_transaction tx;
+                    tx.operations.push_back(op);
+                    tx.set_expiration(db->head_block_time() + STEEMIT_MAX_TIME_UNTIL_EXPIRATION);
+                    txs.push_back(tx);
+                }
+
+                auto start = std::chrono::steady_clock::now();
+                for (const auto& tx: txs) {
+                    db->push_transaction(tx, skip);
+                }
+                auto pushed = std::chrono::steady_clock::now();
+                generate_block();
+                auto end = std::chrono::steady_clock::now();
+
+                push_seconds += std::chrono::duration<double>(pushed - start).count();
+                block_seconds += std::chrono::duration<double>(end - pushed).count();
+                votes += txs.size();
+
+                generate_blocks(db->head_block_time() + vote_interval);
+            };
+
+            auto report = [&](const string& name) {
+                BOOST_TEST_MESSAGE(name << ": " << votes << " votes, "
+                    << uint64_t(votes / push_seconds) << " ops/s pushed, "
+                    << uint64_t(votes / block_seconds) << " ops/s in blocks");
+                push_seconds = 0;
+                block_seconds = 0;
+                votes = 0;
+            };
+
+            BOOST_TEST_MESSAGE("--- new votes");
+            for (uint32_t i = 0; i < comments; ++i) {
+                vote_round(names[i], STEEMIT_100_PERCENT);
+            }
+            report("new votes");
+
+            BOOST_TEST_MESSAGE("--- changed votes");
+            for (uint32_t i = 0; i < comments; ++i) {
+                vote_round(names[i], 50 * STEEMIT_1_PERCENT);
+            }
+            report("changed votes");
+
+            const auto& vote_idx = db->get_index<comment_vote_index>().indices();
+            BOOST_CHECK_EQUAL(vote_idx.size(), voters * comments);
+            validate_database();
+        }
+        FC_LOG_AND_RETHROW()
+    }
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
+#endif